@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench_bases.h"
+#include "../Database/text_reading.h"
+#include "../Libs/file_reading.hpp"
+#include "../Libs/text_buffer.h"
+
+static void append_balanced(Text_buffer *buffer, size_t depth, size_t *n_questions, size_t *n_characters);
+
+static bool finish_base(Bench_base *base, const char *name, Text_buffer *buffer);
+
+
+bool make_balanced_base(Bench_base *base, const char *name, size_t depth) {
+    assert(base != nullptr);
+    assert(name != nullptr);
+
+    Text_buffer buffer = {};
+
+    size_t n_questions  = 0;
+    size_t n_characters = 0;
+
+    append_balanced(&buffer, depth, &n_questions, &n_characters);
+
+    return finish_base(base, name, &buffer);
+}
+
+bool make_degenerate_base(Bench_base *base, const char *name, size_t depth) {
+    assert(base != nullptr);
+    assert(name != nullptr);
+
+    Text_buffer buffer = {};
+
+    for (size_t i = 0; i < depth; ++i) {
+        buffer_printf(&buffer, "{ \"question %zu\"\n{ \"character %zu\" }\n", i, i);
+    }
+
+    buffer_printf(&buffer, "{ \"character %zu\" }\n", depth);
+
+    for (size_t i = 0; i < depth; ++i) {
+        buffer_append(&buffer, " }\n", sizeof(" }\n") - 1);
+    }
+
+    return finish_base(base, name, &buffer);
+}
+
+void bench_base_dtor(Bench_base *base) {
+    assert(base != nullptr);
+
+    unmap_file(base->text, base->size);
+
+    base->name = nullptr;
+    base->text = nullptr;
+    base->size = 0;
+}
+
+char* copy_base_text(const Bench_base *base) {
+    assert(base       != nullptr);
+    assert(base->text != nullptr);
+
+    char *text = map_anonymous(base->size);
+
+    if (text != nullptr) {
+        memcpy(text, base->text, base->size);
+    }
+
+    return text;
+}
+
+char* load_bench_tree(Tree *tree, const Bench_base *base, size_t n_threads) {
+    assert(tree != nullptr);
+    assert(base != nullptr);
+
+    char *text = copy_base_text(base);
+
+    if (text == nullptr || real_tree_init(tree, __FILE__, __PRETTY_FUNCTION__, __LINE__) != NO_TREE_ERR) {
+        unmap_file(text, base->size);
+        return nullptr;
+    }
+
+    if (!set_tree_text(tree, text, base->size) || !read_text_tree_parallel(tree, text, n_threads)) {
+        tree_dtor(tree);
+        unmap_file(text, base->size);
+        return nullptr;
+    }
+
+    return text;
+}
+
+double get_seconds() {
+    struct timespec now = {};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+// Depth of balanced bases is small, so they are written recursively
+
+static void append_balanced(Text_buffer *buffer, size_t depth, size_t *n_questions, size_t *n_characters) {
+    assert(buffer       != nullptr);
+    assert(n_questions  != nullptr);
+    assert(n_characters != nullptr);
+
+    if (depth == 0) {
+        buffer_printf(buffer, "{ \"character %zu\" }\n", (*n_characters)++);
+        return;
+    }
+
+    buffer_printf(buffer, "{ \"question %zu\"\n", (*n_questions)++);
+
+    append_balanced(buffer, depth - 1, n_questions, n_characters);
+    append_balanced(buffer, depth - 1, n_questions, n_characters);
+
+    buffer_append(buffer, " }\n", sizeof(" }\n") - 1);
+}
+
+// Text is moved to mapped memory, so scanning can read it by whole vectors as a mapped file
+
+static bool finish_base(Bench_base *base, const char *name, Text_buffer *buffer) {
+    assert(base   != nullptr);
+    assert(name   != nullptr);
+    assert(buffer != nullptr);
+
+    base->name = name;
+    base->size = buffer->size;
+    base->text = buffer->is_ok ? map_anonymous(buffer->size) : nullptr;
+
+    if (base->text != nullptr) {
+        memcpy(base->text, buffer->data, buffer->size);
+    }
+
+    text_buffer_dtor(buffer);
+
+    return base->text != nullptr;
+}
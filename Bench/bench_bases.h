@@ -0,0 +1,40 @@
+#ifndef BENCH_BASES
+#define BENCH_BASES
+
+#include <stddef.h>
+
+#include "../Tree/tree.h"
+
+// Data bases generated for benchmarks in the same text format as files.
+// Every question and character has its own text, so interning doesn't
+// merge them. Text is mapped like a file, with '\0' after its end.
+
+struct Bench_base {
+    const char* name = nullptr;
+    char*       text = nullptr;
+    size_t      size = 0;
+};
+
+// Balanced base: every path has depth questions, 2^depth characters
+
+bool make_balanced_base(Bench_base *base, const char *name, size_t depth);
+
+// Degenerate base: every question has a character as its left child
+// and the next question as its right one
+
+bool make_degenerate_base(Bench_base *base, const char *name, size_t depth);
+
+void bench_base_dtor(Bench_base *base);
+
+// Reading ends texts with '\0' in place, so every run reads its own copy.
+// Copy is freed by unmap_file().
+
+char* copy_base_text(const Bench_base *base);
+
+// Tree is made from the copy of base, nullptr is returned if base can't be read
+
+char* load_bench_tree(Tree *tree, const Bench_base *base, size_t n_threads);
+
+double get_seconds();
+
+#endif
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "bench_bases.h"
+#include "../Libs/file_reading.hpp"
+
+// Throughput of text data base dump: buffered dump without recursion against
+// the recursive fprintf() dump it replaced, which is kept here as a reference.
+// Both write to /dev/null, so only the work of dumper is measured. Dump is
+// also compared with the base it was read from. Run by `make bench`.
+
+typedef bool (*Dumper)(Tree *tree, FILE *output);
+
+struct Compared_dump {
+    const Bench_base* base   = nullptr;
+    size_t            offset = 0;
+};
+
+static bool dump_recursively(Tree *tree, FILE *output);
+
+static void dump_node(Tree *tree, Node_id node, FILE *output);
+
+static double time_dumper(Tree *tree, FILE *output, Dumper dumper);
+
+static bool compare_dump(void *context, const char *data, size_t len);
+
+
+static const size_t Max_recursive_depth = 20000;
+static const size_t Runs_per_dumper     = 3;
+
+
+int main() {
+    FILE *output = fopen("/dev/null", "w");
+
+    if (output == nullptr) {
+        printf("Error: can't open /dev/null\n");
+        return 1;
+    }
+
+    Bench_base bases[3] = {};
+
+    size_t depths[3] = {20, Max_recursive_depth, 1000000};
+
+    bool is_ok = make_balanced_base  (&bases[0], "balanced",   depths[0]) &&
+                 make_degenerate_base(&bases[1], "degenerate", depths[1]) &&
+                 make_degenerate_base(&bases[2], "degenerate", depths[2]);
+
+    if (is_ok) {
+        printf("%-12s %8s %9s %22s %22s\n", "base", "depth", "size, MB", "recursive", "buffered");
+    }
+
+    for (size_t i = 0; is_ok && i < 3; ++i) {
+        Tree tree = {};
+
+        char *text = load_bench_tree(&tree, &bases[i], 1);
+
+        if (text == nullptr) {
+            is_ok = false;
+            break;
+        }
+
+        Compared_dump compared = {&bases[i], 0};
+
+        if (!text_database_write(&tree, compare_dump, &compared) || compared.offset != bases[i].size) {
+            printf("Error: dump of %s base differs from it\n", bases[i].name);
+            is_ok = false;
+        }
+
+        double size = (double) bases[i].size / (1 << 20);
+
+        printf("%-12s %8zu %9.1f ", bases[i].name, depths[i], size);
+
+        if (depths[i] <= Max_recursive_depth) {
+            double recursive_time = time_dumper(&tree, output, dump_recursively);
+
+            printf("%9.3f s %6.0f MB/s ", recursive_time, size / recursive_time);
+
+        } else {
+            printf("%22s ", "stack overflow");
+        }
+
+        double buffered_time = time_dumper(&tree, output, text_database_dump);
+
+        printf("%9.3f s %6.0f MB/s\n", buffered_time, size / buffered_time);
+
+        is_ok &= (buffered_time > 0);
+
+        tree_dtor(&tree);
+        unmap_file(text, bases[i].size);
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        bench_base_dtor(&bases[i]);
+    }
+
+    fclose(output);
+
+    if (!is_ok) {
+        printf("Error: benchmark failed\n");
+    }
+
+    return is_ok ? 0 : 1;
+}
+
+static bool dump_recursively(Tree *tree, FILE *output) {
+    assert(tree   != nullptr);
+    assert(output != nullptr);
+
+    dump_node(tree, tree->head, output);
+
+    return fflush(output) == 0;
+}
+
+static void dump_node(Tree *tree, Node_id node, FILE *output) {
+    assert(tree   != nullptr);
+    assert(output != nullptr);
+
+    fprintf(output, "{ \"%s\"", node_text(tree, node));
+
+    if (!is_leaf(tree, node)) {
+        fprintf(output, "\n");
+        dump_node(tree, node_left (tree, node), output);
+        dump_node(tree, node_right(tree, node), output);
+    }
+
+    fprintf(output, " }\n");
+}
+
+// The best time of several runs, negative if dump failed
+
+static double time_dumper(Tree *tree, FILE *output, Dumper dumper) {
+    assert(tree   != nullptr);
+    assert(output != nullptr);
+    assert(dumper != nullptr);
+
+    double best = -1;
+
+    for (size_t run = 0; run < Runs_per_dumper; ++run) {
+        double start = get_seconds();
+
+        if (!dumper(tree, output)) {
+            return -1;
+        }
+
+        double time = get_seconds() - start;
+
+        if (best < 0 || time < best) {
+            best = time;
+        }
+    }
+
+    return best;
+}
+
+static bool compare_dump(void *context, const char *data, size_t len) {
+    assert(context != nullptr);
+    assert(data    != nullptr);
+
+    Compared_dump *compared = (Compared_dump*) context;
+
+    const Bench_base *base = compared->base;
+
+    if (len > base->size - compared->offset || memcmp(base->text + compared->offset, data, len) != 0) {
+        return false;
+    }
+
+    compared->offset += len;
+
+    return true;
+}
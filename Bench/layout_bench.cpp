@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <malloc.h>
+
+#include "bench_bases.h"
+#include "../Libs/file_reading.hpp"
+
+// Memory and traversal speed of tree nodes: 16 byte nodes linked by ids
+// against 40 byte nodes linked by pointers they replaced, which are kept
+// here as a reference. Reference nodes are allocated one by one in preorder,
+// as the old reader did. Memory of reference nodes is what malloc() took for
+// them, texts are shared by both trees and are not counted. Walk time is
+// given per node. Run by `make bench`.
+
+struct Pointer_node {
+    bool          is_saved    = false;
+    bool          is_deferred = false;
+    const char*   data        = nullptr;
+    Pointer_node* right       = nullptr;
+    Pointer_node* left        = nullptr;
+    Pointer_node* parent      = nullptr;
+};
+
+static Pointer_node* copy_to_pointers(const Tree *tree, size_t *memory);
+
+static void free_pointers(Pointer_node *head, size_t n_nodes);
+
+static size_t walk_ids(const Tree *tree, Node_id *stack);
+
+static size_t walk_pointers(Pointer_node *head, Pointer_node **stack);
+
+static double time_walks(const Tree *tree, Pointer_node *head, size_t *n_leaves, bool by_ids);
+
+
+static const size_t Runs_per_walk = 5;
+
+
+int main() {
+    Bench_base bases[3] = {};
+
+    size_t depths[3] = {16, 21, 1000000};
+
+    bool is_ok = make_balanced_base  (&bases[0], "balanced",   depths[0]) &&
+                 make_balanced_base  (&bases[1], "balanced",   depths[1]) &&
+                 make_degenerate_base(&bases[2], "degenerate", depths[2]);
+
+    if (is_ok) {
+        printf("%-12s %8s %9s %14s %14s %14s %14s\n", "base", "depth", "nodes",
+               "pointers, MB", "ids, MB", "pointers, ns", "ids, ns");
+    }
+
+    for (size_t i = 0; is_ok && i < 3; ++i) {
+        Tree tree = {};
+
+        char *text = load_bench_tree(&tree, &bases[i], 1);
+
+        if (text == nullptr) {
+            is_ok = false;
+            break;
+        }
+
+        size_t n_nodes = tree.n_nodes - 1;
+
+        size_t pointers_memory = 0;
+
+        Pointer_node *head = copy_to_pointers(&tree, &pointers_memory);
+
+        if (head != nullptr) {
+            size_t pointer_leaves = 0;
+            size_t id_leaves      = 0;
+
+            double pointers_time = time_walks(&tree, head, &pointer_leaves, false);
+            double ids_time      = time_walks(&tree, head, &id_leaves,      true);
+
+            is_ok = pointers_time > 0 && ids_time > 0 && pointer_leaves == id_leaves;
+
+            double ids_memory = (double) (n_nodes * sizeof(Tree_node)) / (1 << 20);
+
+            printf("%-12s %8zu %9zu %14.1f %14.1f %14.2f %14.2f\n", bases[i].name, depths[i], n_nodes,
+                   (double) pointers_memory / (1 << 20), ids_memory,
+                   pointers_time * 1e9 / (double) n_nodes, ids_time * 1e9 / (double) n_nodes);
+
+            free_pointers(head, n_nodes);
+
+        } else {
+            is_ok = false;
+        }
+
+        tree_dtor(&tree);
+        unmap_file(text, bases[i].size);
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        bench_base_dtor(&bases[i]);
+    }
+
+    if (!is_ok) {
+        printf("Error: benchmark failed\n");
+    }
+
+    return is_ok ? 0 : 1;
+}
+
+// Nodes are copied in preorder, so consecutive allocations go to
+// consecutive nodes as in the old reader
+
+static Pointer_node* copy_to_pointers(const Tree *tree, size_t *memory) {
+    assert(tree   != nullptr);
+    assert(memory != nullptr);
+
+    Node_id *stack = (Node_id*) calloc(tree->n_nodes, sizeof(Node_id));
+
+    Pointer_node **copies = (Pointer_node**) calloc(tree->n_nodes, sizeof(Pointer_node*));
+
+    if (stack == nullptr || copies == nullptr) {
+        free(stack);
+        free(copies);
+        return nullptr;
+    }
+
+    size_t allocated = mallinfo2().uordblks;
+
+    size_t n_stacked = 0;
+    bool   is_ok     = true;
+
+    stack[n_stacked++] = tree->head;
+
+    while (n_stacked > 0 && is_ok) {
+        Node_id node = stack[--n_stacked];
+
+        Pointer_node *copy = (Pointer_node*) calloc(1, sizeof(Pointer_node));
+
+        if (copy == nullptr) {
+            is_ok = false;
+            break;
+        }
+
+        copy->data     = node_text(tree, node);
+        copy->is_saved = is_saved(tree, node);
+
+        Node_id parent = node_parent(tree, node);
+
+        if (parent != No_node) {
+            copy->parent = copies[parent];
+
+            if (is_left_child(tree, node)) {
+                copies[parent]->left  = copy;
+            } else {
+                copies[parent]->right = copy;
+            }
+        }
+
+        copies[node] = copy;
+
+        if (!is_leaf(tree, node)) {
+            stack[n_stacked++] = node_right(tree, node);
+            stack[n_stacked++] = node_left (tree, node);
+        }
+    }
+
+    *memory = mallinfo2().uordblks - allocated;
+
+    Pointer_node *head = copies[tree->head];
+
+    free(stack);
+    free(copies);
+
+    if (!is_ok) {
+        free_pointers(head, tree->n_nodes);
+        return nullptr;
+    }
+
+    return head;
+}
+
+static void free_pointers(Pointer_node *head, size_t n_nodes) {
+    Pointer_node **stack = (Pointer_node**) calloc(n_nodes, sizeof(Pointer_node*));
+
+    if (stack == nullptr || head == nullptr) {
+        free(stack);
+        return;
+    }
+
+    size_t n_stacked = 0;
+
+    stack[n_stacked++] = head;
+
+    while (n_stacked > 0) {
+        Pointer_node *node = stack[--n_stacked];
+
+        if (node->left  != nullptr) stack[n_stacked++] = node->left;
+        if (node->right != nullptr) stack[n_stacked++] = node->right;
+
+        free(node);
+    }
+
+    free(stack);
+}
+
+// Both walks visit nodes in preorder and count leaves, as find_node() does
+// for a name which is not in the tree
+
+static size_t walk_ids(const Tree *tree, Node_id *stack) {
+    assert(tree  != nullptr);
+    assert(stack != nullptr);
+
+    size_t n_stacked = 0;
+    size_t n_leaves  = 0;
+
+    stack[n_stacked++] = tree->head;
+
+    while (n_stacked > 0) {
+        Node_id node = stack[--n_stacked];
+
+        if (is_leaf(tree, node)) {
+            ++n_leaves;
+            continue;
+        }
+
+        stack[n_stacked++] = node_right(tree, node);
+        stack[n_stacked++] = node_left (tree, node);
+    }
+
+    return n_leaves;
+}
+
+static size_t walk_pointers(Pointer_node *head, Pointer_node **stack) {
+    assert(head  != nullptr);
+    assert(stack != nullptr);
+
+    size_t n_stacked = 0;
+    size_t n_leaves  = 0;
+
+    stack[n_stacked++] = head;
+
+    while (n_stacked > 0) {
+        Pointer_node *node = stack[--n_stacked];
+
+        if (node->left == nullptr || node->right == nullptr) {
+            ++n_leaves;
+            continue;
+        }
+
+        stack[n_stacked++] = node->right;
+        stack[n_stacked++] = node->left;
+    }
+
+    return n_leaves;
+}
+
+// The best time of several walks, negative if there is no memory for stack
+
+static double time_walks(const Tree *tree, Pointer_node *head, size_t *n_leaves, bool by_ids) {
+    assert(tree     != nullptr);
+    assert(head     != nullptr);
+    assert(n_leaves != nullptr);
+
+    void *stack = calloc(tree->n_nodes, by_ids ? sizeof(Node_id) : sizeof(Pointer_node*));
+
+    if (stack == nullptr) {
+        return -1;
+    }
+
+    double best = -1;
+
+    for (size_t run = 0; run < Runs_per_walk; ++run) {
+        double start = get_seconds();
+
+        *n_leaves = by_ids ? walk_ids(tree, (Node_id*) stack) : walk_pointers(head, (Pointer_node**) stack);
+
+        double time = get_seconds() - start;
+
+        if (best < 0 || time < best) {
+            best = time;
+        }
+    }
+
+    free(stack);
+
+    return best;
+}
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <assert.h>
+
+#include "bench_bases.h"
+#include "../Database/text_reading.h"
+#include "../Libs/file_reading.hpp"
+#include "../Libs/scanning.h"
+
+// Load throughput of text data base: parser without recursion against the
+// recursive one it replaced, which is kept here as a reference. Recursive
+// parser is not run on bases deeper than Max_recursive_depth, it overflows
+// the native stack there. Run by `make bench`.
+
+typedef bool (*Parser)(Tree *tree, char *text);
+
+static bool read_recursively(Tree *tree, char *text);
+
+static bool read_node(Tree *tree, char *text, size_t *ip, Node_id parent);
+
+static double time_parser(const Bench_base *base, Parser parser);
+
+
+static const size_t Max_recursive_depth = 20000;
+static const size_t Runs_per_parser     = 3;
+
+
+int main() {
+    Bench_base bases[4] = {};
+
+    size_t depths[4] = {16, 20, Max_recursive_depth, 1000000};
+
+    if (!make_balanced_base  (&bases[0], "balanced",   depths[0]) ||
+        !make_balanced_base  (&bases[1], "balanced",   depths[1]) ||
+        !make_degenerate_base(&bases[2], "degenerate", depths[2]) ||
+        !make_degenerate_base(&bases[3], "degenerate", depths[3])) {
+        printf("Error: not enought memory\n");
+
+        for (size_t i = 0; i < 4; ++i) {
+            bench_base_dtor(&bases[i]);
+        }
+
+        return 1;
+    }
+
+    printf("%-12s %8s %9s %22s %22s\n", "base", "depth", "size, MB", "recursive", "loop");
+
+    bool is_ok = true;
+
+    for (size_t i = 0; i < 4; ++i) {
+        double size = (double) bases[i].size / (1 << 20);
+
+        double loop_time = time_parser(&bases[i], read_text_tree);
+
+        printf("%-12s %8zu %9.1f ", bases[i].name, depths[i], size);
+
+        if (depths[i] <= Max_recursive_depth) {
+            double recursive_time = time_parser(&bases[i], read_recursively);
+
+            printf("%9.3f s %6.0f MB/s ", recursive_time, size / recursive_time);
+
+            is_ok &= (recursive_time > 0);
+
+        } else {
+            printf("%22s ", "stack overflow");
+        }
+
+        printf("%9.3f s %6.0f MB/s\n", loop_time, size / loop_time);
+
+        is_ok &= (loop_time > 0);
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        bench_base_dtor(&bases[i]);
+    }
+
+    if (!is_ok) {
+        printf("Error: some base was not read\n");
+    }
+
+    return is_ok ? 0 : 1;
+}
+
+static bool read_recursively(Tree *tree, char *text) {
+    assert(tree != nullptr);
+    assert(text != nullptr);
+
+    size_t ip = 0;
+
+    return read_node(tree, text, &ip, No_node);
+}
+
+// One call per level, children are read by two nested calls
+
+static bool read_node(Tree *tree, char *text, size_t *ip, Node_id parent) {
+    assert(tree != nullptr);
+    assert(text != nullptr);
+    assert(ip   != nullptr);
+
+    *ip = scan_spaces(text, *ip);
+
+    if (text[*ip] != '{') {
+        return false;
+    }
+
+    *ip = scan_spaces(text, *ip + 1);
+
+    if (text[*ip] != '"') {
+        return false;
+    }
+
+    size_t start = *ip + 1;
+
+    *ip = scan_to_quote(text, start);
+
+    if (text[*ip] != '"') {
+        return false;
+    }
+
+    text[*ip] = '\0';
+
+    Text_id stored = intern_text(tree, start, *ip - start);
+
+    Node_id node = (stored != No_text) ? attach_node(tree, parent, stored) : No_node;
+
+    if (node == No_node) {
+        return false;
+    }
+
+    set_node_flag(tree, node, Saved_flag, true);
+
+    *ip = scan_spaces(text, *ip + 1);
+
+    if (text[*ip] != '}') {
+        if (!read_node(tree, text, ip, node) || !read_node(tree, text, ip, node)) {
+            return false;
+        }
+
+        *ip = scan_spaces(text, *ip);
+
+        if (text[*ip] != '}') {
+            return false;
+        }
+    }
+
+    ++(*ip);
+
+    return true;
+}
+
+// The best time of several runs, every run reads a fresh copy into a new tree.
+// Negative time means that base was not read.
+
+static double time_parser(const Bench_base *base, Parser parser) {
+    assert(base   != nullptr);
+    assert(parser != nullptr);
+
+    double best = -1;
+
+    for (size_t run = 0; run < Runs_per_parser; ++run) {
+        char *text = copy_base_text(base);
+
+        Tree tree = {};
+
+        if (text == nullptr || real_tree_init(&tree, __FILE__, __PRETTY_FUNCTION__, __LINE__) != NO_TREE_ERR) {
+            unmap_file(text, base->size);
+            return -1;
+        }
+
+        set_tree_text(&tree, text, base->size);
+
+        double start = get_seconds();
+
+        bool is_read = parser(&tree, text);
+
+        double time = get_seconds() - start;
+
+        tree_dtor(&tree);
+        unmap_file(text, base->size);
+
+        if (!is_read) {
+            return -1;
+        }
+
+        if (best < 0 || time < best) {
+            best = time;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <assert.h>
+
+#include "bench_bases.h"
+#include "../Tree/layout.h"
+#include "../Libs/file_reading.hpp"
+
+// Latency of random root-to-leaf walks, as ask_questions() makes them, before
+// and after relayout of tree. Loaded base keeps nodes in preorder of file.
+// Grown tree is made by random splits of leaves, as add_character() makes
+// them, so its nodes are in order of insertion. The same walks are made in
+// every layout. Run by `make bench`.
+
+static bool grow_tree(Tree *tree, size_t n_splits);
+
+static Node_id get_random_leaf(const Tree *tree, uint64_t *seed);
+
+static double time_walks(const Tree *tree, size_t *n_steps);
+
+static uint64_t get_random(uint64_t *seed);
+
+
+static const size_t   Walks_per_run = 1 << 20;
+static const size_t   Runs_per_walk = 3;
+static const uint64_t Random_seed   = 0x9E3779B97F4A7C15;
+
+static const size_t   N_layouts     = 3;
+
+static const Tree_layout Layouts[N_layouts]      = {No_layout, Bfs_layout, Veb_layout};
+static const char*       Layout_names[N_layouts] = {"none", "bfs", "veb"};
+
+
+int main() {
+    Bench_base base = {};
+
+    if (!make_balanced_base(&base, "balanced", 21)) {
+        printf("Error: not enought memory\n");
+        return 1;
+    }
+
+    Tree loaded = {};
+    Tree grown  = {};
+
+    char *text = load_bench_tree(&loaded, &base, 1);
+
+    bool is_ok = text != nullptr && grow_tree(&grown, 1 << 21);
+
+    Tree*       trees[2]      = {&loaded, &grown};
+    const char* tree_names[2] = {"balanced 21", "grown 2^21"};
+
+    if (is_ok) {
+        printf("%-12s %9s %8s %14s %14s\n", "tree", "nodes", "layout", "ns per walk", "ns per step");
+    }
+
+    for (size_t i = 0; is_ok && i < 2; ++i) {
+        size_t first_steps = 0;
+
+        for (size_t layout = 0; is_ok && layout < N_layouts; ++layout) {
+            if (!relayout_tree(trees[i], Layouts[layout])) {
+                is_ok = false;
+                break;
+            }
+
+            size_t n_steps = 0;
+
+            double time = time_walks(trees[i], &n_steps);
+
+            if (layout == 0) {
+                first_steps = n_steps;
+            }
+
+            // Relayout keeps shape of tree, so walks must be the same
+
+            is_ok = n_steps == first_steps;
+
+            printf("%-12s %9u %8s %14.1f %14.2f\n", tree_names[i], trees[i]->n_nodes - 1, Layout_names[layout],
+                   time * 1e9 / Walks_per_run, time * 1e9 / (double) n_steps);
+        }
+    }
+
+    tree_dtor(&loaded);
+    tree_dtor(&grown);
+
+    unmap_file(text, base.size);
+
+    bench_base_dtor(&base);
+
+    if (!is_ok) {
+        printf("Error: benchmark failed\n");
+    }
+
+    return is_ok ? 0 : 1;
+}
+
+// Every split takes a leaf at the end of random walk, new nodes get
+// the next ids wherever the leaf is
+
+static bool grow_tree(Tree *tree, size_t n_splits) {
+    assert(tree != nullptr);
+
+    if (real_tree_init(tree, __FILE__, __PRETTY_FUNCTION__, __LINE__) != NO_TREE_ERR) {
+        return false;
+    }
+
+    char text[32] = {};
+
+    int len = snprintf(text, sizeof(text), "character %d", 0);
+
+    Text_id first = store_text(tree, text, (size_t) len);
+
+    if (first == No_text || attach_node(tree, No_node, first) == No_node) {
+        return false;
+    }
+
+    uint64_t seed = Random_seed;
+
+    for (size_t i = 0; i < n_splits; ++i) {
+        Node_id leaf = get_random_leaf(tree, &seed);
+
+        len = snprintf(text, sizeof(text), "character %zu", i + 1);
+
+        Text_id name = store_text(tree, text, (size_t) len);
+
+        len = snprintf(text, sizeof(text), "question %zu", i);
+
+        Text_id question = store_text(tree, text, (size_t) len);
+
+        if (name == No_text || question == No_text || split_node(tree, leaf, name, question, true) != NO_TREE_ERR) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static Node_id get_random_leaf(const Tree *tree, uint64_t *seed) {
+    assert(tree != nullptr);
+    assert(seed != nullptr);
+
+    Node_id node = tree->head;
+
+    while (!is_leaf(tree, node)) {
+        node = (get_random(seed) & 1) ? node_left(tree, node) : node_right(tree, node);
+    }
+
+    return node;
+}
+
+// The best time of several runs, every run makes the same walks
+
+static double time_walks(const Tree *tree, size_t *n_steps) {
+    assert(tree    != nullptr);
+    assert(n_steps != nullptr);
+
+    double best = -1;
+
+    for (size_t run = 0; run < Runs_per_walk; ++run) {
+        uint64_t seed = Random_seed + 1;
+
+        size_t steps = 0;
+
+        double start = get_seconds();
+
+        for (size_t walk = 0; walk < Walks_per_run; ++walk) {
+            Node_id node = tree->head;
+
+            while (!is_leaf(tree, node)) {
+                node = (get_random(&seed) & 1) ? node_left(tree, node) : node_right(tree, node);
+
+                ++steps;
+            }
+        }
+
+        double time = get_seconds() - start;
+
+        *n_steps = steps;
+
+        if (best < 0 || time < best) {
+            best = time;
+        }
+    }
+
+    return best;
+}
+
+// xorshift64, walks don't need better randomness
+
+static uint64_t get_random(uint64_t *seed) {
+    assert(seed != nullptr);
+
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+
+    return *seed;
+}
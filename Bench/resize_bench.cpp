@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../Libs/Stack/stack.h"
+
+// Number of reallocations made by stack on patterns of pushes and pops,
+// against the policy it replaced: capacity was doubled on full stack and
+// halved after any pop which left it less than half full. The old policy is
+// modeled here by capacity only. Stack reallocates whenever its capacity is
+// changed. Run by `make bench`.
+
+enum Stack_pattern {
+    Straddle_pattern,       // push, two pops and push around full capacity
+    Random_pattern,         // push or pop with equal chances
+    Round_pattern,          // fill to Round_depth and pop all
+};
+
+struct Naive_stack {
+    size_t size     = 0;
+    size_t capacity = 0;
+    size_t n_resize = 0;
+};
+
+static bool count_resizes(const char *name, Stack_pattern pattern);
+
+static bool is_push(Stack_pattern pattern, size_t op, uint64_t *seed);
+
+static void naive_push(Naive_stack *stk);
+
+static void naive_pop(Naive_stack *stk);
+
+
+static const size_t   Inline_depth  = 16;
+static const size_t   Start_depth   = 1024;      // capacity of stack is full at it
+static const size_t   Round_depth   = 4096;
+static const size_t   N_operations  = 1 << 22;
+static const uint64_t Random_seed   = 0x9E3779B97F4A7C15;
+
+
+int main() {
+    printf("%-10s %10s %14s %14s\n", "pattern", "operations", "old resizes", "resizes");
+
+    bool is_ok = count_resizes("straddle", Straddle_pattern) &&
+                 count_resizes("random",   Random_pattern)   &&
+                 count_resizes("rounds",   Round_pattern);
+
+    if (!is_ok) {
+        printf("Error: stack reported errors\n");
+    }
+
+    return is_ok ? 0 : 1;
+}
+
+// Both stacks are filled to Start_depth first, resizes are counted from then
+
+static bool count_resizes(const char *name, Stack_pattern pattern) {
+    Stack<uint32_t, Inline_depth, No_checks> stk = {};
+
+    Naive_stack naive = {0, Inline_depth, 0};
+
+    int errors = StackCtr(&stk, 0);
+
+    for (uint32_t i = 0; i < Start_depth; ++i) {
+        errors |= StackPush(&stk, i + 1);
+
+        naive_push(&naive);
+    }
+
+    naive.n_resize = 0;
+
+    size_t n_resize = 0;
+
+    uint64_t seed = Random_seed;
+
+    for (size_t op = 0; op < N_operations && errors == NO_ERROR; ++op) {
+        size_t capacity = stk.capacity;
+
+        if (is_push(pattern, op, &seed) || stk.size == 0) {
+            errors |= StackPush(&stk, (uint32_t) op + 1);
+
+            naive_push(&naive);
+
+        } else {
+            int err = NO_ERROR;
+
+            StackPop(&stk, &err);
+
+            errors |= err;
+
+            naive_pop(&naive);
+        }
+
+        n_resize += (stk.capacity != capacity);
+    }
+
+    errors |= StackDestr(&stk);
+
+    printf("%-10s %10zu %14zu %14zu\n", name, N_operations, naive.n_resize, n_resize);
+
+    return errors == NO_ERROR;
+}
+
+static bool is_push(Stack_pattern pattern, size_t op, uint64_t *seed) {
+    switch (pattern) {
+        case Straddle_pattern:
+            return (op % 4) == 0 || (op % 4) == 3;
+
+        case Random_pattern:
+            *seed ^= *seed << 13;
+            *seed ^= *seed >> 7;
+            *seed ^= *seed << 17;
+
+            return (*seed & 1) != 0;
+
+        case Round_pattern:
+            return (op % (2 * Round_depth)) < Round_depth;
+
+        default:
+            return true;
+    }
+}
+
+static void naive_push(Naive_stack *stk) {
+    if (stk->size == stk->capacity) {
+        stk->capacity *= 2;
+
+        ++(stk->n_resize);
+    }
+
+    ++(stk->size);
+}
+
+static void naive_pop(Naive_stack *stk) {
+    --(stk->size);
+
+    if (stk->size < stk->capacity / 2) {
+        stk->capacity /= 2;
+
+        ++(stk->n_resize);
+    }
+}
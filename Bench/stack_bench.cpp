@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "bench_bases.h"
+#include "../Libs/Stack/stack.h"
+
+// Push and pop throughput of stack for every set of checks. Every round
+// pushes Round_depth elements and pops them all, so stack moves to heap and
+// back as dontknow_nodes of guess mode does. Hash and deep checks look
+// through all elements on every operation, so they make fewer rounds.
+// Run by `make bench`.
+
+template <unsigned Checks>
+static bool time_policy(const char *name, size_t n_rounds);
+
+
+static const size_t Round_depth  = 1024;
+static const size_t Inline_depth = 16;
+
+static const size_t Fast_rounds  = 1 << 14;
+static const size_t Slow_rounds  = 1 << 6;
+
+
+int main() {
+    printf("%-16s %8s %12s %12s\n", "checks", "rounds", "ns per push", "ns per pop");
+
+    bool is_ok = time_policy<No_checks>    ("none",   Fast_rounds) &&
+                 time_policy<Canary_checks>("canary", Fast_rounds) &&
+                 time_policy<Poison_checks>("poison", Fast_rounds) &&
+                 time_policy<Hash_checks>  ("hash",   Slow_rounds) &&
+                 time_policy<Deep_checks>  ("deep",   Slow_rounds) &&
+                 time_policy<All_checks>   ("all",    Slow_rounds);
+
+    if (!is_ok) {
+        printf("Error: stack reported errors\n");
+    }
+
+    return is_ok ? 0 : 1;
+}
+
+// Pushed elements are not zero, zero is poison. Sum of popped elements is
+// checked, so pops are not thrown away by optimizer.
+
+template <unsigned Checks>
+static bool time_policy(const char *name, size_t n_rounds) {
+    Stack<uint32_t, Inline_depth, Checks> stk = {};
+
+    int errors = StackCtr(&stk, 0);
+
+    double push_time = 0;
+    double pop_time  = 0;
+
+    uint64_t sum = 0;
+
+    for (size_t round = 0; round < n_rounds && errors == NO_ERROR; ++round) {
+        double start = get_seconds();
+
+        for (uint32_t i = 1; i <= Round_depth; ++i) {
+            errors |= StackPush(&stk, i);
+        }
+
+        double pushed = get_seconds();
+
+        for (size_t i = 0; i < Round_depth; ++i) {
+            int err = NO_ERROR;
+
+            sum += StackPop(&stk, &err);
+
+            errors |= err;
+        }
+
+        push_time += pushed - start;
+        pop_time  += get_seconds() - pushed;
+    }
+
+    errors |= StackDestr(&stk);
+
+    double n_ops = (double) (n_rounds * Round_depth);
+
+    printf("%-16s %8zu %12.2f %12.2f\n", name, n_rounds, push_time * 1e9 / n_ops, pop_time * 1e9 / n_ops);
+
+    return errors == NO_ERROR && sum == n_rounds * Round_depth * (Round_depth + 1) / 2;
+}
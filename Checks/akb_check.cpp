@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "check_trees.h"
+#include "../Bench/bench_bases.h"
+#include "../Database/binary_database.h"
+#include "../Libs/file_reading.hpp"
+
+// Round trip of binary data base: tree is written to .akb file, opened
+// from it and both trees should be equal. Trees have texts of data base and
+// texts added by game, so both kinds of strings are written. Then broken
+// images should be rejected: cut image and image with a link out of node
+// table. Run by `make check`.
+
+static bool write_akb(const Bench_base *base, size_t n_characters, const char *akb_name, Text_buffer *expected);
+
+static bool check_akb(const char *akb_name, const Text_buffer *expected);
+
+static bool check_broken_akb(const char *akb_name);
+
+static bool open_akb(char *image, size_t size);
+
+
+static const size_t N_characters = 200;
+
+
+int main() {
+    char dir[64]       = {};
+    char akb_name[128] = {};
+
+    Bench_base bases[2] = {};
+
+    if (!make_check_dir(dir, sizeof(dir)) || !make_balanced_base  (&bases[0], "balanced",   8)
+                                          || !make_degenerate_base(&bases[1], "degenerate", 2000)) {
+        printf("Error: can't prepare akb check\n");
+        bench_base_dtor(&bases[0]);
+        return 1;
+    }
+
+    get_check_file_name(dir, "base.akb", akb_name, sizeof(akb_name));
+
+    bool is_ok = true;
+
+    for (size_t i = 0; is_ok && i < 2; ++i) {
+        Text_buffer expected = {};
+
+        is_ok = write_akb(&bases[i], N_characters, akb_name, &expected);
+
+        if (is_ok && !check_akb(akb_name, &expected)) {
+            printf("Error: tree opened from .akb differs from %s tree which wrote it\n", bases[i].name);
+            is_ok = false;
+        }
+
+        text_buffer_dtor(&expected);
+    }
+
+    if (is_ok && !check_broken_akb(akb_name)) {
+        printf("Error: broken .akb is opened\n");
+        is_ok = false;
+    }
+
+    for (size_t i = 0; i < 2; ++i) {
+        bench_base_dtor(&bases[i]);
+    }
+
+    unlink(akb_name);
+    rmdir(dir);
+
+    printf("akb check: %s\n", is_ok ? "OK" : "FAILED");
+
+    return is_ok ? 0 : 1;
+}
+
+static bool write_akb(const Bench_base *base, size_t n_characters, const char *akb_name, Text_buffer *expected) {
+    Tree tree = {};
+
+    char *text = load_bench_tree(&tree, base, 1);
+
+    bool is_ok = text != nullptr;
+
+    unsigned seed = 1;
+
+    for (size_t i = 0; is_ok && i < n_characters; ++i) {
+        is_ok = add_check_character(&tree, &seed, i) != No_node;
+    }
+
+    FILE *output = is_ok ? fopen(akb_name, "wb") : nullptr;
+
+    is_ok = output != nullptr && write_binary_tree(&tree, output) && dump_check_tree(&tree, expected);
+
+    if (output != nullptr) {
+        is_ok &= (fclose(output) == 0);
+    }
+
+    tree_dtor(&tree);
+    unmap_file(text, base->size);
+
+    if (!is_ok) {
+        printf("Error: can't write .akb\n");
+    }
+
+    return is_ok;
+}
+
+// Tree uses mapped image as its text, so image is unmapped after tree
+
+static bool check_akb(const char *akb_name, const Text_buffer *expected) {
+    size_t size = 0;
+
+    char *image = map_file(akb_name, &size);
+
+    if (image == nullptr || !is_binary_data_base(image, size)) {
+        unmap_file(image, size);
+        return false;
+    }
+
+    Tree tree = {};
+
+    bool is_ok = real_tree_init(&tree, __FILE__, __PRETTY_FUNCTION__, __LINE__) == NO_TREE_ERR &&
+                 open_binary_tree(&tree, image, size) && is_dump_equal(&tree, expected);
+
+    tree_dtor(&tree);
+    unmap_file(image, size);
+
+    return is_ok;
+}
+
+// Image is mapped privately, so it is broken in memory only
+
+static bool check_broken_akb(const char *akb_name) {
+    size_t size = 0;
+
+    char *image = map_file(akb_name, &size);
+
+    if (image == nullptr) {
+        return false;
+    }
+
+    const Akb_header *header = (const Akb_header*) (const void*) image;
+
+    bool is_cut_rejected = !open_akb(image, header->texts_offset);
+
+    Tree_node *records = (Tree_node*) (void*) (image + header->nodes_offset);
+
+    records[1].left = (Node_id) header->n_nodes + 1;
+
+    bool is_link_rejected = !open_akb(image, size);
+
+    unmap_file(image, size);
+
+    return is_cut_rejected && is_link_rejected;
+}
+
+static bool open_akb(char *image, size_t size) {
+    Tree tree = {};
+
+    bool is_opened = real_tree_init(&tree, __FILE__, __PRETTY_FUNCTION__, __LINE__) == NO_TREE_ERR &&
+                     open_binary_tree(&tree, image, size);
+
+    tree_dtor(&tree);
+
+    return is_opened;
+}
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "check_trees.h"
+#include "../Bench/bench_bases.h"
+#include "../Database/compression.h"
+#include "../Database/stream_reading.h"
+#include "../Libs/file_reading.hpp"
+
+// Round trip of compressed data base: tree is written to .akz file, which
+// is unpacked from mapped file and should give the text dump of tree byte
+// by byte. The same file is streamed by blocks into a new tree, which should
+// be equal to the written one. Bases are larger than a block, so texts are
+// split between blocks. Run by `make check`.
+
+static bool write_akz(const Bench_base *base, const char *akz_name, Text_buffer *expected);
+
+static bool check_unpacked_akz(const char *akz_name, const Text_buffer *expected);
+
+static bool check_streamed_akz(const char *akz_name, const Text_buffer *expected);
+
+
+static const size_t N_characters = 200;
+
+
+int main() {
+    char dir[64]       = {};
+    char akz_name[128] = {};
+
+    Bench_base bases[2] = {};
+
+    if (!make_check_dir(dir, sizeof(dir)) || !make_balanced_base  (&bases[0], "balanced",   14)
+                                          || !make_degenerate_base(&bases[1], "degenerate", 20000)) {
+        printf("Error: can't prepare akz check\n");
+        bench_base_dtor(&bases[0]);
+        return 1;
+    }
+
+    get_check_file_name(dir, "base.akz", akz_name, sizeof(akz_name));
+
+    bool is_ok = true;
+
+    for (size_t i = 0; is_ok && i < 2; ++i) {
+        Text_buffer expected = {};
+
+        is_ok = write_akz(&bases[i], akz_name, &expected);
+
+        if (is_ok && !check_unpacked_akz(akz_name, &expected)) {
+            printf("Error: .akz of %s tree is not unpacked to its dump\n", bases[i].name);
+            is_ok = false;
+        }
+
+        if (is_ok && !check_streamed_akz(akz_name, &expected)) {
+            printf("Error: tree streamed from .akz differs from %s tree which wrote it\n", bases[i].name);
+            is_ok = false;
+        }
+
+        text_buffer_dtor(&expected);
+    }
+
+    for (size_t i = 0; i < 2; ++i) {
+        bench_base_dtor(&bases[i]);
+    }
+
+    unlink(akz_name);
+    rmdir(dir);
+
+    printf("akz check: %s\n", is_ok ? "OK" : "FAILED");
+
+    return is_ok ? 0 : 1;
+}
+
+static bool write_akz(const Bench_base *base, const char *akz_name, Text_buffer *expected) {
+    Tree tree = {};
+
+    char *text = load_bench_tree(&tree, base, 1);
+
+    bool is_ok = text != nullptr;
+
+    unsigned seed = 1;
+
+    for (size_t i = 0; is_ok && i < N_characters; ++i) {
+        is_ok = add_check_character(&tree, &seed, i) != No_node;
+    }
+
+    FILE *output = is_ok ? fopen(akz_name, "wb") : nullptr;
+
+    is_ok = output != nullptr && write_compressed_tree(&tree, output) && dump_check_tree(&tree, expected);
+
+    if (output != nullptr) {
+        is_ok &= (fclose(output) == 0);
+    }
+
+    tree_dtor(&tree);
+    unmap_file(text, base->size);
+
+    if (!is_ok) {
+        printf("Error: can't write .akz\n");
+    }
+
+    return is_ok;
+}
+
+static bool check_unpacked_akz(const char *akz_name, const Text_buffer *expected) {
+    size_t size = 0;
+
+    char *data = map_file(akz_name, &size);
+
+    if (data == nullptr || !is_compressed_data_base(data, size)) {
+        unmap_file(data, size);
+        return false;
+    }
+
+    size_t text_size = 0;
+
+    char *text = decompress_data_base(data, size, &text_size);
+
+    bool is_equal = text != nullptr && text_size == expected->size &&
+                    memcmp(text, expected->data, text_size) == 0;
+
+    unmap_file(text, text_size);
+    unmap_file(data, size);
+
+    return is_equal;
+}
+
+static bool check_streamed_akz(const char *akz_name, const Text_buffer *expected) {
+    FILE *input = fopen(akz_name, "rb");
+
+    if (input == nullptr) {
+        return false;
+    }
+
+    Tree tree = {};
+
+    bool is_ok = real_tree_init(&tree, __FILE__, __PRETTY_FUNCTION__, __LINE__) == NO_TREE_ERR &&
+                 stream_tree(&tree, input, Stream_chunk_size) && is_dump_equal(&tree, expected);
+
+    tree_dtor(&tree);
+    fclose(input);
+
+    return is_ok;
+}
@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "check_trees.h"
+#include "../Bench/bench_bases.h"
+#include "../Queries/batch_queries.h"
+#include "../Libs/file_reading.hpp"
+
+// Order of batch answers: queries are answered by one thread, every line
+// of answer should name what its query asked about. Then the same
+// queries are answered by several threads, answers should be the same byte
+// by byte. Queries are of every kind, with empty lines between them, and
+// there are many more of them than lines in one chunk. Run by `make check`.
+
+enum Check_query_kind {
+    Quoted_define  = 0,
+    Plain_define   = 1,
+    Quoted_diff    = 2,
+    Unknown_define = 3,
+    Broken_diff    = 4,
+    Empty_line     = 5,
+    N_query_kinds  = 6,
+};
+
+struct Check_query {
+    Check_query_kind kind  = Empty_line;
+    size_t           name1 = 0;
+    size_t           name2 = 0;
+};
+
+static bool write_queries(const char *queries_name, Check_query *queries, size_t n_characters);
+
+static bool check_answers(const char *answers_name, const Check_query *queries);
+
+static bool has_token(const char *line, size_t len, const char *token);
+
+static bool is_file_equal(const char *file_name1, const char *file_name2);
+
+
+static const size_t N_queries     = 3000;
+static const size_t Check_depth   = 10;
+
+static const size_t N_thread_sets = 3;
+static const size_t Thread_sets[N_thread_sets] = {1, 3, 8};
+
+
+int main() {
+    char dir[64]            = {};
+    char queries_name[128]  = {};
+    char answers_names[N_thread_sets][128] = {};
+
+    Bench_base base = {};
+
+    Check_query *queries = (Check_query*) calloc(N_queries, sizeof(Check_query));
+
+    if (queries == nullptr || !make_check_dir(dir, sizeof(dir)) || !make_balanced_base(&base, "balanced", Check_depth)) {
+        printf("Error: can't prepare batch check\n");
+        free(queries);
+        return 1;
+    }
+
+    get_check_file_name(dir, "queries.txt", queries_name, sizeof(queries_name));
+
+    for (size_t i = 0; i < N_thread_sets; ++i) {
+        char name[32] = {};
+
+        snprintf(name, sizeof(name), "answers_%zu.txt", Thread_sets[i]);
+
+        get_check_file_name(dir, name, answers_names[i], sizeof(answers_names[i]));
+    }
+
+    Tree tree = {};
+
+    Name_index names    = {};
+    Ancestry   ancestry = {};
+
+    char *text = load_bench_tree(&tree, &base, 1);
+
+    bool is_ok = text != nullptr && build_name_index(&names, &tree) && build_ancestry(&ancestry, &tree) &&
+                 write_queries(queries_name, queries, (size_t) 1 << Check_depth);
+
+    if (!is_ok) {
+        printf("Error: can't prepare batch check\n");
+    }
+
+    Query_sources sources = {&tree, &names, &ancestry};
+
+    for (size_t i = 0; is_ok && i < N_thread_sets; ++i) {
+        is_ok = answer_queries(&sources, queries_name, answers_names[i], Thread_sets[i]);
+    }
+
+    if (is_ok && !check_answers(answers_names[0], queries)) {
+        printf("Error: answers of one thread are not in order of queries\n");
+        is_ok = false;
+    }
+
+    for (size_t i = 1; is_ok && i < N_thread_sets; ++i) {
+        if (!is_file_equal(answers_names[0], answers_names[i])) {
+            printf("Error: answers of %zu threads differ from answers of one thread\n", Thread_sets[i]);
+            is_ok = false;
+        }
+    }
+
+    name_index_dtor(&names);
+    ancestry_dtor(&ancestry);
+
+    tree_dtor(&tree);
+    unmap_file(text, base.size);
+
+    bench_base_dtor(&base);
+    free(queries);
+
+    unlink(queries_name);
+
+    for (size_t i = 0; i < N_thread_sets; ++i) {
+        unlink(answers_names[i]);
+    }
+
+    rmdir(dir);
+
+    printf("batch check: %s\n", is_ok ? "OK" : "FAILED");
+
+    return is_ok ? 0 : 1;
+}
+
+static bool write_queries(const char *queries_name, Check_query *queries, size_t n_characters) {
+    FILE *output = fopen(queries_name, "w");
+
+    if (output == nullptr) {
+        return false;
+    }
+
+    unsigned seed = 1;
+
+    for (size_t i = 0; i < N_queries; ++i) {
+        Check_query *query = &queries[i];
+
+        query->kind  = (Check_query_kind) ((unsigned) rand_r(&seed) % N_query_kinds);
+        query->name1 = (size_t) rand_r(&seed) % n_characters;
+        query->name2 = (query->name1 + 1 + (size_t) rand_r(&seed) % (n_characters - 1)) % n_characters;
+
+        switch (query->kind) {
+            case Quoted_define:
+                fprintf(output, "define \"character %zu\"\n", query->name1);
+                break;
+
+            case Plain_define:
+                fprintf(output, "define character %zu\n", query->name1);
+                break;
+
+            case Quoted_diff:
+                fprintf(output, "diff \"character %zu\" \"character %zu\"\n", query->name1, query->name2);
+                break;
+
+            case Unknown_define:
+                fprintf(output, "define \"nobody %zu\"\n", query->name1);
+                break;
+
+            case Broken_diff:
+                fprintf(output, "diff \"character %zu\"\n", query->name1);
+                break;
+
+            case Empty_line:
+            case N_query_kinds:
+            default:
+                fprintf(output, "\n");
+                break;
+        }
+    }
+
+    return fclose(output) == 0;
+}
+
+// Answer of define has one line, answer of diff has three lines: what is
+// common, what is only in the first character and only in the second one.
+// Every line names its character or line of broken query.
+
+static bool check_answers(const char *answers_name, const Check_query *queries) {
+    size_t size = 0;
+
+    char *answers = map_file(answers_name, &size);
+
+    if (answers == nullptr) {
+        return false;
+    }
+
+    size_t ip    = 0;
+    bool   is_ok = true;
+
+    for (size_t i = 0; is_ok && i < N_queries; ++i) {
+        char tokens[3][32] = {};
+
+        size_t n_lines = 1;
+
+        switch (queries[i].kind) {
+            case Quoted_define:
+            case Plain_define:
+                snprintf(tokens[0], sizeof(tokens[0]), "character %zu", queries[i].name1);
+                break;
+
+            case Quoted_diff:
+                snprintf(tokens[0], sizeof(tokens[0]), "character %zu", queries[i].name1);
+                snprintf(tokens[1], sizeof(tokens[1]), "character %zu", queries[i].name1);
+                snprintf(tokens[2], sizeof(tokens[2]), "character %zu", queries[i].name2);
+
+                n_lines = 3;
+                break;
+
+            case Unknown_define:
+                snprintf(tokens[0], sizeof(tokens[0]), "nobody %zu", queries[i].name1);
+                break;
+
+            case Broken_diff:
+                snprintf(tokens[0], sizeof(tokens[0]), "line %zu", i + 1);
+                break;
+
+            case Empty_line:
+            case N_query_kinds:
+            default:
+                continue;
+        }
+
+        for (size_t line = 0; is_ok && line < n_lines; ++line) {
+            const char *end = (const char*) memchr(answers + ip, '\n', size - ip);
+
+            if (end == nullptr) {
+                is_ok = false;
+                break;
+            }
+
+            size_t len = (size_t) (end - answers) - ip;
+
+            if (!has_token(answers + ip, len, tokens[line])) {
+                printf("Error: answer %.*s is not for query %zu\n", (int) len, answers + ip, i + 1);
+                is_ok = false;
+            }
+
+            ip += len + 1;
+        }
+    }
+
+    is_ok &= (ip == size);
+
+    unmap_file(answers, size);
+
+    return is_ok;
+}
+
+// Token shouldn't be followed by digit, so character 1 is not found in character 12
+
+static bool has_token(const char *line, size_t len, const char *token) {
+    size_t token_len = strlen(token);
+
+    for (size_t i = 0; i + token_len <= len; ++i) {
+        if (memcmp(line + i, token, token_len) == 0 &&
+            (i + token_len == len || line[i + token_len] < '0' || line[i + token_len] > '9')) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool is_file_equal(const char *file_name1, const char *file_name2) {
+    size_t size1 = 0;
+    size_t size2 = 0;
+
+    char *text1 = map_file(file_name1, &size1);
+    char *text2 = map_file(file_name2, &size2);
+
+    bool is_equal = text1 != nullptr && text2 != nullptr && size1 == size2 && memcmp(text1, text2, size1) == 0;
+
+    unmap_file(text1, size1);
+    unmap_file(text2, size2);
+
+    return is_equal;
+}
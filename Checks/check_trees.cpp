@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "check_trees.h"
+
+static bool append_dump(void *context, const char *data, size_t len);
+
+static const char Check_dir_template[] = "/tmp/akinator_check_XXXXXX";
+
+
+bool dump_check_tree(Tree *tree, Text_buffer *dump) {
+    assert(tree != nullptr);
+    assert(dump != nullptr);
+
+    return text_database_write(tree, append_dump, dump) && dump->is_ok;
+}
+
+bool is_dump_equal(Tree *tree, const Text_buffer *expected) {
+    assert(tree     != nullptr);
+    assert(expected != nullptr);
+
+    Text_buffer dump = {};
+
+    bool is_equal = dump_check_tree(tree, &dump) && dump.size == expected->size &&
+                    memcmp(dump.data, expected->data, dump.size) == 0;
+
+    text_buffer_dtor(&dump);
+
+    return is_equal;
+}
+
+Node_id add_check_character(Tree *tree, unsigned *seed, size_t index) {
+    assert(tree != nullptr);
+    assert(seed != nullptr);
+
+    Node_id node = tree->head;
+
+    while (!is_leaf(tree, node)) {
+        node = (rand_r(seed) & 1) ? node_left(tree, node) : node_right(tree, node);
+    }
+
+    char text[64] = {};
+
+    int len = snprintf(text, sizeof(text), "new {character} %zu \\", index);
+
+    Text_id name = store_text(tree, text, (size_t) len);
+
+    len = snprintf(text, sizeof(text), "is it {new} %zu", index);
+
+    Text_id question = store_text(tree, text, (size_t) len);
+
+    if (name == No_text || question == No_text || split_node(tree, node, name, question, false) != NO_TREE_ERR) {
+        return No_node;
+    }
+
+    return node;
+}
+
+bool make_check_dir(char *dir, size_t dir_size) {
+    assert(dir != nullptr);
+
+    if (dir_size < sizeof(Check_dir_template)) {
+        return false;
+    }
+
+    memcpy(dir, Check_dir_template, sizeof(Check_dir_template));
+
+    return mkdtemp(dir) != nullptr;
+}
+
+void get_check_file_name(const char *dir, const char *name, char *file_name, size_t size) {
+    assert(dir       != nullptr);
+    assert(name      != nullptr);
+    assert(file_name != nullptr);
+
+    snprintf(file_name, size, "%s/%s", dir, name);
+}
+
+static bool append_dump(void *context, const char *data, size_t len) {
+    assert(context != nullptr);
+    assert(data    != nullptr);
+
+    Text_buffer *dump = (Text_buffer*) context;
+
+    buffer_append(dump, data, len);
+
+    return dump->is_ok;
+}
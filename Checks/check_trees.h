@@ -0,0 +1,29 @@
+#ifndef CHECK_TREES
+#define CHECK_TREES
+
+#include <stddef.h>
+
+#include "../Tree/tree.h"
+#include "../Libs/text_buffer.h"
+
+// Helpers of round-trip checks. Trees are compared by their text dumps,
+// which contain every text and the shape of tree. Tree takes a few pages,
+// so checks keep dump of expected tree instead of the tree itself.
+
+bool dump_check_tree(Tree *tree, Text_buffer *dump);
+
+bool is_dump_equal(Tree *tree, const Text_buffer *expected);
+
+// Leaf at the end of random walk from head is split as add_character()
+// does it, texts contain braces and backslashes. Split node is returned,
+// No_node if there is no memory.
+
+Node_id add_check_character(Tree *tree, unsigned *seed, size_t index);
+
+// Temporary directory of check, files are made in it by name
+
+bool make_check_dir(char *dir, size_t dir_size);
+
+void get_check_file_name(const char *dir, const char *name, char *file_name, size_t size);
+
+#endif
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "check_trees.h"
+#include "../Bench/bench_bases.h"
+#include "../Database/journal.h"
+#include "../Libs/file_reading.hpp"
+
+// Round trip of journal: characters added to tree are written to journal,
+// journal is replayed over the same data base and both trees should be
+// equal. Then damaged records are appended: replay should stop before them,
+// move them to .damaged file and cut journal back. Run by `make check`.
+
+static bool write_journal(const Bench_base *base, const char *base_name, Text_buffer *expected);
+
+static bool check_replay(const Bench_base *base, const char *base_name, const Text_buffer *expected);
+
+static bool append_to_file(const char *file_name, const char *data);
+
+static bool check_file(const char *file_name, const char *data);
+
+
+static const size_t N_characters = 300;
+
+// Record which splits a question, record with path through a leaf and unfinished record
+
+static const char Damaged_records[] = "{ \"lrl\" \"x\" \"y\" }\n{ \"rrrrrrrrrrrrrrr\" \"x\" \"y\" }\n{ \"l";
+
+
+int main() {
+    char dir[64]           = {};
+    char base_name[128]    = {};
+    char journal_name[128] = {};
+    char damaged_name[128] = {};
+
+    Bench_base base = {};
+
+    if (!make_check_dir(dir, sizeof(dir)) || !make_balanced_base(&base, "balanced", 6)) {
+        printf("Error: can't prepare journal check\n");
+        return 1;
+    }
+
+    get_check_file_name(dir, "base.txt",                 base_name,    sizeof(base_name));
+    get_check_file_name(dir, "base.txt.journal",         journal_name, sizeof(journal_name));
+    get_check_file_name(dir, "base.txt.journal.damaged", damaged_name, sizeof(damaged_name));
+
+    Text_buffer expected = {};
+
+    bool is_ok = write_journal(&base, base_name, &expected);
+
+    if (is_ok && !check_replay(&base, base_name, &expected)) {
+        printf("Error: replayed tree differs from tree which wrote journal\n");
+        is_ok = false;
+    }
+
+    // Replayed records stay and damaged ones are moved aside
+
+    size_t size = 0;
+
+    char *journal = is_ok ? map_file(journal_name, &size) : nullptr;
+
+    if (is_ok && (journal == nullptr || !append_to_file(journal_name, Damaged_records))) {
+        printf("Error: can't damage journal\n");
+        is_ok = false;
+    }
+
+    if (is_ok && !check_replay(&base, base_name, &expected)) {
+        printf("Error: tree replayed from damaged journal differs from tree which wrote it\n");
+        is_ok = false;
+    }
+
+    if (is_ok && !(check_file(journal_name, journal) && check_file(damaged_name, Damaged_records))) {
+        printf("Error: damaged records are not moved from journal\n");
+        is_ok = false;
+    }
+
+    unmap_file(journal, size);
+
+    text_buffer_dtor(&expected);
+    bench_base_dtor(&base);
+
+    unlink(journal_name);
+    unlink(damaged_name);
+    rmdir(dir);
+
+    printf("journal check: %s\n", is_ok ? "OK" : "FAILED");
+
+    return is_ok ? 0 : 1;
+}
+
+// Every split is written as game writes it, right after character is added
+
+static bool write_journal(const Bench_base *base, const char *base_name, Text_buffer *expected) {
+    Tree tree = {};
+
+    char *text = load_bench_tree(&tree, base, 1);
+
+    Journal journal = {};
+
+    bool is_ok = text != nullptr && open_journal(&journal, base_name);
+
+    unsigned seed = 1;
+
+    for (size_t i = 0; is_ok && i < N_characters; ++i) {
+        Node_id node = add_check_character(&tree, &seed, i);
+
+        is_ok = node != No_node && write_journal_record(&journal, &tree, node);
+    }
+
+    is_ok = is_ok && dump_check_tree(&tree, expected);
+
+    journal_dtor(&journal);
+
+    tree_dtor(&tree);
+    unmap_file(text, base->size);
+
+    if (!is_ok) {
+        printf("Error: can't write journal\n");
+    }
+
+    return is_ok;
+}
+
+static bool check_replay(const Bench_base *base, const char *base_name, const Text_buffer *expected) {
+    Tree tree = {};
+
+    char *text = load_bench_tree(&tree, base, 1);
+
+    Journal journal = {};
+
+    bool is_ok = text != nullptr && open_journal(&journal, base_name) && replay_journal(&journal, &tree)
+                                 && is_dump_equal(&tree, expected);
+
+    journal_dtor(&journal);
+
+    tree_dtor(&tree);
+    unmap_file(text, base->size);
+
+    return is_ok;
+}
+
+static bool append_to_file(const char *file_name, const char *data) {
+    FILE *file = fopen(file_name, "a");
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool is_ok = fputs(data, file) >= 0;
+
+    return (fclose(file) == 0) && is_ok;
+}
+
+static bool check_file(const char *file_name, const char *data) {
+    size_t size = 0;
+
+    char *text = map_file(file_name, &size);
+
+    bool is_equal = text != nullptr && size == strlen(data) && memcmp(text, data, size) == 0;
+
+    unmap_file(text, size);
+
+    return is_equal;
+}
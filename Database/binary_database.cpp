@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "binary_database.h"
+#include "../Libs/file_reading.hpp"
+
+static bool check_header(const Akb_header *header, size_t size);
+
+static bool check_strings(const String_entry *strings, uint64_t n_strings, const char *texts, uint64_t texts_size);
+
+static bool check_node(const Tree_node *records, Node_id id, uint64_t n_nodes, uint64_t n_strings);
+
+static Node_id* get_nodes_order(Tree *tree, size_t *n_nodes);
+
+
+bool is_binary_data_base(const char *image, size_t size) {
+    assert(image != nullptr);
+
+    return size >= sizeof(Akb_signature) && memcmp(image, Akb_signature, sizeof(Akb_signature)) == 0;
+}
+
+bool open_binary_tree(Tree *tree, char *image, size_t size) {
+    assert(tree  != nullptr);
+    assert(image != nullptr);
+
+    const Akb_header *header = (const Akb_header*) (const void*) image;
+
+    if (!check_header(header, size)) {
+        return false;
+    }
+
+    const Tree_node    *records = (const Tree_node*)    (const void*) (image + header->nodes_offset);
+    const String_entry *strings = (const String_entry*) (const void*) (image + header->strings_offset);
+
+    if (!check_strings(strings, header->n_strings, image + header->texts_offset, header->texts_size)) {
+        printf("Error: incorrect binary data base: string table is broken\n");
+        return false;
+    }
+
+    for (uint64_t i = 0; i < header->n_nodes; ++i) {
+        if (!check_node(records, (Node_id) i + 1, header->n_nodes, header->n_strings)) {
+            printf("Error: incorrect binary data base: node table is broken\n");
+            return false;
+        }
+    }
+
+    if (!set_tree_text(tree, image + header->texts_offset, header->texts_size)) {
+        return false;
+    }
+
+    // Texts of records are numbers of strings, they become handles in the pool as they are
+
+    if (!add_string_entries(&tree->strings, strings, header->n_strings)) {
+        printf("Error: can't open binary data base - not enought memory\n");
+        return false;
+    }
+
+    // Copied parts of the image are given back at once, only texts are used from it
+
+    release_pages(image + header->strings_offset, header->n_strings * sizeof(String_entry));
+
+    Node_id first = reserve_nodes(tree, header->n_nodes);
+
+    if (first == No_node) {
+        return false;
+    }
+
+    // Ids in the file start from 1, they are shifted if tree already has nodes
+
+    Node_id shift = first - 1;
+
+    memcpy(tree->nodes + first, records, header->n_nodes * sizeof(Tree_node));
+
+    for (Node_id node = first; node < first + header->n_nodes; ++node) {
+        Tree_node *record = &tree->nodes[node];
+
+        record->left   += (record->left   != No_node) ? shift : 0;
+        record->right  += (record->right  != No_node) ? shift : 0;
+        record->parent += (record->parent != No_node) ? shift : 0;
+
+        set_node_flag(tree, node, Saved_flag, true);
+    }
+
+    release_pages(image + header->nodes_offset, header->n_nodes * sizeof(Tree_node));
+
+    tree->head = first;
+
+    return true;
+}
+
+static bool check_header(const Akb_header *header, size_t size) {
+    assert(header != nullptr);
+
+    if (size < sizeof(Akb_header)) {
+        printf("Error: incorrect binary data base: file is too short\n");
+        return false;
+    }
+
+    if (header->version != Akb_version || header->node_size != sizeof(Tree_node)) {
+        printf("Error: binary data base was written by incompatible version of akinator\n");
+        return false;
+    }
+
+    if (header->n_nodes == 0 
+        || header->n_nodes >= Max_nodes
+        || header->nodes_offset % alignof(Tree_node) != 0
+        || header->nodes_offset > size
+        || header->n_nodes > (size - header->nodes_offset) / sizeof(Tree_node)
+        || header->n_strings == 0
+        || header->n_strings > Max_texts
+        || header->strings_offset % alignof(String_entry) != 0
+        || header->strings_offset > size
+        || header->n_strings > (size - header->strings_offset) / sizeof(String_entry)
+        || header->texts_offset > size
+        || header->texts_size == 0
+        || header->texts_size > size - header->texts_offset
+        || header->texts_size > Max_text_size) {
+
+        printf("Error: incorrect binary data base: sizes do not match file size\n");
+        return false;
+    }
+
+    const char *texts = (const char*) header + header->texts_offset;
+
+    if (texts[header->texts_size - 1] != '\0') {
+        printf("Error: incorrect binary data base: texts are broken\n");
+        return false;
+    }
+
+    return true;
+}
+
+// Strings lie inside texts blob and are ended with '\0'. Hashes are not
+// counted again, broken hash can only make text not found by lookups.
+
+static bool check_strings(const String_entry *strings, uint64_t n_strings, const char *texts, uint64_t texts_size) {
+    assert(strings != nullptr);
+    assert(texts   != nullptr);
+
+    for (uint64_t i = 0; i < n_strings; ++i) {
+        if (strings[i].offset >= texts_size || strings[i].len >= texts_size - strings[i].offset
+                                            || texts[strings[i].offset + strings[i].len] != '\0') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Relatives are ids from 1 to n_nodes, flags are not stored. Node 1 is the
+// root, other nodes are children of their parents. Nodes are written in
+// breadth-first order, so children have greater ids than their parent and
+// walks by parent ids always end at the root.
+
+static bool check_node(const Tree_node *records, Node_id id, uint64_t n_nodes, uint64_t n_strings) {
+    assert(records != nullptr);
+    assert(id      != No_node);
+
+    const Tree_node *node = &records[id - 1];
+
+    if (node->left > n_nodes || node->right > n_nodes || node->parent > n_nodes || node->text >= n_strings) {
+        return false;
+    }
+
+    if ((node->left == No_node) != (node->right == No_node)) {
+        return false;
+    }
+
+    if (node->left != No_node && (node->left <= id || node->right <= id || node->left == node->right
+                                                   || records[node->left  - 1].parent != id
+                                                   || records[node->right - 1].parent != id)) {
+        return false;
+    }
+
+    if (id == 1) {
+        return node->parent == No_node;
+    }
+
+    if (node->parent == No_node || node->parent >= id) {
+        return false;
+    }
+
+    const Tree_node *parent = &records[node->parent - 1];
+
+    return parent->left == id || parent->right == id;
+}
+
+bool write_binary_tree(Tree *tree, FILE *output) {
+    assert(tree   != nullptr);
+    assert(output != nullptr);
+
+    size_t n_nodes = 0;
+
+    Node_id *order = get_nodes_order(tree, &n_nodes);
+
+    Node_id *parents = (Node_id*) calloc(n_nodes + 1, sizeof(Node_id));
+
+    // Texts are interned, so every distinct text gets one string of the table
+
+    Text_id       n_texts        = tree->strings.n_entries;
+    Text_id      *string_numbers = (Text_id*)      malloc(n_texts * sizeof(Text_id));
+    String_entry *strings        = (String_entry*) malloc(n_texts * sizeof(String_entry));
+
+    if (order == nullptr || parents == nullptr || string_numbers == nullptr || strings == nullptr) {
+        printf("Error: can't save data base - not enought memory\n");
+
+        free(order);
+        free(parents);
+        free(string_numbers);
+        free(strings);
+
+        return false;
+    }
+
+    memset(string_numbers, 0xFF, n_texts * sizeof(Text_id));
+
+    Akb_header header = {};
+
+    memcpy(&header.signature, Akb_signature, sizeof(Akb_signature));
+
+    header.version      = Akb_version;
+    header.node_size    = sizeof(Tree_node);
+    header.n_nodes      = n_nodes;
+    header.nodes_offset = sizeof(Akb_header);
+    header.n_strings    = 0;
+    header.texts_size   = 0;
+
+    for (size_t i = 0; i < n_nodes; ++i) {
+        Text_id text = tree->nodes[order[i]].text;
+
+        if (string_numbers[text] != No_text) {
+            continue;
+        }
+
+        string_numbers[text] = (Text_id) header.n_strings;
+
+        strings[header.n_strings] = tree->strings.entries[text];
+        strings[header.n_strings].offset = header.texts_size;
+
+        header.texts_size += get_string_len(&tree->strings, text) + 1;
+        header.n_strings  += 1;
+    }
+
+    header.strings_offset = header.nodes_offset   + n_nodes          * sizeof(Tree_node);
+    header.texts_offset   = header.strings_offset + header.n_strings * sizeof(String_entry);
+
+    if (header.texts_size > Max_text_size) {
+        printf("Error: can't save data base - texts are too big for binary format\n");
+
+        free(order);
+        free(parents);
+        free(string_numbers);
+        free(strings);
+
+        return false;
+    }
+
+    fwrite(&header, sizeof(header), 1, output);
+
+    // Children of i-th node in breadth-first order get next free ids
+
+    Node_id next_id = 1;
+
+    for (size_t i = 0; i < n_nodes; ++i) {
+        Tree_node record = {};
+
+        record.text   = string_numbers[tree->nodes[order[i]].text];
+        record.parent = parents[i];
+
+        if (node_left(tree, order[i]) != No_node) {
+            parents[next_id] = (Node_id) i + 1;
+            record.left  = ++next_id;
+        }
+
+        if (node_right(tree, order[i]) != No_node) {
+            parents[next_id] = (Node_id) i + 1;
+            record.right = ++next_id;
+        }
+
+        fwrite(&record, sizeof(record), 1, output);
+    }
+
+    fwrite(strings, sizeof(String_entry), header.n_strings, output);
+
+    // Texts are written in order of their first use, as strings were numbered
+
+    Text_id strings_written = 0;
+
+    for (size_t i = 0; i < n_nodes; ++i) {
+        Text_id text = tree->nodes[order[i]].text;
+
+        if (string_numbers[text] != strings_written) {
+            continue;
+        }
+
+        fwrite(get_text(tree, text), sizeof(char), get_string_len(&tree->strings, text) + 1, output);
+
+        ++strings_written;
+    }
+
+    free(order);
+    free(parents);
+    free(string_numbers);
+    free(strings);
+
+    return ferror(output) == 0;
+}
+
+static Node_id* get_nodes_order(Tree *tree, size_t *n_nodes) {
+    assert(tree    != nullptr);
+    assert(n_nodes != nullptr);
+
+    size_t capacity = 1;
+
+    Node_id *order = (Node_id*) calloc(capacity, sizeof(Node_id));
+
+    if (order == nullptr) {
+        return nullptr;
+    }
+
+    order[0] = tree->head;
+
+    size_t size = 1;
+
+    for (size_t i = 0; i < size; ++i) {
+        if (size + 2 > capacity) {
+            capacity = 2 * capacity + 2;
+
+            Node_id *new_order = (Node_id*) realloc(order, capacity * sizeof(Node_id));
+
+            if (new_order == nullptr) {
+                free(order);
+                return nullptr;
+            }
+
+            order = new_order;
+        }
+
+        expand_node(tree, order[i]);
+
+        if (node_left(tree, order[i]) != No_node) {
+            order[size++] = node_left(tree, order[i]);
+        }
+
+        if (node_right(tree, order[i]) != No_node) {
+            order[size++] = node_right(tree, order[i]);
+        }
+    }
+
+    *n_nodes = size;
+
+    return order;
+}
@@ -0,0 +1,42 @@
+#ifndef BINARY_DATABASE
+#define BINARY_DATABASE
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../Tree/tree.h"
+
+// Binary data base (.akb) is an image of nodes table: nodes are stored in
+// breadth-first order in the same layout as in the tree, node with id i is
+// i-th record. Equal texts are stored once in texts blob, node's text is
+// the number of its entry in the string table, entry is the same as in
+// tree's string pool (offset in blob, length and hash). Opening copies
+// records and string table to the tree and uses the mapped blob as its
+// text, so texts are not hashed and looked up again.
+
+const char     Akb_signature[] = "AKB";
+const uint32_t Akb_version     = 4;
+
+const char     Akb_extension[] = ".akb";
+
+struct Akb_header {
+    uint32_t signature;     // bytes of Akb_signature
+    uint32_t version;
+    uint64_t node_size;
+    uint64_t n_nodes;
+    uint64_t nodes_offset;
+    uint64_t n_strings;
+    uint64_t strings_offset;
+    uint64_t texts_offset;
+    uint64_t texts_size;
+};
+
+static_assert(sizeof(Akb_signature) == sizeof(uint32_t), "signature is read as one word");
+
+bool is_binary_data_base(const char *image, size_t size);
+
+bool open_binary_tree(Tree *tree, char *image, size_t size);
+
+bool write_binary_tree(Tree *tree, FILE *output);
+
+#endif
@@ -0,0 +1,570 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "compression.h"
+#include "../Libs/file_reading.hpp"
+
+// Packed block is a sequence of commands:
+//
+//     token | literals length | literals | offset | match length
+//
+// High half of token is number of literals, low one is match length
+// minus Min_match. Value 15 means that the rest of length follows as
+// bytes of 255 ended by a smaller byte. Offset is two bytes back from
+// current position. The last command has literals only.
+
+static const size_t   Min_match     = 4;
+static const size_t   Max_offset    = 0xFFFF;
+static const size_t   Max_nibble    = 15;
+static const size_t   Max_chain     = 16;
+static const uint32_t Hash_bits     = 15;
+static const size_t   Hash_size     = 1 << Hash_bits;
+static const size_t   Max_block     = 1 << 24;
+
+struct Compressor {
+    FILE*     output     = nullptr;
+    char*     raw        = nullptr;
+    size_t    used       = 0;
+    char*     packed     = nullptr;
+    uint32_t* head       = nullptr;  // last position with the hash + 1
+    uint32_t* prev       = nullptr;  // previous position with the same hash + 1
+};
+
+static bool compressor_ctor(Compressor *compressor, FILE *output);
+
+static void compressor_dtor(Compressor *compressor);
+
+static bool compress_text(void *context, const char *data, size_t len);
+
+static bool write_block(Compressor *compressor);
+
+static size_t pack_block(Compressor *compressor, const uint8_t *src, size_t size, uint8_t *dst);
+
+static size_t put_sequence(uint8_t *dst, const uint8_t *literals, size_t n_literals,
+                                         size_t offset, size_t match_len);
+
+static size_t put_length(uint8_t *dst, size_t len);
+
+static bool unpack_block(const uint8_t *src, size_t packed_size, uint8_t *dst, size_t raw_size);
+
+static bool get_length(const uint8_t *src, size_t size, size_t *ip, size_t *len);
+
+static bool check_header(const Akz_header *header);
+
+static uint32_t hash_of(const uint8_t *data);
+
+static size_t max_packed_size(size_t raw_size);
+
+
+bool is_compressed_data_base(const char *data, size_t size) {
+    assert(data != nullptr);
+
+    return size >= sizeof(Akz_header) && memcmp(data, Akz_signature, sizeof(Akz_signature)) == 0;
+}
+
+// Blocks are walked twice: first to find size of unpacked text,
+// then to unpack them into one '\0'-terminated buffer
+
+char* decompress_data_base(const char *data, size_t size, size_t *raw_size) {
+    assert(data     != nullptr);
+    assert(raw_size != nullptr);
+
+    Akz_header header = {};
+
+    memcpy(&header, data, sizeof(Akz_header));
+
+    if (!check_header(&header)) {
+        return nullptr;
+    }
+
+    size_t total = 0;
+    size_t ip    = sizeof(Akz_header);
+
+    while (true) {
+        Akz_block_header block = {};
+
+        if (size - ip < sizeof(Akz_block_header)) {
+            printf("Error: compressed data base is damaged at byte %zu\n", ip);
+            return nullptr;
+        }
+
+        memcpy(&block, data + ip, sizeof(Akz_block_header));
+
+        ip += sizeof(Akz_block_header);
+
+        if (block.raw_size == 0) {
+            break;
+        }
+
+        if (block.raw_size > header.block_size || block.packed_size > block.raw_size ||
+                                                  block.packed_size > size - ip) {
+            printf("Error: compressed data base is damaged at byte %zu\n", ip);
+            return nullptr;
+        }
+
+        total += block.raw_size;
+        ip    += block.packed_size;
+    }
+
+    char *text = map_anonymous(total);
+
+    if (text == nullptr) {
+        printf("Error: can't run akinator - not enought memory\n");
+        return nullptr;
+    }
+
+    size_t op = 0;
+
+    ip = sizeof(Akz_header);
+
+    while (op < total) {
+        Akz_block_header block = {};
+
+        memcpy(&block, data + ip, sizeof(Akz_block_header));
+
+        ip += sizeof(Akz_block_header);
+
+        const uint8_t *src = (const uint8_t*) data + ip;
+
+        if (block.packed_size == block.raw_size) {
+            memcpy(text + op, src, block.raw_size);
+
+        } else if (!unpack_block(src, block.packed_size, (uint8_t*) text + op, block.raw_size)) {
+            printf("Error: compressed data base is damaged at byte %zu\n", ip);
+
+            unmap_file(text, total);
+
+            return nullptr;
+        }
+
+        ip += block.packed_size;
+        op += block.raw_size;
+    }
+
+    *raw_size = total;
+
+    return text;
+}
+
+bool write_compressed_tree(Tree *tree, FILE *output) {
+    assert(tree   != nullptr);
+    assert(output != nullptr);
+
+    Compressor compressor = {};
+
+    if (!compressor_ctor(&compressor, output)) {
+        compressor_dtor(&compressor);
+        return false;
+    }
+
+    Akz_header header = {};
+
+    memcpy(&header.signature, Akz_signature, sizeof(Akz_signature));
+
+    header.version    = Akz_version;
+    header.block_size = (uint32_t) Akz_block_size;
+
+    Akz_block_header end = {};
+
+    bool result = fwrite(&header, sizeof(Akz_header), 1, output) == 1
+               && text_database_write(tree, compress_text, &compressor)
+               && write_block(&compressor)
+               && fwrite(&end, sizeof(Akz_block_header), 1, output) == 1;
+
+    compressor_dtor(&compressor);
+
+    return result;
+}
+
+bool decompressor_ctor(Decompressor *decompressor, FILE *input, const Akz_header *header) {
+    assert(decompressor != nullptr);
+    assert(input        != nullptr);
+    assert(header       != nullptr);
+
+    if (!check_header(header)) {
+        return false;
+    }
+
+    decompressor->input      = input;
+    decompressor->block_size = header->block_size;
+    decompressor->offset     = sizeof(Akz_header);
+
+    decompressor->packed = (char*) calloc(header->block_size, sizeof(char));
+
+    if (decompressor->packed == nullptr) {
+        printf("Error: can't run akinator - not enought memory\n");
+        return false;
+    }
+
+    return true;
+}
+
+// Unpacks next block into raw buffer of block_size bytes, len is 0 after the last block
+
+bool read_compressed_block(Decompressor *decompressor, char *raw, size_t *len) {
+    assert(decompressor != nullptr);
+    assert(raw          != nullptr);
+    assert(len          != nullptr);
+
+    Akz_block_header block = {};
+
+    if (fread(&block, sizeof(Akz_block_header), 1, decompressor->input) != 1) {
+        printf("Error: compressed data base is damaged at byte %zu\n", decompressor->offset);
+        return false;
+    }
+
+    decompressor->offset += sizeof(Akz_block_header);
+
+    *len = 0;
+
+    if (block.raw_size == 0) {
+        return true;
+    }
+
+    if (block.raw_size > decompressor->block_size || block.packed_size > block.raw_size ||
+        fread(decompressor->packed, sizeof(char), block.packed_size, decompressor->input)
+                                                                 != block.packed_size) {
+        printf("Error: compressed data base is damaged at byte %zu\n", decompressor->offset);
+        return false;
+    }
+
+    const uint8_t *src = (const uint8_t*) decompressor->packed;
+
+    if (block.packed_size == block.raw_size) {
+        memcpy(raw, src, block.raw_size);
+
+    } else if (!unpack_block(src, block.packed_size, (uint8_t*) raw, block.raw_size)) {
+        printf("Error: compressed data base is damaged at byte %zu\n", decompressor->offset);
+        return false;
+    }
+
+    decompressor->offset += block.packed_size;
+
+    *len = block.raw_size;
+
+    return true;
+}
+
+void decompressor_dtor(Decompressor *decompressor) {
+    assert(decompressor != nullptr);
+
+    free(decompressor->packed);
+
+    decompressor->packed = nullptr;
+}
+
+static bool check_header(const Akz_header *header) {
+    assert(header != nullptr);
+
+    if (header->version != Akz_version) {
+        printf("Error: unsupported version %u of compressed data base\n", header->version);
+        return false;
+    }
+
+    if (header->block_size == 0 || header->block_size > Max_block) {
+        printf("Error: compressed data base is damaged: wrong block size %u\n", header->block_size);
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------- COMPRESSION --------------------------------//
+
+static bool compressor_ctor(Compressor *compressor, FILE *output) {
+    assert(compressor != nullptr);
+    assert(output     != nullptr);
+
+    compressor->output = output;
+
+    compressor->raw    = (char*)     calloc(Akz_block_size, sizeof(char));
+    compressor->packed = (char*)     calloc(max_packed_size(Akz_block_size), sizeof(char));
+    compressor->head   = (uint32_t*) calloc(Hash_size,      sizeof(uint32_t));
+    compressor->prev   = (uint32_t*) calloc(Akz_block_size, sizeof(uint32_t));
+
+    return compressor->raw  != nullptr && compressor->packed != nullptr &&
+           compressor->head != nullptr && compressor->prev   != nullptr;
+}
+
+static void compressor_dtor(Compressor *compressor) {
+    assert(compressor != nullptr);
+
+    free(compressor->raw);
+    free(compressor->packed);
+    free(compressor->head);
+    free(compressor->prev);
+
+    compressor->raw    = nullptr;
+    compressor->packed = nullptr;
+    compressor->head   = nullptr;
+    compressor->prev   = nullptr;
+}
+
+static bool compress_text(void *context, const char *data, size_t len) {
+    assert(context != nullptr);
+    assert(data    != nullptr);
+
+    Compressor *compressor = (Compressor*) context;
+
+    while (len > 0) {
+        size_t part = Akz_block_size - compressor->used;
+
+        if (part > len) {
+            part = len;
+        }
+
+        memcpy(compressor->raw + compressor->used, data, part);
+
+        compressor->used += part;
+
+        data += part;
+        len  -= part;
+
+        if (compressor->used == Akz_block_size && !write_block(compressor)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool write_block(Compressor *compressor) {
+    assert(compressor != nullptr);
+
+    if (compressor->used == 0) {
+        return true;
+    }
+
+    Akz_block_header block = {};
+
+    block.raw_size    = (uint32_t) compressor->used;
+    block.packed_size = (uint32_t) pack_block(compressor, (const uint8_t*) compressor->raw,
+                                              compressor->used, (uint8_t*) compressor->packed);
+
+    const char *data = compressor->packed;
+
+    if (block.packed_size >= block.raw_size) {
+        block.packed_size = block.raw_size;
+
+        data = compressor->raw;
+    }
+
+    compressor->used = 0;
+
+    return fwrite(&block, sizeof(Akz_block_header), 1, compressor->output) == 1 &&
+           fwrite(data, sizeof(char), block.packed_size, compressor->output) == block.packed_size;
+}
+
+// Greedy parsing: the longest match among Max_chain previous positions
+// with the same hash is taken
+
+static size_t pack_block(Compressor *compressor, const uint8_t *src, size_t size, uint8_t *dst) {
+    assert(compressor != nullptr);
+    assert(src        != nullptr);
+    assert(dst        != nullptr);
+
+    memset(compressor->head, 0, Hash_size * sizeof(uint32_t));
+
+    size_t ip     = 0;
+    size_t anchor = 0;
+    size_t op     = 0;
+
+    while (ip + Min_match <= size) {
+        uint32_t hash = hash_of(src + ip);
+
+        size_t best_len    = 0;
+        size_t best_offset = 0;
+
+        size_t candidate = compressor->head[hash];
+
+        for (size_t i = 0; i < Max_chain && candidate != 0 && ip - (candidate - 1) <= Max_offset; ++i) {
+            size_t pos = candidate - 1;
+            size_t len = 0;
+
+            while (ip + len < size && src[pos + len] == src[ip + len]) {
+                ++len;
+            }
+
+            if (len > best_len) {
+                best_len    = len;
+                best_offset = ip - pos;
+            }
+
+            candidate = compressor->prev[pos];
+        }
+
+        compressor->prev[ip]   = compressor->head[hash];
+        compressor->head[hash] = (uint32_t) (ip + 1);
+
+        if (best_len < Min_match) {
+            ++ip;
+            continue;
+        }
+
+        op += put_sequence(dst + op, src + anchor, ip - anchor, best_offset, best_len);
+
+        for (size_t end = ip + best_len, pos = ip + 1; pos < end && pos + Min_match <= size; ++pos) {
+            hash = hash_of(src + pos);
+
+            compressor->prev[pos]  = compressor->head[hash];
+            compressor->head[hash] = (uint32_t) (pos + 1);
+        }
+
+        ip    += best_len;
+        anchor = ip;
+    }
+
+    op += put_sequence(dst + op, src + anchor, size - anchor, 0, 0);
+
+    return op;
+}
+
+static size_t put_sequence(uint8_t *dst, const uint8_t *literals, size_t n_literals,
+                                         size_t offset, size_t match_len) {
+    assert(dst      != nullptr);
+    assert(literals != nullptr);
+
+    size_t match_code = (match_len >= Min_match) ? match_len - Min_match : 0;
+
+    size_t lit_nibble   = (n_literals < Max_nibble) ? n_literals : Max_nibble;
+    size_t match_nibble = (match_code < Max_nibble) ? match_code : Max_nibble;
+
+    size_t op = 0;
+
+    dst[op++] = (uint8_t) ((lit_nibble << 4) | match_nibble);
+
+    if (lit_nibble == Max_nibble) {
+        op += put_length(dst + op, n_literals - Max_nibble);
+    }
+
+    memcpy(dst + op, literals, n_literals);
+
+    op += n_literals;
+
+    if (offset == 0) {
+        return op;
+    }
+
+    dst[op++] = (uint8_t) (offset & 0xFF);
+    dst[op++] = (uint8_t) (offset >> 8);
+
+    if (match_nibble == Max_nibble) {
+        op += put_length(dst + op, match_code - Max_nibble);
+    }
+
+    return op;
+}
+
+static size_t put_length(uint8_t *dst, size_t len) {
+    assert(dst != nullptr);
+
+    size_t op = 0;
+
+    for (; len >= 0xFF; len -= 0xFF) {
+        dst[op++] = 0xFF;
+    }
+
+    dst[op++] = (uint8_t) len;
+
+    return op;
+}
+
+//------------------------------ DECOMPRESSION -------------------------------//
+
+static bool unpack_block(const uint8_t *src, size_t packed_size, uint8_t *dst, size_t raw_size) {
+    assert(src != nullptr);
+    assert(dst != nullptr);
+
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (ip < packed_size) {
+        uint8_t token = src[ip++];
+
+        size_t n_literals = token >> 4;
+        size_t match_len  = token & Max_nibble;
+
+        if (n_literals == Max_nibble && !get_length(src, packed_size, &ip, &n_literals)) {
+            return false;
+        }
+
+        if (n_literals > packed_size - ip || n_literals > raw_size - op) {
+            return false;
+        }
+
+        memcpy(dst + op, src + ip, n_literals);
+
+        ip += n_literals;
+        op += n_literals;
+
+        if (ip == packed_size) {
+            break;
+        }
+
+        if (packed_size - ip < 2) {
+            return false;
+        }
+
+        size_t offset = (size_t) src[ip] | ((size_t) src[ip + 1] << 8);
+
+        ip += 2;
+
+        if (match_len == Max_nibble && !get_length(src, packed_size, &ip, &match_len)) {
+            return false;
+        }
+
+        match_len += Min_match;
+
+        if (offset == 0 || offset > op || match_len > raw_size - op) {
+            return false;
+        }
+
+        // Match may overlap with the bytes it produces
+
+        const uint8_t *match = dst + op - offset;
+
+        for (size_t i = 0; i < match_len; ++i) {
+            dst[op + i] = match[i];
+        }
+
+        op += match_len;
+    }
+
+    return op == raw_size;
+}
+
+static bool get_length(const uint8_t *src, size_t size, size_t *ip, size_t *len) {
+    assert(src != nullptr);
+    assert(ip  != nullptr);
+    assert(len != nullptr);
+
+    uint8_t part = 0xFF;
+
+    while (part == 0xFF) {
+        if (*ip >= size) {
+            return false;
+        }
+
+        part = src[(*ip)++];
+
+        *len += part;
+    }
+
+    return true;
+}
+
+static uint32_t hash_of(const uint8_t *data) {
+    assert(data != nullptr);
+
+    uint32_t word = 0;
+
+    memcpy(&word, data, sizeof(uint32_t));
+
+    return (word * 2654435761u) >> (32 - Hash_bits);
+}
+
+static size_t max_packed_size(size_t raw_size) {
+    return raw_size + raw_size / 0xFF + 16;
+}
@@ -0,0 +1,58 @@
+#ifndef COMPRESSION
+#define COMPRESSION
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../Tree/tree.h"
+
+// Compressed data base (.akz) is a text data base cut into blocks which
+// are packed independently by LZ-style codec:
+//
+//     header | block header | block | ... | block header with raw_size = 0
+//
+// Block is a sequence of literals and back references inside the block,
+// so every block can be unpacked alone, from mapped file or from stream.
+// Block with packed_size equal to raw_size is stored as is.
+
+const char     Akz_signature[] = "AKZ";
+const uint32_t Akz_version     = 1;
+
+const char     Akz_extension[] = ".akz";
+
+const size_t   Akz_block_size  = 1 << 18;
+
+struct Akz_header {
+    uint32_t signature;     // bytes of Akz_signature
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(Akz_signature) == sizeof(uint32_t), "signature is read as one word");
+
+struct Akz_block_header {
+    uint32_t raw_size;
+    uint32_t packed_size;
+};
+
+struct Decompressor {
+    FILE*  input      = nullptr;
+    char*  packed     = nullptr;
+    size_t block_size = 0;
+    size_t offset     = 0;
+};
+
+bool is_compressed_data_base(const char *data, size_t size);
+
+char* decompress_data_base(const char *data, size_t size, size_t *raw_size);
+
+bool write_compressed_tree(Tree *tree, FILE *output);
+
+bool decompressor_ctor(Decompressor *decompressor, FILE *input, const Akz_header *header);
+
+bool read_compressed_block(Decompressor *decompressor, char *raw, size_t *len);
+
+void decompressor_dtor(Decompressor *decompressor);
+
+#endif
@@ -0,0 +1,461 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "journal.h"
+#include "../Libs/file_reading.hpp"
+#include "../Libs/scanning.h"
+
+static const char Journal_temp_extension[]    = ".tmp";
+static const char Journal_damaged_extension[] = ".damaged";
+
+struct Journal_record {
+    const char* path         = nullptr;
+    size_t      path_len     = 0;
+    const char* name         = nullptr;
+    size_t      name_len     = 0;
+    const char* question     = nullptr;
+    size_t      question_len = 0;
+};
+
+static bool read_record(const char *text, size_t *ip, Journal_record *record);
+
+static bool read_record_text(const char *text, size_t *ip, const char **start, size_t *len);
+
+static bool apply_record(Tree *tree, const Journal_record *record);
+
+static char* make_record(const Tree *tree, Node_id node, size_t *len);
+
+static bool write_all(int fd, const char *data, size_t len);
+
+static char* get_journal_file_name(const Journal *journal, const char *extension);
+
+static bool keep_damaged_records(const Journal *journal, const char *records, size_t len);
+
+
+bool open_journal(Journal *journal, const char *data_base_name) {
+    assert(journal        != nullptr);
+    assert(data_base_name != nullptr);
+
+    size_t name_len = strlen(data_base_name);
+
+    journal->file_name = (char*) calloc(name_len + sizeof(Journal_extension), sizeof(char));
+
+    if (journal->file_name == nullptr) {
+        return false;
+    }
+
+    memcpy(journal->file_name, data_base_name, name_len);
+    memcpy(journal->file_name + name_len, Journal_extension, sizeof(Journal_extension));
+
+    // File is created only when the first record is written
+
+    journal->fd = open(journal->file_name, O_RDWR | O_APPEND);
+
+    return true;
+}
+
+bool replay_journal(Journal *journal, Tree *tree) {
+    assert(journal != nullptr);
+    assert(tree    != nullptr);
+
+    if (journal->fd < 0) {
+        return true;
+    }
+
+    size_t size = 0;
+
+    char *text = map_file(journal->file_name, &size);
+
+    if (text == nullptr) {
+        return false;
+    }
+
+    size_t ip         = 0;
+    size_t valid      = 0;
+    bool   is_damaged = false;
+
+    while (true) {
+        ip = scan_spaces(text, ip);
+
+        if (ip >= size) {
+            break;
+        }
+
+        Journal_record record = {};
+
+        if (!read_record(text, &ip, &record)) {
+            printf("Warning: journal %s is damaged at byte %zu, ", journal->file_name, valid);
+            is_damaged = true;
+            break;
+        }
+
+        if (!apply_record(tree, &record)) {
+            printf("Warning: journal %s doesn't match data base at byte %zu, ", journal->file_name, valid);
+            is_damaged = true;
+            break;
+        }
+
+        valid = ip;
+    }
+
+    // Records which are not replayed are moved aside, so new records are
+    // appended right after replayed ones and nothing is lost
+
+    if (is_damaged) {
+        if (!keep_damaged_records(journal, text + valid, size - valid)) {
+            printf("can't move the rest of it aside\n");
+            unmap_file(text, size);
+            return false;
+        }
+
+        printf("the rest of it is moved to %s%s\n", journal->file_name, Journal_damaged_extension);
+    }
+
+    unmap_file(text, size);
+
+    if (valid < size && ftruncate(journal->fd, (off_t) valid) != 0) {
+        return false;
+    }
+
+    return true;
+}
+
+bool write_journal_record(Journal *journal, const Tree *tree, Node_id node) {
+    assert(journal != nullptr);
+    assert(tree    != nullptr);
+    assert(node    != No_node);
+    assert(node_left(tree, node) != No_node);
+
+    if (journal->file_name == nullptr) {
+        return false;
+    }
+
+    if (journal->fd < 0) {
+        journal->fd = open(journal->file_name, O_RDWR | O_APPEND | O_CREAT, 0644);
+
+        if (journal->fd < 0) {
+            return false;
+        }
+    }
+
+    size_t len = 0;
+
+    char *record = make_record(tree, node, &len);
+
+    if (record == nullptr) {
+        return false;
+    }
+
+    bool result = write_all(journal->fd, record, len) && fsync(journal->fd) == 0;
+
+    free(record);
+
+    return result;
+}
+
+bool clear_journal(Journal *journal) {
+    assert(journal != nullptr);
+
+    if (journal->fd < 0) {
+        return true;
+    }
+
+    close(journal->fd);
+
+    journal->fd = -1;
+
+    return unlink(journal->file_name) == 0;
+}
+
+size_t get_journal_size(const Journal *journal) {
+    assert(journal != nullptr);
+
+    struct stat info = {};
+
+    if (journal->fd < 0 || fstat(journal->fd, &info) != 0) {
+        return 0;
+    }
+
+    return (size_t) info.st_size;
+}
+
+// Records from the beginning of journal are dropped when they are merged
+// into data base, records written after that are moved to the new journal
+
+bool trim_journal(Journal *journal, size_t merged_size) {
+    assert(journal != nullptr);
+
+    size_t size = get_journal_size(journal);
+
+    if (merged_size >= size) {
+        return clear_journal(journal);
+    }
+
+    if (merged_size == 0) {
+        return true;
+    }
+
+    size_t tail_size = size - merged_size;
+
+    char *tail = (char*) calloc(tail_size, sizeof(char));
+
+    if (tail == nullptr) {
+        return false;
+    }
+
+    bool result = pread(journal->fd, tail, tail_size, (off_t) merged_size) == (ssize_t) tail_size;
+
+    char *temp_name = get_journal_file_name(journal, Journal_temp_extension);
+
+    if (temp_name == nullptr) {
+        free(tail);
+        return false;
+    }
+
+    int fd = result ? open(temp_name, O_RDWR | O_APPEND | O_CREAT | O_TRUNC, 0644) : -1;
+
+    result = fd >= 0 && write_all(fd, tail, tail_size) && fsync(fd) == 0 
+                     && rename(temp_name, journal->file_name) == 0;
+
+    if (result) {
+        close(journal->fd);
+
+        journal->fd = fd;
+
+    } else if (fd >= 0) {
+        close(fd);
+
+        unlink(temp_name);
+    }
+
+    free(temp_name);
+    free(tail);
+
+    return result;
+}
+
+void journal_dtor(Journal *journal) {
+    assert(journal != nullptr);
+
+    if (journal->fd >= 0) {
+        close(journal->fd);
+    }
+
+    free(journal->file_name);
+
+    journal->fd        = -1;
+    journal->file_name = nullptr;
+}
+
+static bool read_record(const char *text, size_t *ip, Journal_record *record) {
+    assert(text   != nullptr);
+    assert(ip     != nullptr);
+    assert(record != nullptr);
+
+    if (text[*ip] != '{') {
+        return false;
+    }
+
+    ++(*ip);
+
+    if (!read_record_text(text, ip, &record->path,     &record->path_len) ||
+        !read_record_text(text, ip, &record->name,     &record->name_len) ||
+        !read_record_text(text, ip, &record->question, &record->question_len)) {
+        return false;
+    }
+
+    *ip = scan_spaces(text, *ip);
+
+    if (text[*ip] != '}') {
+        return false;
+    }
+
+    ++(*ip);
+
+    return true;
+}
+
+static bool read_record_text(const char *text, size_t *ip, const char **start, size_t *len) {
+    assert(text  != nullptr);
+    assert(ip    != nullptr);
+    assert(start != nullptr);
+    assert(len   != nullptr);
+
+    *ip = scan_spaces(text, *ip);
+
+    if (text[*ip] != '"') {
+        return false;
+    }
+
+    size_t end = scan_to_quote(text, *ip + 1);
+
+    if (text[end] != '"') {
+        return false;
+    }
+
+    *start = text + *ip + 1;
+    *len   = end - *ip - 1;
+
+    *ip = end + 1;
+
+    return true;
+}
+
+static bool apply_record(Tree *tree, const Journal_record *record) {
+    assert(tree   != nullptr);
+    assert(record != nullptr);
+
+    Node_id node = tree->head;
+
+    for (size_t i = 0; i < record->path_len && node != No_node; ++i) {
+        expand_node(tree, node);
+
+        switch (record->path[i]) {
+            case 'l':
+                node = node_left(tree, node);
+                break;
+
+            case 'r':
+                node = node_right(tree, node);
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    if (node == No_node || node_left(tree, expand_node(tree, node)) != No_node) {
+        return false;
+    }
+
+    Text_id name     = store_text(tree, record->name,     record->name_len);
+    Text_id question = store_text(tree, record->question, record->question_len);
+
+    if (name == No_text || question == No_text) {
+        return false;
+    }
+
+    return split_node(tree, node, name, question, true) == NO_TREE_ERR;
+}
+
+#define Append(str, len)                    \
+        memcpy(record + pos, str, len);     \
+        pos += len;
+
+static char* make_record(const Tree *tree, Node_id node, size_t *len) {
+    assert(tree != nullptr);
+    assert(node != No_node);
+    assert(len  != nullptr);
+
+    size_t depth = 0;
+
+    for (Node_id cur = node; node_parent(tree, cur) != No_node; cur = node_parent(tree, cur)) {
+        ++depth;
+    }
+
+    const char *name     = node_text(tree, node_left(tree, node));
+    const char *question = node_text(tree, node);
+
+    size_t name_len     = strlen(name);
+    size_t question_len = strlen(question);
+
+    *len = sizeof("{ \"") - 1 + depth + sizeof("\" \"") - 1 + name_len 
+                                      + sizeof("\" \"") - 1 + question_len + sizeof("\" }\n") - 1;
+
+    char *record = (char*) calloc(*len + 1, sizeof(char));
+
+    if (record == nullptr) {
+        return nullptr;
+    }
+
+    size_t pos = 0;
+
+    Append("{ \"", sizeof("{ \"") - 1);
+
+    size_t path_pos = pos + depth;
+
+    for (Node_id cur = node; node_parent(tree, cur) != No_node; cur = node_parent(tree, cur)) {
+        record[--path_pos] = is_left_child(tree, cur) ? 'l' : 'r';
+    }
+
+    pos += depth;
+
+    Append("\" \"", sizeof("\" \"") - 1);
+    Append(name, name_len);
+    Append("\" \"", sizeof("\" \"") - 1);
+    Append(question, question_len);
+    Append("\" }\n", sizeof("\" }\n") - 1);
+
+    return record;
+}
+
+#undef Append
+
+static bool write_all(int fd, const char *data, size_t len) {
+    assert(data != nullptr);
+
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+
+        if (written <= 0) {
+            return false;
+        }
+
+        data += written;
+        len  -= (size_t) written;
+    }
+
+    return true;
+}
+
+static char* get_journal_file_name(const Journal *journal, const char *extension) {
+    assert(journal   != nullptr);
+    assert(extension != nullptr);
+
+    size_t name_len      = strlen(journal->file_name);
+    size_t extension_len = strlen(extension);
+
+    char *name = (char*) calloc(name_len + extension_len + 1, sizeof(char));
+
+    if (name == nullptr) {
+        return nullptr;
+    }
+
+    memcpy(name, journal->file_name, name_len);
+    memcpy(name + name_len, extension, extension_len);
+
+    return name;
+}
+
+// Damaged records are appended to file next to journal, they can be
+// fixed by hand and put back to journal
+
+static bool keep_damaged_records(const Journal *journal, const char *records, size_t len) {
+    assert(journal != nullptr);
+    assert(records != nullptr);
+
+    char *damaged_name = get_journal_file_name(journal, Journal_damaged_extension);
+
+    if (damaged_name == nullptr) {
+        return false;
+    }
+
+    int fd = open(damaged_name, O_WRONLY | O_APPEND | O_CREAT, 0644);
+
+    free(damaged_name);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    bool result = write_all(fd, records, len) && fsync(fd) == 0;
+
+    close(fd);
+
+    return result;
+}
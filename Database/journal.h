@@ -0,0 +1,37 @@
+#ifndef JOURNAL
+#define JOURNAL
+
+#include <stdio.h>
+
+#include "../Tree/tree.h"
+
+// Journal keeps characters added since data base was written. Every split
+// of a leaf is appended as one record and synced to disk:
+//
+//     { "<path>" "<new character>" "<question>" }
+//
+// where path is a sequence of 'l' and 'r' moves from head to the leaf.
+// Records are replayed over data base on start.
+
+const char Journal_extension[] = ".journal";
+
+struct Journal {
+    int   fd        = -1;
+    char* file_name = nullptr;
+};
+
+bool open_journal(Journal *journal, const char *data_base_name);
+
+bool replay_journal(Journal *journal, Tree *tree);
+
+bool write_journal_record(Journal *journal, const Tree *tree, Node_id node);
+
+bool clear_journal(Journal *journal);
+
+size_t get_journal_size(const Journal *journal);
+
+bool trim_journal(Journal *journal, size_t merged_size);
+
+void journal_dtor(Journal *journal);
+
+#endif
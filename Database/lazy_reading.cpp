@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "lazy_reading.h"
+#include "../Libs/file_reading.hpp"
+
+static bool expand_lazy_node(Tree *tree, Node_id node, void *context);
+
+static bool read_lazy_level(Tree *tree, Lazy_text *lazy, size_t ip, Node_id top);
+
+static char* get_index_name(const char *file_name);
+
+static bool load_subtree_index(Lazy_text *lazy, const char *index_name, 
+                                                const struct stat *text_info);
+
+static void save_subtree_index(const Lazy_text *lazy, const char *index_name, 
+                                                      const struct stat *text_info);
+
+
+bool read_text_tree_lazy(Tree *tree, Lazy_text *lazy, char *text, const char *file_name) {
+    assert(tree      != nullptr);
+    assert(lazy      != nullptr);
+    assert(text      != nullptr);
+    assert(file_name != nullptr);
+
+    lazy->text = text;
+
+    struct stat text_info = {};
+
+    bool has_info = (stat(file_name, &text_info) == 0);
+
+    char *index_name = get_index_name(file_name);
+
+    if (!has_info || index_name == nullptr || !load_subtree_index(lazy, index_name, &text_info)) {
+
+        if (!build_subtree_index(text, &lazy->index)) {
+            free(index_name);
+            return false;
+        }
+
+        if (has_info && index_name != nullptr) {
+            save_subtree_index(lazy, index_name, &text_info);
+        }
+    }
+
+    free(index_name);
+
+    tree->expander         = expand_lazy_node;
+    tree->expander_context = lazy;
+
+    return read_lazy_level(tree, lazy, 0, No_node);
+}
+
+void lazy_text_dtor(Lazy_text *lazy) {
+    assert(lazy != nullptr);
+
+    if (lazy->index_image != nullptr) {
+        unmap_file(lazy->index_image, lazy->image_size);
+    } else {
+        free(lazy->index.entries);
+    }
+
+    deferred_nodes_dtor(&lazy->deferred);
+
+    unmap_file((char*) lazy->positions, lazy->n_positions * sizeof(uint32_t));
+
+    lazy->positions     = nullptr;
+    lazy->n_positions   = 0;
+    lazy->text          = nullptr;
+    lazy->index.entries = nullptr;
+    lazy->index.size    = 0;
+    lazy->index_image   = nullptr;
+    lazy->image_size    = 0;
+}
+
+// Children of deferred node are read one level at a time. Node's text can be
+// shared with other nodes, so positions of children are kept apart.
+
+static bool expand_lazy_node(Tree *tree, Node_id node, void *context) {
+    assert(tree    != nullptr);
+    assert(node    != No_node);
+    assert(context != nullptr);
+
+    Lazy_text *lazy = (Lazy_text*) context;
+
+    return read_lazy_level(tree, lazy, lazy->positions[node], node);
+}
+
+static bool read_lazy_level(Tree *tree, Lazy_text *lazy, size_t ip, Node_id top) {
+    assert(tree != nullptr);
+    assert(lazy != nullptr);
+
+    lazy->deferred.size = 0;
+
+    if (!read_text_subtree(tree, lazy->text, &ip, top, 1, &lazy->deferred, &lazy->index)) {
+        return false;
+    }
+
+    // New nodes are inside of node array, so positions take its size
+
+    if (lazy->n_positions < tree->capacity) {
+        uint32_t *positions = (uint32_t*) (void*) grow_anonymous((char*) lazy->positions,
+                                                                 lazy->n_positions * sizeof(uint32_t),
+                                                                 tree->capacity    * sizeof(uint32_t));
+        if (positions == nullptr) {
+            return false;
+        }
+
+        lazy->positions   = positions;
+        lazy->n_positions = tree->capacity;
+    }
+
+    for (size_t i = 0; i < lazy->deferred.size; ++i) {
+        lazy->positions[lazy->deferred.data[i].node] = (uint32_t) lazy->deferred.data[i].ip;
+    }
+
+    return true;
+}
+
+static char* get_index_name(const char *file_name) {
+    assert(file_name != nullptr);
+
+    size_t name_len = strlen(file_name);
+
+    char *index_name = (char*) calloc(name_len + sizeof(Subtree_index_extension), sizeof(char));
+
+    if (index_name == nullptr) {
+        return nullptr;
+    }
+
+    memcpy(index_name, file_name, name_len);
+    memcpy(index_name + name_len, Subtree_index_extension, sizeof(Subtree_index_extension));
+
+    return index_name;
+}
+
+// Index is used only if it was built for the same version of data base file
+
+static bool load_subtree_index(Lazy_text *lazy, const char *index_name, 
+                                                const struct stat *text_info) {
+    assert(lazy       != nullptr);
+    assert(index_name != nullptr);
+    assert(text_info  != nullptr);
+
+    size_t image_size = 0;
+
+    char *image = map_file(index_name, &image_size);
+
+    if (image == nullptr) {
+        return false;
+    }
+
+    const Subtree_index_header *header = (const Subtree_index_header*) (const void*) image;
+
+    if (image_size < sizeof(Subtree_index_header)
+        || memcmp(&header->signature, Subtree_index_signature, sizeof(Subtree_index_signature)) != 0
+        || header->version         != Subtree_index_version
+        || header->text_size       != (uint64_t) text_info->st_size
+        || header->text_mtime_sec  != (int64_t)  text_info->st_mtim.tv_sec
+        || header->text_mtime_nsec != (int64_t)  text_info->st_mtim.tv_nsec
+        || header->size != (image_size - sizeof(Subtree_index_header)) 
+                                                          / sizeof(Subtree_index_entry)) {
+
+        unmap_file(image, image_size);
+        return false;
+    }
+
+    lazy->index_image   = image;
+    lazy->image_size    = image_size;
+    lazy->index.entries = (Subtree_index_entry*) (void*) (image + sizeof(Subtree_index_header));
+    lazy->index.size    = header->size;
+
+    return true;
+}
+
+static void save_subtree_index(const Lazy_text *lazy, const char *index_name, 
+                                                      const struct stat *text_info) {
+    assert(lazy       != nullptr);
+    assert(index_name != nullptr);
+    assert(text_info  != nullptr);
+
+    FILE *output = fopen(index_name, "wb");
+
+    if (output == nullptr) {
+        return;
+    }
+
+    Subtree_index_header header = {};
+
+    memcpy(&header.signature, Subtree_index_signature, sizeof(Subtree_index_signature));
+
+    header.version         = Subtree_index_version;
+    header.text_size       = (uint64_t) text_info->st_size;
+    header.text_mtime_sec  = (int64_t)  text_info->st_mtim.tv_sec;
+    header.text_mtime_nsec = (int64_t)  text_info->st_mtim.tv_nsec;
+    header.size            = lazy->index.size;
+
+    fwrite(&header, sizeof(header), 1, output);
+    fwrite(lazy->index.entries, sizeof(Subtree_index_entry), lazy->index.size, output);
+
+    if (fclose(output) != 0) {
+        remove(index_name);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef LAZY_READING
+#define LAZY_READING
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../Tree/tree.h"
+#include "text_reading.h"
+
+// In lazy mode only the head is read at start, children of other nodes
+// are read from the text when somebody goes down to them (see expand_node()).
+// Index of subtrees is saved to sidecar file next to data base, so
+// skipping of unread subtrees doesn't need scanning after first run.
+
+const char     Subtree_index_extension[] = ".idx";
+const char     Subtree_index_signature[] = "AKI";
+const uint32_t Subtree_index_version     = 1;
+
+struct Subtree_index_header {
+    uint32_t signature;     // bytes of Subtree_index_signature
+    uint32_t version;
+    uint64_t text_size;
+    int64_t  text_mtime_sec;
+    int64_t  text_mtime_nsec;
+    uint64_t size;
+};
+
+static_assert(sizeof(Subtree_index_signature) == sizeof(uint32_t), "signature is read as one word");
+
+struct Lazy_text {
+    char*          text        = nullptr;
+    Subtree_index  index       = {};
+    char*          index_image = nullptr;   // mapped sidecar file, if index was loaded from it
+    size_t         image_size  = 0;
+    Deferred_nodes deferred    = {};        // nodes deferred by the last reading
+    uint32_t*      positions   = nullptr;   // offsets of deferred nodes' children by node ids
+    size_t         n_positions = 0;         // grows together with node array
+};
+
+bool read_text_tree_lazy(Tree *tree, Lazy_text *lazy, char *text, const char *file_name);
+
+void lazy_text_dtor(Lazy_text *lazy);
+
+#endif
@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "stream_reading.h"
+#include "compression.h"
+#include "../Libs/scanning.h"
+
+struct Stream_reader {
+    FILE*  input      = nullptr;
+    char*  chunk      = nullptr;
+    size_t chunk_size = 0;
+    size_t len        = 0;
+    size_t ip         = 0;
+    size_t offset     = 0;
+    char*  text       = nullptr;
+    size_t text_len   = 0;
+    size_t text_cap   = 0;
+
+    bool         is_compressed = false;  // chunks are unpacked blocks
+    bool         is_ended      = false;  // block of zero size is read
+    bool         is_damaged    = false;  // block can't be unpacked, it is not the end of stream
+    Decompressor decompressor  = {};
+};
+
+static bool reader_ctor(Stream_reader *reader, FILE *input, size_t chunk_size);
+
+static void reader_dtor(Stream_reader *reader);
+
+static bool refill_chunk(Stream_reader *reader);
+
+static char next_token(Stream_reader *reader);
+
+static bool read_text(Stream_reader *reader);
+
+static bool append_text(Stream_reader *reader, const char *part, size_t len);
+
+static bool stream_nodes(Tree *tree, Stream_reader *reader);
+
+static bool skip_to_end(Stream_reader *reader);
+
+
+bool stream_tree(Tree *tree, FILE *input, size_t chunk_size) {
+    assert(tree       != nullptr);
+    assert(input      != nullptr);
+    assert(chunk_size  > 0);
+
+    Stream_reader reader = {};
+
+    if (!reader_ctor(&reader, input, chunk_size)) {
+        reader_dtor(&reader);
+        return false;
+    }
+
+    bool result = stream_nodes(tree, &reader) && skip_to_end(&reader);
+
+    reader_dtor(&reader);
+
+    return result;
+}
+
+#define CHECK_SYM(sym)                                                                 \
+    if (next_token(reader) != sym) {                                                   \
+        if (reader->is_damaged) {                                                      \
+            return false;                                                              \
+        }                                                                              \
+        printf("Error: incorrect input file format at byte %zu.\n"                     \
+               "Expected: <%c>, got: <%c>\n", reader->offset + reader->ip, sym,       \
+               reader->chunk[reader->ip]);                                             \
+        return false;                                                                  \
+    }                                                                                  \
+    ++(reader->ip);
+
+// Same grammar as in in-place parser: parent pointers of unfinished
+// nodes are used instead of recursion.
+
+static bool stream_nodes(Tree *tree, Stream_reader *reader) {
+    assert(tree   != nullptr);
+    assert(reader != nullptr);
+
+    Node_id parent = No_node;
+
+    do {
+        CHECK_SYM('{');
+
+        CHECK_SYM('"');
+
+        if (!read_text(reader)) {
+            return false;
+        }
+
+        Text_id text = store_text(tree, reader->text, reader->text_len);
+
+        if (text == No_text) {
+            return false;
+        }
+
+        Node_id node = attach_node(tree, parent, text);
+
+        if (node == No_node) {
+            return false;
+        }
+
+        set_node_flag(tree, node, Saved_flag, true);
+
+        if (next_token(reader) != '}') {
+
+            parent = node;
+
+            continue;
+        }
+
+        ++(reader->ip);
+
+        while (parent != No_node && node_right(tree, parent) != No_node) {
+
+            CHECK_SYM('}');
+
+            parent = node_parent(tree, parent);
+        }
+
+    } while (parent != No_node);
+
+    return true;
+}
+
+#undef CHECK_SYM
+
+// Blocks after the tree are unpacked too, so damaged or cut compressed
+// data base is not taken for a whole one. Block of zero size ends it.
+
+static bool skip_to_end(Stream_reader *reader) {
+    assert(reader != nullptr);
+
+    if (!reader->is_compressed) {
+        return true;
+    }
+
+    while (refill_chunk(reader)) {
+        continue;
+    }
+
+    return !reader->is_damaged;
+}
+
+static bool reader_ctor(Stream_reader *reader, FILE *input, size_t chunk_size) {
+    assert(reader != nullptr);
+    assert(input  != nullptr);
+
+    reader->input      = input;
+    reader->chunk_size = chunk_size;
+
+    // Compressed stream is recognized by its header, otherwise
+    // read bytes are the beginning of the first chunk
+
+    Akz_header header = {};
+
+    size_t n_read = fread(&header, sizeof(char), sizeof(Akz_header), input);
+
+    if (is_compressed_data_base((const char*) &header, n_read)) {
+
+        if (!decompressor_ctor(&reader->decompressor, input, &header)) {
+            return false;
+        }
+
+        reader->is_compressed = true;
+        reader->chunk_size    = reader->decompressor.block_size;
+    }
+
+    if (reader->chunk_size < sizeof(Akz_header)) {
+        reader->chunk_size = sizeof(Akz_header);
+    }
+
+    reader->chunk = (char*) calloc(reader->chunk_size + 1, sizeof(char));
+
+    if (reader->chunk == nullptr) {
+        printf("Error: can't run akinator - not enought memory\n");
+        return false;
+    }
+
+    if (!reader->is_compressed) {
+        memcpy(reader->chunk, &header, n_read);
+
+        reader->len = n_read;
+    }
+
+    return true;
+}
+
+static void reader_dtor(Stream_reader *reader) {
+    assert(reader != nullptr);
+
+    free(reader->chunk);
+    free(reader->text);
+
+    decompressor_dtor(&reader->decompressor);
+
+    reader->chunk = nullptr;
+    reader->text  = nullptr;
+}
+
+static bool refill_chunk(Stream_reader *reader) {
+    assert(reader != nullptr);
+
+    reader->offset += reader->len;
+
+    reader->ip  = 0;
+    reader->len = 0;
+
+    if (reader->is_compressed) {
+        if (!reader->is_ended && !reader->is_damaged) {
+            reader->is_damaged = !read_compressed_block(&reader->decompressor, reader->chunk, &reader->len);
+            reader->is_ended   = !reader->is_damaged && reader->len == 0;
+        }
+    } else {
+        reader->len = fread(reader->chunk, sizeof(char), reader->chunk_size, reader->input);
+    }
+
+    reader->chunk[reader->len] = '\0';
+
+    return reader->len > 0;
+}
+
+// Skips spaces and returns next symbol without reading it, '\0' at the end of stream
+
+static char next_token(Stream_reader *reader) {
+    assert(reader != nullptr);
+
+    while (true) {
+        reader->ip = scan_spaces(reader->chunk, reader->ip);
+
+        if (reader->ip < reader->len) {
+            return reader->chunk[reader->ip];
+        }
+
+        if (!refill_chunk(reader)) {
+            return '\0';
+        }
+    }
+}
+
+// Reads text till closing quote, text may be splitted between chunks
+
+static bool read_text(Stream_reader *reader) {
+    assert(reader != nullptr);
+
+    reader->text_len = 0;
+
+    while (true) {
+        size_t end = scan_to_quote(reader->chunk, reader->ip);
+
+        if (!append_text(reader, reader->chunk + reader->ip, end - reader->ip)) {
+            printf("Error: can't run akinator - not enought memory\n");
+            return false;
+        }
+
+        reader->ip = end;
+
+        if (end < reader->len && reader->chunk[end] == '"') {
+            ++(reader->ip);
+            return true;
+        }
+
+        if (end < reader->len || !refill_chunk(reader)) {
+            if (reader->is_damaged) {
+                return false;
+            }
+
+            printf("Error: incorrect input file format at byte %zu.\n"
+                   "Unexpected end of file inside of string\n", reader->offset + reader->ip);
+            return false;
+        }
+    }
+}
+
+static bool append_text(Stream_reader *reader, const char *part, size_t len) {
+    assert(reader != nullptr);
+    assert(part   != nullptr);
+
+    if (reader->text_len + len + 1 > reader->text_cap) {
+        size_t new_cap = 2 * (reader->text_len + len + 1);
+
+        char *new_text = (char*) realloc(reader->text, new_cap);
+
+        if (new_text == nullptr) {
+            return false;
+        }
+
+        reader->text     = new_text;
+        reader->text_cap = new_cap;
+    }
+
+    memcpy(reader->text + reader->text_len, part, len);
+
+    reader->text_len += len;
+
+    return true;
+}
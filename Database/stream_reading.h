@@ -0,0 +1,17 @@
+#ifndef STREAM_READING
+#define STREAM_READING
+
+#include <stdio.h>
+
+#include "../Tree/tree.h"
+
+const size_t Stream_chunk_size = 1 << 16;
+
+// Builds tree from text data base read from stream by chunks of chunk_size bytes.
+// Node texts are copied into tree's text storage, so only one chunk
+// of input is kept in memory during loading. Compressed data base is
+// read by unpacked blocks instead of chunks.
+
+bool stream_tree(Tree *tree, FILE *input, size_t chunk_size);
+
+#endif
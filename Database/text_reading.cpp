@@ -0,0 +1,531 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <atomic>
+
+#include "text_reading.h"
+#include "../Libs/scanning.h"
+
+struct Parallel_reading {
+    Tree*               tree       = nullptr;
+    char*               text       = nullptr;
+    Deferred_nodes*     deferred   = nullptr;
+    std::atomic<size_t> next       = 0;
+    std::atomic<bool>   is_correct = true;
+    std::atomic<Node_id> next_id   = No_node;  // first id not taken by threads
+};
+
+static void* read_deferred_nodes(void *reading_ptr);
+
+static size_t get_parallel_depth(size_t n_threads);
+
+static size_t count_open_braces(const char *text);
+
+static bool defer_node(Deferred_nodes *deferred, Node_id node, size_t ip);
+
+static const Subtree_index_entry* find_subtree(const Subtree_index *index, size_t children);
+
+static bool push_entry_number(size_t **stack, size_t *size, size_t *capacity, size_t number);
+
+
+bool read_text_tree(Tree *tree, char *text) {
+    assert(tree != nullptr);
+    assert(text != nullptr);
+
+    size_t ip = 0;
+
+    return read_text_subtree(tree, text, &ip, No_node, Unlimited_depth, nullptr);
+}
+
+bool read_text_tree_parallel(Tree *tree, char *text, size_t n_threads) {
+    assert(tree != nullptr);
+    assert(text != nullptr);
+
+    if (n_threads <= 1) {
+        return read_text_tree(tree, text);
+    }
+
+    // Every node begins with '{', every thread can leave a part of its last chunk unused.
+    // Braces are counted before texts are ended with '\0' by reading.
+
+    if (!reserve_tree_capacity(tree, count_open_braces(text) + n_threads * Node_chunk_size)) {
+        printf("Error: can't run akinator - not enought memory\n");
+        return false;
+    }
+
+    Deferred_nodes deferred = {};
+
+    size_t ip = 0;
+
+    if (!read_text_subtree(tree, text, &ip, No_node, get_parallel_depth(n_threads), &deferred)) {
+        deferred_nodes_dtor(&deferred);
+        return false;
+    }
+
+    Parallel_reading reading = {};
+
+    reading.tree     = tree;
+    reading.text     = text;
+    reading.deferred = &deferred;
+    reading.next_id  = tree->n_nodes;
+
+    pthread_t *threads = (pthread_t*) calloc(n_threads - 1, sizeof(pthread_t));
+
+    size_t n_started = 0;
+
+    // Calling thread reads subtrees too, so if threads can't be started
+    // all the work is just done by it
+
+    for (; threads != nullptr && n_started < n_threads - 1; ++n_started) {
+        if (pthread_create(&threads[n_started], nullptr, read_deferred_nodes, &reading) != 0) {
+            break;
+        }
+    }
+
+    read_deferred_nodes(&reading);
+
+    for (size_t i = 0; i < n_started; ++i) {
+        pthread_join(threads[i], nullptr);
+    }
+
+    free(threads);
+
+    deferred_nodes_dtor(&deferred);
+
+    // Ids taken by threads become used ones, unfilled ids of their last chunks stay empty
+
+    tree->n_nodes = (reading.next_id < tree->capacity) ? reading.next_id.load() : tree->capacity;
+
+    return reading.is_correct;
+}
+
+static void* read_deferred_nodes(void *reading_ptr) {
+    assert(reading_ptr != nullptr);
+
+    Parallel_reading *reading = (Parallel_reading*) reading_ptr;
+
+    Node_range range = {};
+
+    range.source = &reading->next_id;
+
+    while (reading->is_correct) {
+        size_t i = reading->next++;
+
+        if (i >= reading->deferred->size) {
+            break;
+        }
+
+        Deferred_node *deferred = &reading->deferred->data[i];
+
+        if (!read_text_subtree(reading->tree, reading->text, &deferred->ip, deferred->node, 
+                               Unlimited_depth, nullptr, nullptr, &range)) {
+            reading->is_correct = false;
+        }
+    }
+
+    return nullptr;
+}
+
+// Depth at which there are place for Subtrees_per_thread subtrees
+// for each thread in balanced tree
+
+static size_t get_parallel_depth(size_t n_threads) {
+    size_t depth = 1;
+
+    while ((size_t) 1 << (depth - 1) < Subtrees_per_thread * n_threads) {
+        ++depth;
+    }
+
+    return depth;
+}
+
+// Braces inside of texts are counted too, so it is an upper bound of number of nodes
+
+static size_t count_open_braces(const char *text) {
+    assert(text != nullptr);
+
+    size_t n_braces = 0;
+
+    for (const char *brace = strchr(text, '{'); brace != nullptr; brace = strchr(brace + 1, '{')) {
+        ++n_braces;
+    }
+
+    return n_braces;
+}
+
+#define SKIP_SPACES(ip)                                 \
+        ip = scan_spaces(text, ip);
+
+#define SKIP_STRING(ip)                                                                  \
+        ip = scan_to_quote(text, ip);                                                    \
+        if (text[ip] == '\0') {                                                          \
+            printf("Error: incorrect input file format at byte %zu.\n"                   \
+                   "Unexpected end of file inside of string\n", ip);                     \
+            return false;                                                                \
+        }                                                                                \
+        ++ip;
+
+#define SET_STRING_ENDING(ip)                 \
+        text[ip - 1] = '\0';
+
+#define CHECK_SYM(sym, ip)                                                          \
+    if (text[ip] != sym) {                                                          \
+        printf("Error: incorrect input file format at byte %zu.\n"                  \
+               "Expected: <%c>, got: <%c>\n", ip, sym, text[ip]);                   \
+        return false;                                                               \
+    }                                                                               \
+    ++ip;
+
+// Tree is built without recursion: parent pointers of already created nodes
+// are used as a stack of unfinished nodes, so depth of the tree is limited
+// only by memory.
+
+bool read_text_subtree(Tree *tree, char *text, size_t *ip_ptr, Node_id top, size_t max_depth, 
+                       Deferred_nodes *deferred, const Subtree_index *index, Node_range *range) {
+    assert(tree   != nullptr);
+    assert(text   != nullptr);
+    assert(ip_ptr != nullptr);
+    assert(text   == tree->strings.text);
+
+    if (top != No_node) {
+        set_node_flag(tree, top, Deferred_flag, false);
+    }
+
+    size_t ip = *ip_ptr;
+
+    SKIP_SPACES(ip);
+
+    if (top != No_node && text[ip] == '}') {
+        *ip_ptr = ip + 1;
+        return true;
+    }
+
+    Node_id parent = top;
+
+    size_t depth = 0;
+
+    while (true) {
+        SKIP_SPACES(ip);
+
+        CHECK_SYM('{', ip);
+
+        SKIP_SPACES(ip);
+
+        CHECK_SYM('"', ip);
+
+        size_t text_start = ip;
+
+        SKIP_STRING(ip);
+
+        SET_STRING_ENDING(ip);
+
+        Text_id stored = intern_text(tree, text_start, ip - 1 - text_start);
+
+        if (stored == No_text) {
+            return false;
+        }
+
+        Node_id node = attach_node(tree, parent, stored, range);
+
+        if (node == No_node) {
+            return false;
+        }
+
+        set_node_flag(tree, node, Saved_flag, true);
+
+        SKIP_SPACES(ip);
+
+        if (text[ip] != '}' && depth + 1 < max_depth) {
+
+            parent = node;
+
+            ++depth;
+
+            continue;
+        }
+
+        if (text[ip] != '}') {
+
+            set_node_flag(tree, node, Deferred_flag, true);
+
+            if (deferred != nullptr && !defer_node(deferred, node, ip)) {
+                printf("Error: can't run akinator - not enought memory\n");
+                return false;
+            }
+
+            if (!skip_text_subtree(text, &ip, index)) {
+                return false;
+            }
+
+        } else {
+
+            ++ip;
+        }
+
+        while (parent != top && node_right(tree, parent) != No_node) {
+
+            SKIP_SPACES(ip);
+
+            CHECK_SYM('}', ip);
+
+            parent = node_parent(tree, parent);
+
+            --depth;
+        }
+
+        if (parent == top && (top == No_node || node_right(tree, top) != No_node)) {
+            break;
+        }
+    }
+
+    if (top != No_node) {
+
+        SKIP_SPACES(ip);
+
+        CHECK_SYM('}', ip);
+    }
+
+    *ip_ptr = ip;
+
+    return true;
+}
+
+// Skips rest of node which children start at text[*ip], including its closing brace
+
+bool skip_text_subtree(const char *text, size_t *ip_ptr, const Subtree_index *index) {
+    assert(text   != nullptr);
+    assert(ip_ptr != nullptr);
+
+    size_t ip = *ip_ptr;
+
+    if (index != nullptr) {
+        const Subtree_index_entry *entry = find_subtree(index, ip);
+
+        if (entry != nullptr) {
+            *ip_ptr = entry->end;
+            return true;
+        }
+    }
+
+    size_t depth = 1;
+
+    while (depth > 0) {
+        ip = scan_to_structural(text, ip);
+
+        switch (text[ip]) {
+            case '{':
+                ++depth;
+                ++ip;
+                break;
+
+            case '}':
+                --depth;
+                ++ip;
+                break;
+
+            case '"':
+                ++ip;
+                SKIP_STRING(ip);
+                break;
+
+            default:
+                printf("Error: incorrect input file format at byte %zu.\n"
+                       "Unexpected end of file inside of node\n", ip);
+                return false;
+        }
+    }
+
+    *ip_ptr = ip;
+
+    return true;
+}
+
+// Index is built by one pass over structural symbols. Entry for node is added
+// when its first child is met, so entries are sorted by offset of children.
+// Stack keeps number of entry (or No_entry) for every open node.
+
+bool build_subtree_index(const char *text, Subtree_index *index) {
+    assert(text  != nullptr);
+    assert(index != nullptr);
+
+    const size_t No_entry = SIZE_MAX;
+
+    size_t *stack    = nullptr;
+    size_t  size     = 0;
+    size_t  capacity = 0;
+
+    size_t entries_capacity = 0;
+
+    bool is_correct = true;
+
+    size_t ip = 0;
+
+    while (is_correct) {
+        ip = scan_to_structural(text, ip);
+
+        if (text[ip] == '\0') {
+            break;
+        }
+
+        if (text[ip] == '"') {
+            ip = scan_to_quote(text, ip + 1);
+
+            if (text[ip] == '\0') {
+                is_correct = false;
+                break;
+            }
+
+            ++ip;
+            continue;
+        }
+
+        if (text[ip] == '}') {
+            if (size == 0) {
+                is_correct = false;
+                break;
+            }
+
+            --size;
+
+            if (stack[size] != No_entry) {
+                index->entries[stack[size]].end = ip + 1;
+            }
+
+            ++ip;
+            continue;
+        }
+
+        if (size > 0 && stack[size - 1] == No_entry) {
+            if (index->size == entries_capacity) {
+                entries_capacity = 2 * entries_capacity + 1;
+
+                Subtree_index_entry *entries = (Subtree_index_entry*) realloc(index->entries,
+                                                 entries_capacity * sizeof(Subtree_index_entry));
+
+                if (entries == nullptr) {
+                    is_correct = false;
+                    break;
+                }
+
+                index->entries = entries;
+            }
+
+            index->entries[index->size].children = ip;
+            index->entries[index->size].end      = 0;
+
+            stack[size - 1] = index->size++;
+        }
+
+        if (!push_entry_number(&stack, &size, &capacity, No_entry)) {
+            is_correct = false;
+            break;
+        }
+
+        ++ip;
+    }
+
+    free(stack);
+
+    if (!is_correct || size != 0) {
+        printf("Error: incorrect input file format: braces or quotes do not match\n");
+
+        free(index->entries);
+
+        index->entries = nullptr;
+        index->size    = 0;
+
+        return false;
+    }
+
+    return true;
+}
+
+static bool push_entry_number(size_t **stack, size_t *size, size_t *capacity, size_t number) {
+    assert(stack    != nullptr);
+    assert(size     != nullptr);
+    assert(capacity != nullptr);
+
+    if (*size == *capacity) {
+        size_t new_capacity = 2 * (*capacity) + 1;
+
+        size_t *new_stack = (size_t*) realloc(*stack, new_capacity * sizeof(size_t));
+
+        if (new_stack == nullptr) {
+            return false;
+        }
+
+        *stack    = new_stack;
+        *capacity = new_capacity;
+    }
+
+    (*stack)[(*size)++] = number;
+
+    return true;
+}
+
+static const Subtree_index_entry* find_subtree(const Subtree_index *index, size_t children) {
+    assert(index != nullptr);
+
+    size_t left  = 0;
+    size_t right = index->size;
+
+    while (left < right) {
+        size_t middle = left + (right - left) / 2;
+
+        if (index->entries[middle].children < children) {
+            left = middle + 1;
+        } else {
+            right = middle;
+        }
+    }
+
+    if (left < index->size && index->entries[left].children == children) {
+        return &index->entries[left];
+    }
+
+    return nullptr;
+}
+
+#undef SKIP_SPACES
+#undef SKIP_STRING
+#undef SET_STRING_ENDING
+#undef CHECK_SYM
+
+static bool defer_node(Deferred_nodes *deferred, Node_id node, size_t ip) {
+    assert(deferred != nullptr);
+    assert(node     != No_node);
+
+    if (deferred->size == deferred->capacity) {
+        size_t capacity = 2 * deferred->capacity + 1;
+
+        Deferred_node *data = (Deferred_node*) realloc(deferred->data, 
+                                                       capacity * sizeof(Deferred_node));
+
+        if (data == nullptr) {
+            return false;
+        }
+
+        deferred->data     = data;
+        deferred->capacity = capacity;
+    }
+
+    deferred->data[deferred->size].node = node;
+    deferred->data[deferred->size].ip   = ip;
+
+    ++(deferred->size);
+
+    return true;
+}
+
+void deferred_nodes_dtor(Deferred_nodes *deferred) {
+    assert(deferred != nullptr);
+
+    free(deferred->data);
+
+    deferred->data     = nullptr;
+    deferred->size     = 0;
+    deferred->capacity = 0;
+}
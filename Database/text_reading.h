@@ -0,0 +1,63 @@
+#ifndef TEXT_READING
+#define TEXT_READING
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../Tree/tree.h"
+
+// Text data base is parsed in place: node texts are ended with '\0'
+// right in the text and nodes keep their offsets. Text should be set
+// as tree's data base text by set_tree_text() before reading.
+
+const size_t Unlimited_depth = SIZE_MAX;
+
+struct Deferred_node {
+    Node_id    node = No_node;
+    size_t     ip   = 0;        // offset of node's children in the text
+};
+
+struct Deferred_nodes {
+    Deferred_node* data     = nullptr;
+    size_t         size     = 0;
+    size_t         capacity = 0;
+};
+
+// Index of subtrees maps offset of node's children to offset after node's end.
+// Entries are sorted by offset of children.
+
+struct Subtree_index_entry {
+    uint64_t children;
+    uint64_t end;
+};
+
+struct Subtree_index {
+    Subtree_index_entry* entries = nullptr;
+    size_t               size    = 0;
+};
+
+const size_t Subtrees_per_thread = 8;
+
+bool read_text_tree(Tree *tree, char *text);
+
+// Top levels of the tree are read by calling thread, deeper subtrees are
+// distributed between n_threads threads.
+
+bool read_text_tree_parallel(Tree *tree, char *text, size_t n_threads);
+
+// Reads children of top node, which start at text[*ip] (whole tree if top is No_node).
+// Children of nodes max_depth levels below top are skipped (using index if it is given),
+// these nodes are marked as deferred and added to deferred list if it is given.
+// They can be read later by another call. Nodes get ids from range if it is given.
+
+bool read_text_subtree(Tree *tree, char *text, size_t *ip, Node_id top, size_t max_depth, 
+                       Deferred_nodes *deferred, const Subtree_index *index = nullptr,
+                                                 Node_range *range = nullptr);
+
+bool skip_text_subtree(const char *text, size_t *ip, const Subtree_index *index = nullptr);
+
+bool build_subtree_index(const char *text, Subtree_index *index);
+
+void deferred_nodes_dtor(Deferred_nodes *deferred);
+
+#endif
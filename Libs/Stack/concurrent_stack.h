@@ -0,0 +1,158 @@
+#ifndef CONCURRENT_STACK
+#define CONCURRENT_STACK
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <type_traits>
+
+// Lock-free stack of trivially copyable elements shared by threads
+// (Treiber stack). Elements are kept in cells of fixed array, free cells
+// make the second stack. Top of both stacks is number of cell + 1 (0 for
+// empty stack) with tag in high half of the word. Tag is changed by every
+// push, so pop which saw the same top before cell was popped and pushed
+// again fails instead of linking stack to wrong cell (ABA).
+//
+// Cells are never freed while stack is alive, so next of cell popped by
+// other thread can be read safely, it is just thrown away by failed swap.
+// Value of cell is read only after pop took it.
+//
+// Stack is full when all cells are busy, push returns false then.
+
+template <typename Elem>
+struct Concurrent_cell {
+    Elem                  value = {};
+    std::atomic<uint32_t> next  = 0;
+};
+
+template <typename Elem>
+struct Concurrent_stack {
+    static_assert(std::is_trivially_copyable_v<Elem>, "elements are copied between threads");
+
+    Concurrent_cell<Elem>*  cells      = nullptr;
+    uint32_t                capacity   = 0;
+    std::atomic<uint64_t>   top        = 0;
+    char                    padding[64 - sizeof(std::atomic<uint64_t>)] = {};     // tops on different cache lines
+    std::atomic<uint64_t>   free_top   = 0;
+};
+
+const uint64_t Concurrent_tag_step = 1ull << 32;
+const uint32_t Max_concurrent_size = UINT32_MAX - 1;
+
+/*----------------------------------- INTERNAL FUNCTIONS -----------------------------------------*/
+
+inline uint32_t ConcurrentCell(uint64_t top) {
+    return (uint32_t) top;
+}
+
+template <typename Elem>
+inline void PushConcurrentCell(Concurrent_stack<Elem> *stk, std::atomic<uint64_t> *top, uint32_t cell) {
+    uint64_t old_top = top->load(std::memory_order_relaxed);
+    uint64_t new_top = 0;
+
+    do {
+        stk->cells[cell - 1].next.store(ConcurrentCell(old_top), std::memory_order_relaxed);
+
+        new_top = (old_top & ~(Concurrent_tag_step - 1)) + Concurrent_tag_step + cell;
+
+    } while (!top->compare_exchange_weak(old_top, new_top, std::memory_order_release,
+                                                           std::memory_order_relaxed));
+}
+
+// Returns number of taken cell + 1, 0 if stack is empty
+
+template <typename Elem>
+inline uint32_t PopConcurrentCell(Concurrent_stack<Elem> *stk, std::atomic<uint64_t> *top) {
+    uint64_t old_top = top->load(std::memory_order_acquire);
+    uint64_t new_top = 0;
+
+    do {
+        if (ConcurrentCell(old_top) == 0) {
+            return 0;
+        }
+
+        uint32_t next = stk->cells[ConcurrentCell(old_top) - 1].next.load(std::memory_order_relaxed);
+
+        new_top = (old_top & ~(Concurrent_tag_step - 1)) + next;
+
+    } while (!top->compare_exchange_weak(old_top, new_top, std::memory_order_acquire,
+                                                           std::memory_order_acquire));
+
+    return ConcurrentCell(old_top);
+}
+
+/*-------------------------------- EXTERNAL FUNCTIONS --------------------------------------------*/
+
+// Not thread safe, stack is created before threads start using it
+
+template <typename Elem>
+bool ConcurrentStackCtr(Concurrent_stack<Elem> *stk, size_t capacity) {
+    if (stk == nullptr || capacity == 0 || capacity > Max_concurrent_size) {
+        return false;
+    }
+
+    stk->cells = (Concurrent_cell<Elem>*) calloc(capacity, sizeof(Concurrent_cell<Elem>));
+
+    if (stk->cells == nullptr) {
+        return false;
+    }
+
+    stk->capacity = (uint32_t) capacity;
+
+    for (uint32_t i = 0; i < stk->capacity; ++i) {
+        stk->cells[i].next.store(i + 2 <= stk->capacity ? i + 2 : 0, std::memory_order_relaxed);
+    }
+
+    stk->top.store(0, std::memory_order_relaxed);
+    stk->free_top.store(1, std::memory_order_release);
+
+    return true;
+}
+
+template <typename Elem>
+void ConcurrentStackDestr(Concurrent_stack<Elem> *stk) {
+    if (stk == nullptr) {
+        return;
+    }
+
+    free(stk->cells);
+
+    stk->cells    = nullptr;
+    stk->capacity = 0;
+
+    stk->top.store(0, std::memory_order_relaxed);
+    stk->free_top.store(0, std::memory_order_relaxed);
+}
+
+template <typename Elem>
+bool ConcurrentStackPush(Concurrent_stack<Elem> *stk, Elem value) {
+    uint32_t cell = PopConcurrentCell(stk, &stk->free_top);
+
+    if (cell == 0) {
+        return false;
+    }
+
+    stk->cells[cell - 1].value = value;
+
+    PushConcurrentCell(stk, &stk->top, cell);
+
+    return true;
+}
+
+template <typename Elem>
+bool ConcurrentStackPop(Concurrent_stack<Elem> *stk, Elem *value) {
+    uint32_t cell = PopConcurrentCell(stk, &stk->top);
+
+    if (cell == 0) {
+        return false;
+    }
+
+    *value = stk->cells[cell - 1].value;
+
+    PushConcurrentCell(stk, &stk->free_top, cell);
+
+    return true;
+}
+
+#endif
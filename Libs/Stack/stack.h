@@ -2,14 +2,26 @@
 #define STACK
 
 #include <stdio.h>
-#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
-#include "../../Tree/tree.h"
+#include <type_traits>
 
-typedef struct Tree_node* Elem_t;
-const Elem_t Poisoned_cell = nullptr;
-
-#define PFORMAT "%-10d"
+// Stack of any trivially copyable elements. First Inline_size elements are
+// kept in the stack itself, so short stacks never take memory from heap.
+// Larger stacks move to heap buffer which grows twice at a time and is
+// halved only when less than a quarter of it is used, so pushes and pops
+// around any size reallocate no more than once per capacity/4 operations.
+// Pops never shrink stack below the reserved capacity.
+//
+// Checks of stack are chosen at compile time by Checks flags: canaries
+// around the stack and its heap buffer, hash of elements, poisoned free
+// cells (value-initialized element is poison) and deep look through all
+// cells. Stack with any checks verifies itself on every operation and dumps
+// errors to log stream, stack without them only pushes and pops. Debug
+// builds check everything by default.
+//
+// Stack keeps pointer to its own elements, so it can be moved but not copied.
 
 typedef unsigned long long Canary_t;
 const Canary_t Border = 0XBAAD7004;
@@ -25,16 +37,6 @@ typedef struct {
     Canary_t     right_border;
 } Logs;
 
-typedef struct {
-    Canary_t  left_border;
-    Elem_t*   data;
-    size_t    size;
-    size_t    capacity;
-    size_t    hash;
-    Logs*     logs;
-    Canary_t  right_border;
-} Stack;
-
 typedef enum {
     NO_ERROR         = 0,
     HASH_CALC_ERR    = 1,
@@ -56,15 +58,422 @@ typedef enum {
     LGS_BRDR_CHANGED = 1 << 16,
 } Error;
 
+inline int ErrorIsThere(int errors, Error error) {
+    return (errors & error);
+}
+
+typedef enum {
+    No_checks     = 0,
+    Canary_checks = 1,
+    Hash_checks   = 1 << 1,
+    Poison_checks = 1 << 2,
+    Deep_checks   = 1 << 3 | Poison_checks,    // deep check needs poisoned cells
+    All_checks    = Canary_checks | Hash_checks | Deep_checks,
+} Stack_checks;
+
+#ifdef _DEBUG
+const unsigned Default_stack_checks = All_checks;
+#else
+const unsigned Default_stack_checks = No_checks;
+#endif
+
+constexpr bool HasChecks(unsigned checks, Stack_checks wanted) {
+    return (checks & (unsigned) wanted) == (unsigned) wanted;
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks = Default_stack_checks>
+struct Stack {
+    static_assert(Inline_size > 0, "stack should have place for inline elements");
+    static_assert(std::is_trivially_copyable_v<Elem>, "elements are moved by memcpy");
+
+    Canary_t  left_border  = Border;
+    Elem*     data         = inline_data;
+    size_t    size         = 0;
+    size_t    capacity     = Inline_size;
+    size_t    reserved     = 0;                 // capacity kept by pops
+    size_t    hash         = Hash_base_const;
+    Logs      logs         = {Border, 0, nullptr, nullptr, Border};
+    Elem      inline_data[Inline_size] = {};
+    Canary_t  right_border = Border;        // right after inline elements
+
+    Stack() = default;
+
+    Stack(const Stack&)            = delete;
+    Stack& operator=(const Stack&) = delete;
+
+    Stack(Stack &&other) noexcept;
+    Stack& operator=(Stack &&other) noexcept;
+
+    ~Stack();
+};
+
 #define StackCtr(stk, n_elem)                                                 \
         StackCtrWithLogs(stk, n_elem, __LINE__, __PRETTY_FUNCTION__, __FILE__)
 
-int StackCtrWithLogs(Stack *stk, size_t n_elem, int line, const char* func, const char* file);
-int StackDestr(Stack *stk);
-int StackPush(Stack *stk, Elem_t value);
-Elem_t StackPop(Stack *stk, int *err = nullptr);
-Error ResizeStack(Stack *stk, size_t capacity);
-Error PoisonCells(Stack *stk, size_t n_cells);
-int IsPoisoned(Elem_t el1);
+#define StackVerificator(stk) \
+    RealStackVerificator(stk, __FILE__, __PRETTY_FUNCTION__, __LINE__)
+#define SafeStackVerificator(stk) \
+    RealSafeStackVerificator(stk, __FILE__, __PRETTY_FUNCTION__, __LINE__)
+
+template <typename Elem>
+inline int IsPoisoned(Elem elem) {
+    const Elem poison = {};
+
+    return memcmp(&elem, &poison, sizeof(Elem)) == 0;
+}
+
+// Hash of element is taken from its bytes, so elements of any type are hashed
+
+template <typename Elem>
+inline size_t ElemHash(Elem elem) {
+    const unsigned char *bytes = (const unsigned char*) &elem;
+
+    size_t hash = 0;
+
+    for (size_t i = 0; i < sizeof(Elem); ++i) {
+        hash = hash * Hash_mult_const + bytes[i];
+    }
+
+    return hash;
+}
+
+/*----------------------------------- INTERNAL FUNCTIONS -----------------------------------------*/
+
+// Heap buffer of stack with canaries is surrounded by canaries. They are copied
+// by memcpy, because buffer of small elements is not aligned for them.
+
+template <typename Elem>
+inline Elem* AllocStackData(size_t capacity, bool has_borders) {
+    if (!has_borders) {
+        return (Elem*) malloc(capacity * sizeof(Elem));
+    }
+
+    char *buffer = (char*) malloc(capacity * sizeof(Elem) + 2 * sizeof(Canary_t));
+
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+
+    memcpy(buffer,                                             &Border, sizeof(Canary_t));
+    memcpy(buffer + sizeof(Canary_t) + capacity * sizeof(Elem), &Border, sizeof(Canary_t));
+
+    return (Elem*) (void*) (buffer + sizeof(Canary_t));
+}
+
+// Elements stay in place, right canary is moved to the new end of buffer
+
+template <typename Elem>
+inline Elem* ReallocStackData(Elem *data, size_t capacity, bool has_borders) {
+    if (!has_borders) {
+        return (Elem*) realloc(data, capacity * sizeof(Elem));
+    }
+
+    char *buffer = (char*) realloc((char*) data - sizeof(Canary_t), capacity * sizeof(Elem) + 2 * sizeof(Canary_t));
+
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+
+    memcpy(buffer + sizeof(Canary_t) + capacity * sizeof(Elem), &Border, sizeof(Canary_t));
+
+    return (Elem*) (void*) (buffer + sizeof(Canary_t));
+}
+
+template <typename Elem>
+inline void FreeStackData(Elem *data, bool has_borders) {
+    if (data == nullptr) {
+        return;
+    }
+
+    free(has_borders ? (char*) data - sizeof(Canary_t) : (char*) data);
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+inline void GetDataBorders(const Stack<Elem, Inline_size, Checks> *stk, Canary_t *l_border, Canary_t *r_border) {
+    const char *data = (const char*) stk->data;
+
+    memcpy(l_border, data - sizeof(Canary_t),              sizeof(Canary_t));
+    memcpy(r_border, data + stk->capacity * sizeof(Elem), sizeof(Canary_t));
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+inline bool IsStackInline(const Stack<Elem, Inline_size, Checks> *stk) {
+    return stk->data == stk->inline_data;
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+inline void ResetStack(Stack<Elem, Inline_size, Checks> *stk) {
+    stk->data     = stk->inline_data;
+    stk->size     = 0;
+    stk->capacity = Inline_size;
+    stk->reserved = 0;
+    stk->hash     = Hash_base_const;
+}
+
+// Stack which elements are inline takes copy of them, heap buffer is just taken
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+inline void MoveStack(Stack<Elem, Inline_size, Checks> *stk, Stack<Elem, Inline_size, Checks> *other) {
+    if (IsStackInline(other)) {
+        memcpy(stk->inline_data, other->inline_data, sizeof(stk->inline_data));
+
+        stk->data = stk->inline_data;
+    } else {
+        stk->data = other->data;
+    }
+
+    stk->size     = other->size;
+    stk->capacity = other->capacity;
+    stk->reserved = other->reserved;
+    stk->hash     = other->hash;
+    stk->logs     = other->logs;
+
+    ResetStack(other);
+}
+
+/*-------------------------------- EXTERNAL FUNCTIONS --------------------------------------------*/
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+Error PoisonCells(Stack<Elem, Inline_size, Checks> *stk, size_t n_cells) {
+    Error err = NO_ERROR;
+
+    if (stk->size + n_cells > stk->capacity) {
+        err = SIZE_EXCEED_CAP;
+    }
+
+    for (size_t i = 0; i < n_cells && stk->size + i < stk->capacity; ++i) {
+        stk->data[stk->size + i] = Elem {};
+    }
+
+    return err;
+}
+
+// Elements are moved back to stack when they fit into it
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+Error ResizeStack(Stack<Elem, Inline_size, Checks> *stk, size_t capacity) {
+    if (stk == nullptr) {
+        return STCK_PTR_CRASHED;
+    }
+
+    if (capacity < stk->size) {
+        return SIZE_EXCEED_CAP;
+    }
+
+    if (capacity <= Inline_size) {
+        capacity = Inline_size;
+    }
+
+    if (capacity == stk->capacity) {
+        return NO_ERROR;
+    }
+
+    const bool has_borders = HasChecks(Checks, Canary_checks);
+
+    Elem *data = stk->inline_data;
+
+    if (capacity > Inline_size && !IsStackInline(stk)) {
+        data = ReallocStackData(stk->data, capacity, has_borders);
+
+        if (data == nullptr) {
+            return MEMORY_EXCEED;
+        }
+
+    } else {
+        if (capacity > Inline_size) {
+            data = AllocStackData<Elem>(capacity, has_borders);
+
+            if (data == nullptr) {
+                return MEMORY_EXCEED;
+            }
+        }
+
+        memcpy(data, stk->data, stk->size * sizeof(Elem));
+
+        if (!IsStackInline(stk)) {
+            FreeStackData(stk->data, has_borders);
+        }
+    }
+
+    stk->data     = data;
+    stk->capacity = capacity;
+
+    if constexpr (HasChecks(Checks, Poison_checks)) {
+        PoisonCells(stk, capacity - stk->size);
+    }
+
+    return NO_ERROR;
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+int StackCtrWithLogs(Stack<Elem, Inline_size, Checks> *stk, size_t n_elem,
+                     int line, const char* func, const char* file) {
+    stk->logs.file_of_creation = file;
+    stk->logs.func_of_creation = func;
+    stk->logs.line_of_creation = line;
+
+    int errors = StackReserve(stk, n_elem);
+
+    if constexpr (Checks != No_checks) {
+        errors |= SafeStackVerificator(stk);
+    }
+
+    return errors;
+}
+
+// Capacity becomes at least n_elem and pops keep it
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+Error StackReserve(Stack<Elem, Inline_size, Checks> *stk, size_t n_elem) {
+    if (stk == nullptr) {
+        return STCK_PTR_CRASHED;
+    }
+
+    if (stk->reserved < n_elem) {
+        stk->reserved = n_elem;
+    }
+
+    if (stk->capacity >= n_elem) {
+        return NO_ERROR;
+    }
+
+    return ResizeStack(stk, n_elem);
+}
+
+// Reservation is dropped, heap buffer is cut to the elements or freed
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+Error StackShrinkToFit(Stack<Elem, Inline_size, Checks> *stk) {
+    if (stk == nullptr) {
+        return STCK_PTR_CRASHED;
+    }
+
+    stk->reserved = 0;
+
+    return ResizeStack(stk, stk->size);
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+int StackDestr(Stack<Elem, Inline_size, Checks> *stk) {
+    int errors = NO_ERROR;
+
+    if constexpr (Checks != No_checks) {
+        errors |= SafeStackVerificator(stk);
+    }
+
+    if (!IsStackInline(stk)) {
+        FreeStackData(stk->data, HasChecks(Checks, Canary_checks));
+    }
+
+    ResetStack(stk);
+
+    return errors;
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+int StackPush(Stack<Elem, Inline_size, Checks> *stk, Elem value) {
+    int errors = NO_ERROR;
+
+    if constexpr (Checks != No_checks) {
+        errors |= SafeStackVerificator(stk);
+    }
+
+    if (stk->size == stk->capacity) {
+        errors |= ResizeStack(stk, 2 * stk->capacity);
+
+        if (stk->size == stk->capacity) {
+            return errors;
+        }
+    }
+
+    if constexpr (HasChecks(Checks, Poison_checks)) {
+        if ((stk->size != 0 && IsPoisoned(stk->data[stk->size - 1])) || !IsPoisoned(stk->data[stk->size])) {
+            errors |= UNEXPECTED_PSN;
+        }
+    }
+
+    if constexpr (HasChecks(Checks, Hash_checks)) {
+        stk->hash = stk->hash * Hash_mult_const + ElemHash(value);
+    }
+
+    stk->data[stk->size] = value;
+    ++(stk->size);
+
+    return errors;
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+Elem StackPop(Stack<Elem, Inline_size, Checks> *stk, int *err = nullptr) {
+    if (stk == nullptr) {
+        return Elem {};
+    }
+
+    int errors = NO_ERROR;
+
+    if constexpr (Checks != No_checks) {
+        errors |= SafeStackVerificator(stk);
+    }
+
+    if (stk->size == 0) {
+        errors |= EMPTY_STACK;
+
+        if (err != nullptr) {
+            *err = errors;
+        }
+
+        return Elem {};
+    }
+
+    --(stk->size);
+
+    Elem popped_el = stk->data[stk->size];
+
+    if constexpr (HasChecks(Checks, Poison_checks)) {
+        errors |= PoisonCells(stk, 1);
+    }
+
+    if constexpr (HasChecks(Checks, Hash_checks)) {
+        stk->hash = StackHash(stk);
+    }
+
+    if (stk->size < stk->capacity / 4 && stk->capacity > Inline_size && stk->capacity / 2 >= stk->reserved) {
+        errors |= ResizeStack(stk, stk->capacity / 2);
+    }
+
+    if (err != nullptr) {
+        *err = errors;
+    }
+
+    return popped_el;
+}
+
+/*--------------------------------- SPECIAL MEMBERS ----------------------------------------------*/
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+Stack<Elem, Inline_size, Checks>::Stack(Stack &&other) noexcept {
+    MoveStack(this, &other);
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+Stack<Elem, Inline_size, Checks>& Stack<Elem, Inline_size, Checks>::operator=(Stack &&other) noexcept {
+    if (this != &other) {
+        if (!IsStackInline(this)) {
+            FreeStackData(data, HasChecks(Checks, Canary_checks));
+        }
+
+        MoveStack(this, &other);
+    }
+
+    return *this;
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+Stack<Elem, Inline_size, Checks>::~Stack() {
+    if (!IsStackInline(this)) {
+        FreeStackData(data, HasChecks(Checks, Canary_checks));
+    }
+}
+
+#include "stack_verification.h"
 
 #endif
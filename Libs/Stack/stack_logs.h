@@ -4,13 +4,15 @@
 #define LOGS_TO_FILE
 //#define LOGS_TO_CONSOLE
 
+#include <type_traits>
+
 #include "stack.h"
 #include "stack_verification.h"
 
 #ifdef LOGS_TO_FILE
 #define DumpLogs(stk, logfile) RealDumpLogs(stk, logfile, __FILE__, __PRETTY_FUNCTION__, \
                                                           __LINE__, StackVerificator(stk))
-#else 
+#else
 #ifdef LOGS_TO_CONSOLE
 #define DumpLogs(stk) RealDumpLogs(stk, stdout, __FILE__, __PRETTY_FUNCTION__, \
                                                 __LINE__, StackVerificator(stk))
@@ -20,7 +22,130 @@
 #endif
 #endif
 
-void RealDumpLogs(Stack *stk, FILE *logfile, const char *file, const char *func, int line, int errors);
 void Print(FILE *logs, const char *format, ...);
 
+// Integer elements are printed as numbers, others as their bytes
+
+template <typename Elem>
+void PrintElem(FILE *logfile, Elem elem) {
+    if constexpr (std::is_integral_v<Elem>) {
+        Print(logfile, "%-10llu", (unsigned long long) elem);
+    } else {
+        const unsigned char *bytes = (const unsigned char*) &elem;
+
+        for (size_t i = 0; i < sizeof(Elem); ++i) {
+            Print(logfile, "%02x", bytes[i]);
+        }
+    }
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+void RealDumpLogs(Stack<Elem, Inline_size, Checks> *stk, FILE *logfile, const char *file,
+                  const char *func, int line, int errors) {
+    if (logfile == nullptr) {
+        return;
+    }
+
+    if (stk == nullptr) {
+        Print(logfile, "Can't print logfile: pointer to stack is crushed");
+        return;
+    }
+
+    Print(logfile, "Logs called in %s at %s(%d):\n", func, file, line);
+
+    if (ErrorIsThere(errors, FILE_INF_CRASHED)) {
+        Print(logfile, "FILE_INFO_CRASHED: cannot find information about file of creation\n");
+
+        if (ErrorIsThere(errors, FUNC_INF_CRASHED)) {
+            Print(logfile, "FUNC_INFO_CRASHED:");
+            Print(logfile, "cannot find information about function of creation\n");
+        } else {
+            Print(logfile, "Stack [%p] created in function %s line %d.\n", (void*) stk,
+                    stk->logs.func_of_creation, stk->logs.line_of_creation);
+        }
+
+    } else if (ErrorIsThere(errors, FUNC_INF_CRASHED)) {
+        Print(logfile, "Stack [%p] created in file %s (line: %d).\n", (void*) stk,
+                stk->logs.file_of_creation, stk->logs.line_of_creation);
+        Print(logfile, "FUNC_INFO_CRASHED:");
+        Print(logfile, "cannot find information about function of creation\n");
+
+    } else {
+        Print(logfile, "Stack [%p] created at %s(%d) in function %s.\n", (void*) stk,
+                stk->logs.file_of_creation, stk->logs.line_of_creation,
+                stk->logs.func_of_creation);
+    }
+
+    if (ErrorIsThere(errors, SIZE_EXCEED_CAP)) {
+        Print(logfile, "Error: size exceed capacity\n");
+    }
+
+    if (ErrorIsThere(errors, HASH_DISMATCH)) {
+        Print(logfile, "Error: Hash dismatch. Data may be lost.\n");
+    }
+
+    if (ErrorIsThere(errors, STK_BRDR_CHANGED) || ErrorIsThere(errors, LGS_BRDR_CHANGED)) {
+        Print(logfile, "Error: borders of stack are changed\n");
+    }
+
+    Print(logfile, "Stack info:\n");
+
+    Print(logfile, "{\n");
+    Print(logfile, "\t capacity = %zu\n", stk->capacity);
+    Print(logfile, "\t size     = %zu\n", stk->size);
+    Print(logfile, "\t data [%p]%s\n",    (void*) stk->data, IsStackInline(stk) ? " (inline)" : "");
+
+    if (ErrorIsThere(errors, UNEXPECTED_PSN)) {
+        Print(logfile, "\t Data error: unexpected poison in element's cell\n");
+    }
+    if (ErrorIsThere(errors, UNEXPECTED_ELM)) {
+        Print(logfile, "\t Data error: element in poisoned cell\n");
+    }
+
+    if (ErrorIsThere(errors, DATA_PTR_CRASHED)) {
+        Print(logfile, "DATA_PTR_CRASHED: cannot print data, information was lost\n");
+        Print(logfile, "}\n\n");
+
+        fflush(logfile);
+        return;
+    }
+
+    Print(logfile, "\t {\n");
+
+    Canary_t l_border = Border;
+    Canary_t r_border = Border;
+
+    bool has_borders = HasChecks(Checks, Canary_checks) && !IsStackInline(stk);
+
+    if (has_borders) {
+        GetDataBorders(stk, &l_border, &r_border);
+
+        Print(logfile, "\t \t Left  Border = %llu (%s)\n", l_border,
+                       ErrorIsThere(errors, L_BORDER_CHANGED) ? "changed" : "OK");
+    }
+
+    for (size_t i = 0; i < stk->capacity; ++i) {
+        Print(logfile, (i < stk->size) ? "\t \t*[%zu] = " : "\t \t [%zu] = ", i);
+
+        PrintElem(logfile, stk->data[i]);
+
+        if constexpr (HasChecks(Checks, Poison_checks)) {
+            Print(logfile, IsPoisoned(stk->data[i]) ? " (poisoned)" : " (busy)");
+        }
+
+        Print(logfile, "\n");
+    }
+
+    if (has_borders) {
+        Print(logfile, "\t \t Right Border = %llu (%s)\n", r_border,
+                       ErrorIsThere(errors, R_BORDER_CHANGED) ? "changed" : "OK");
+    }
+
+    Print(logfile, "\t }\n");
+    Print(logfile, "}\n\n");
+
+    fflush(logfile);
+    fflush(stdout);
+}
+
 #endif
@@ -2,20 +2,126 @@
 #define VERIFICATION
 
 #include "stack.h"
+#include "stack_logs.h"
+#include "../logging.h"
 
-// #define DEEP_VERIFICATION
-// #define CANARY_VERIFICATION
-// #define HASH_VERIFICATION
-// #define SAFEMODE
+template <typename Elem, size_t Inline_size, unsigned Checks>
+size_t StackHash(const Stack<Elem, Inline_size, Checks> *stk) {
+    if (stk->data == nullptr || stk->size > stk->capacity) {
+        return (size_t) HASH_CALC_ERR;
+    }
 
-#define StackVerificator(stk) \
-    RealStackVerificator(stk, __FILE__, __PRETTY_FUNCTION__, __LINE__)
-#define SafeStackVerificator(stk) \
-    RealSafeStackVerificator(stk, __FILE__, __PRETTY_FUNCTION__, __LINE__)
+    size_t hash = Hash_base_const;
 
-int RealStackVerificator(Stack *stk, const char *file, const char *func, int line);
-int RealSafeStackVerificator(Stack *stk, const char *file, const char *func, int line);
-int ErrorIsThere(int errors, Error error);
-size_t StackHash(Stack *stk);
+    for (size_t i = 0; i < stk->size; ++i) {
+        hash = hash * Hash_mult_const + ElemHash(stk->data[i]);
+    }
 
-#endif
\ No newline at end of file
+    return hash;
+}
+
+// Only checks chosen for the stack are made. Canaries of inline elements
+// are borders of stack itself, heap buffer has its own ones.
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+int RealStackVerificator(Stack<Elem, Inline_size, Checks> *stk, const char *file, const char *func, int line) {
+    int errors = NO_ERROR;
+
+    if (stk == nullptr) {
+        errors |= STCK_PTR_CRASHED;
+
+        RealDumpLogs(stk, GetLogStream(), file, func, line, errors);
+
+        return errors;
+    }
+
+    if (stk->capacity < stk->size) {
+        errors |= SIZE_EXCEED_CAP;
+    }
+
+    if (stk->data == nullptr || (IsStackInline(stk) && stk->capacity != Inline_size)) {
+        errors |= DATA_PTR_CRASHED;
+    }
+
+    if constexpr (HasChecks(Checks, Deep_checks)) {
+        if (!ErrorIsThere(errors, DATA_PTR_CRASHED) && !ErrorIsThere(errors, SIZE_EXCEED_CAP)) {
+            for (size_t i = 0; i < stk->size; ++i) {
+                if (IsPoisoned(stk->data[i])) {
+                    errors |= UNEXPECTED_PSN;
+                    break;
+                }
+            }
+
+            if (!ErrorIsThere(errors, UNEXPECTED_PSN)) {
+                for (size_t i = stk->size; i < stk->capacity; ++i) {
+                    if (!IsPoisoned(stk->data[i])) {
+                        errors |= UNEXPECTED_ELM;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    if constexpr (HasChecks(Checks, Canary_checks)) {
+        if (!ErrorIsThere(errors, DATA_PTR_CRASHED) && !IsStackInline(stk)) {
+            Canary_t l_border = 0;
+            Canary_t r_border = 0;
+
+            GetDataBorders(stk, &l_border, &r_border);
+
+            if (l_border != Border) {
+                errors |= L_BORDER_CHANGED;
+            }
+
+            if (r_border != Border) {
+                errors |= R_BORDER_CHANGED;
+            }
+        }
+
+        if (stk->logs.left_border != Border || stk->logs.right_border != Border) {
+            errors |= LGS_BRDR_CHANGED;
+        }
+
+        if (stk->left_border != Border || stk->right_border != Border) {
+            errors |= STK_BRDR_CHANGED;
+        }
+    }
+
+    if constexpr (HasChecks(Checks, Hash_checks)) {
+        if (!ErrorIsThere(errors, DATA_PTR_CRASHED) && !ErrorIsThere(errors, SIZE_EXCEED_CAP)) {
+            size_t hash = StackHash(stk);
+
+            if (hash == HASH_CALC_ERR) {
+                errors |= HASH_CALC_ERR;
+            }
+
+            if (hash != stk->hash) {
+                errors |= HASH_DISMATCH;
+            }
+        }
+    }
+
+    if (stk->logs.file_of_creation == nullptr) {
+        errors |= FILE_INF_CRASHED;
+    }
+
+    if (stk->logs.func_of_creation == nullptr) {
+        errors |= FUNC_INF_CRASHED;
+    }
+
+    return errors;
+}
+
+template <typename Elem, size_t Inline_size, unsigned Checks>
+int RealSafeStackVerificator(Stack<Elem, Inline_size, Checks> *stk, const char *file, const char *func, int line) {
+    int errors = RealStackVerificator(stk, file, func, line);
+
+    if (errors != 0) {
+        RealDumpLogs(stk, GetLogStream(), file, func, line, errors);
+    }
+
+    return errors;
+}
+
+#endif
@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include "concurrent_stack.h"
+#include "work_deque.h"
+
+// Stress test of lock-free containers: every value which is pushed by
+// threads should be popped exactly once. Run by `make stress`, arguments
+// are number of threads and capacity of containers. Small capacity makes
+// stacks full and deques overflow, so all paths are passed. Then the same
+// tests are timed for 1..Max_sweep_threads threads to show how containers
+// scale. Stress test is built with sanitizers, so throughput is relative.
+
+struct Stress_worker {
+    size_t index     = 0;
+    size_t n_threads = 0;
+};
+
+static void* push_pop_values(void *ptr);
+
+static void* run_tasks(void *ptr);
+
+static void run_task(Work_deque<uint32_t> *own, uint32_t task);
+
+static bool mark_seen(uint64_t value);
+
+static bool check_seen(size_t n_checked, const char *container);
+
+static bool run_workers(void* (*worker)(void*), size_t n_threads);
+
+static bool stress_stack(size_t n_threads, size_t capacity, double *time);
+
+static bool stress_deques(size_t n_threads, size_t capacity, double *time);
+
+static double get_seconds();
+
+
+static const size_t Values_per_thread   = 100000;
+static const size_t Max_stress_threads  = 64;
+
+static const size_t Default_threads     = 4;
+static const size_t Default_capacity    = 64;
+
+static const size_t Max_sweep_threads   = 16;
+static const size_t Sweep_capacity      = 1 << 12;
+
+static std::atomic<uint8_t>*   seen       = nullptr;      // times every value was popped
+static size_t                  n_values   = 0;
+
+static Concurrent_stack<uint64_t> shared  = {};
+
+static Work_deque<uint32_t>*   deques     = nullptr;
+static std::atomic<size_t>     n_done     = 0;
+static std::atomic<size_t>     n_stolen   = 0;
+
+
+int main(int argc, const char **argv) {
+    size_t n_threads = (argc > 1) ? strtoul(argv[1], nullptr, 10) : Default_threads;
+    size_t capacity  = (argc > 2) ? strtoul(argv[2], nullptr, 10) : Default_capacity;
+
+    if (n_threads == 0 || n_threads > Max_stress_threads || capacity == 0) {
+        printf("Usage: %s [threads 1..%zu] [capacity > 0]\n", argv[0], Max_stress_threads);
+        return 1;
+    }
+
+    double time = 0;
+
+    bool is_ok = stress_stack (n_threads, capacity, &time) &&
+                 stress_deques(n_threads, capacity, &time);
+
+    if (is_ok) {
+        printf("%zu threads, capacity %zu: %zu tasks stolen\n", n_threads, capacity, n_stolen.load());
+    }
+
+    // Sweep is checked as well, capacity is large so that threads
+    // rarely wait for full containers
+
+    if (is_ok) {
+        printf("\n%zu cpus, capacity %zu\n", (size_t) sysconf(_SC_NPROCESSORS_ONLN), Sweep_capacity);
+        printf("%8s %18s %18s\n", "threads", "stack, Mops/s", "deque, Mtasks/s");
+    }
+
+    for (size_t threads = 1; is_ok && threads <= Max_sweep_threads; threads *= 2) {
+        double stack_time = 0;
+        double deque_time = 0;
+
+        is_ok = stress_stack (threads, Sweep_capacity, &stack_time) &&
+                stress_deques(threads, Sweep_capacity, &deque_time);
+
+        if (!is_ok) {
+            break;
+        }
+
+        // Every value of stack is pushed and popped once, every task is run once
+
+        double stack_ops = 2.0 * (double) (threads * Values_per_thread);
+        double tasks     = 2.0 * (double) (threads * Values_per_thread);
+
+        printf("%8zu %18.2f %18.2f\n", threads, stack_ops / stack_time * 1e-6, tasks / deque_time * 1e-6);
+    }
+
+    printf("%s\n", is_ok ? "OK" : "FAILED");
+
+    return is_ok ? 0 : 1;
+}
+
+// Every thread pushes its own values and pops any, full stack is emptied a bit
+
+static bool stress_stack(size_t n_threads, size_t capacity, double *time) {
+    assert(time != nullptr);
+
+    n_values = n_threads * Values_per_thread;
+    seen     = (std::atomic<uint8_t>*) calloc(n_values, sizeof(std::atomic<uint8_t>));
+
+    if (seen == nullptr || !ConcurrentStackCtr(&shared, capacity)) {
+        printf("Error: not enought memory\n");
+        free(seen);
+        return false;
+    }
+
+    double start = get_seconds();
+
+    bool is_ok = run_workers(push_pop_values, n_threads);
+
+    uint64_t value = 0;
+
+    while (ConcurrentStackPop(&shared, &value)) {
+        is_ok &= mark_seen(value);
+    }
+
+    *time = get_seconds() - start;
+
+    is_ok &= check_seen(n_values, "concurrent stack");
+
+    ConcurrentStackDestr(&shared);
+    free(seen);
+
+    return is_ok;
+}
+
+// Task i spawns tasks 2i+1 and 2i+2, idle threads steal them
+
+static bool stress_deques(size_t n_threads, size_t capacity, double *time) {
+    assert(time != nullptr);
+
+    n_values = 2 * n_threads * Values_per_thread;
+    seen     = (std::atomic<uint8_t>*) calloc(n_values, sizeof(std::atomic<uint8_t>));
+    deques   = (Work_deque<uint32_t>*) calloc(n_threads, sizeof(Work_deque<uint32_t>));
+
+    n_done   = 0;
+    n_stolen = 0;
+
+    if (seen == nullptr || deques == nullptr) {
+        printf("Error: not enought memory\n");
+        free(seen);
+        free(deques);
+        return false;
+    }
+
+    for (size_t i = 0; i < n_threads; ++i) {
+        if (!WorkDequeCtr(&deques[i], capacity)) {
+            printf("Error: not enought memory\n");
+
+            for (size_t j = 0; j < i; ++j) {
+                WorkDequeDestr(&deques[j]);
+            }
+
+            free(deques);
+            free(seen);
+            return false;
+        }
+    }
+
+    WorkDequePush(&deques[0], 0u);
+
+    double start = get_seconds();
+
+    bool is_ok = run_workers(run_tasks, n_threads);
+
+    *time = get_seconds() - start;
+
+    is_ok &= check_seen(n_values, "work deque");
+
+    for (size_t i = 0; i < n_threads; ++i) {
+        WorkDequeDestr(&deques[i]);
+    }
+
+    free(deques);
+    free(seen);
+
+    return is_ok;
+}
+
+static void* push_pop_values(void *ptr) {
+    assert(ptr != nullptr);
+
+    const Stress_worker *worker = (const Stress_worker*) ptr;
+
+    bool is_ok = true;
+
+    for (size_t i = 0; i < Values_per_thread; ++i) {
+        uint64_t value = worker->index * Values_per_thread + i;
+        uint64_t taken = 0;
+
+        while (!ConcurrentStackPush(&shared, value)) {
+            if (ConcurrentStackPop(&shared, &taken)) {
+                is_ok &= mark_seen(taken);
+            }
+        }
+
+        if (i % 2 == 1 && ConcurrentStackPop(&shared, &taken)) {
+            is_ok &= mark_seen(taken);
+        }
+    }
+
+    return is_ok ? ptr : nullptr;
+}
+
+static void* run_tasks(void *ptr) {
+    assert(ptr != nullptr);
+
+    const Stress_worker *worker = (const Stress_worker*) ptr;
+
+    Work_deque<uint32_t> *own = &deques[worker->index];
+
+    unsigned seed = (unsigned) worker->index + 1;
+
+    while (n_done.load() < n_values) {
+        uint32_t task = 0;
+
+        if (!WorkDequePop(own, &task)) {
+            size_t victim = (size_t) rand_r(&seed) % worker->n_threads;
+
+            if (victim == worker->index || WorkDequeSteal(&deques[victim], &task) != Steal_success) {
+                sched_yield();
+                continue;
+            }
+
+            ++n_stolen;
+        }
+
+        run_task(own, task);
+    }
+
+    return ptr;
+}
+
+// Children which don't fit to full deque are run by the same thread
+
+static void run_task(Work_deque<uint32_t> *own, uint32_t task) {
+    assert(own != nullptr);
+
+    mark_seen(task);
+
+    for (uint32_t child = 2 * task + 1; child <= 2 * task + 2; ++child) {
+        if (child < n_values && !WorkDequePush(own, child)) {
+            run_task(own, child);
+        }
+    }
+
+    ++n_done;
+}
+
+static bool mark_seen(uint64_t value) {
+    if (value >= n_values) {
+        printf("Error: value %llu was never pushed\n", (unsigned long long) value);
+        return false;
+    }
+
+    seen[value]++;
+
+    return true;
+}
+
+static bool check_seen(size_t n_checked, const char *container) {
+    assert(container != nullptr);
+
+    size_t n_wrong = 0;
+
+    for (size_t i = 0; i < n_checked; ++i) {
+        n_wrong += (seen[i].load() != 1);
+    }
+
+    if (n_wrong != 0) {
+        printf("Error: %s: %zu values were not popped exactly once\n", container, n_wrong);
+    }
+
+    return n_wrong == 0;
+}
+
+// Returns false if some worker failed
+
+static bool run_workers(void* (*worker)(void*), size_t n_threads) {
+    assert(worker != nullptr);
+
+    pthread_t     handles[Max_stress_threads] = {};
+    Stress_worker workers[Max_stress_threads] = {};
+
+    size_t n_started = 0;
+
+    for (; n_started < n_threads; ++n_started) {
+        workers[n_started] = {n_started, n_threads};
+
+        if (pthread_create(&handles[n_started], nullptr, worker, &workers[n_started]) != 0) {
+            break;
+        }
+    }
+
+    bool is_ok = (n_started == n_threads);
+
+    for (size_t i = 0; i < n_started; ++i) {
+        void *result = nullptr;
+
+        pthread_join(handles[i], &result);
+
+        is_ok &= (result != nullptr);
+    }
+
+    return is_ok;
+}
+
+static double get_seconds() {
+    struct timespec now = {};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
@@ -0,0 +1,158 @@
+#ifndef WORK_DEQUE
+#define WORK_DEQUE
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <type_traits>
+
+// Work-stealing deque (Chase-Lev) of trivially copyable elements. Every
+// thread has its own deque: owner pushes and pops elements at the bottom
+// like with stack, other threads steal the oldest elements from the top.
+// Only the last element is fought for, owner takes it by the same swap of
+// top as thieves do.
+//
+// Cells make ring of power of two size which is fixed at creation, push
+// returns false when deque is full, so owner can do the work itself or
+// give it to shared stack.
+
+template <typename Elem>
+struct Work_deque {
+    static_assert(std::is_trivially_copyable_v<Elem>, "elements are copied between threads");
+    static_assert(std::atomic<Elem>::is_always_lock_free, "cells are read by thieves while owner writes them");
+
+    std::atomic<Elem>*   cells    = nullptr;
+    int64_t              mask     = 0;          // capacity - 1
+    std::atomic<int64_t> top      = 0;          // next element to steal
+    char                 padding[64 - sizeof(std::atomic<int64_t>)] = {};     // owner and thieves on different cache lines
+    std::atomic<int64_t> bottom   = 0;          // next free cell of owner
+};
+
+typedef enum {
+    Steal_success = 0,
+    Steal_empty   = 1,
+    Steal_lost    = 2,     // other thread took the element, deque may be not empty
+} Steal_result;
+
+// Capacity is rounded up to power of two. Not thread safe.
+
+template <typename Elem>
+bool WorkDequeCtr(Work_deque<Elem> *deque, size_t capacity) {
+    if (deque == nullptr || capacity == 0 || capacity > ((size_t) 1 << 40)) {
+        return false;
+    }
+
+    size_t size = 1;
+
+    while (size < capacity) {
+        size *= 2;
+    }
+
+    deque->cells = (std::atomic<Elem>*) calloc(size, sizeof(std::atomic<Elem>));
+
+    if (deque->cells == nullptr) {
+        return false;
+    }
+
+    deque->mask = (int64_t) size - 1;
+
+    deque->top   .store(0, std::memory_order_relaxed);
+    deque->bottom.store(0, std::memory_order_release);
+
+    return true;
+}
+
+template <typename Elem>
+void WorkDequeDestr(Work_deque<Elem> *deque) {
+    if (deque == nullptr) {
+        return;
+    }
+
+    free(deque->cells);
+
+    deque->cells = nullptr;
+    deque->mask  = 0;
+
+    deque->top   .store(0, std::memory_order_relaxed);
+    deque->bottom.store(0, std::memory_order_relaxed);
+}
+
+// Owner only
+
+template <typename Elem>
+bool WorkDequePush(Work_deque<Elem> *deque, Elem value) {
+    int64_t bottom = deque->bottom.load(std::memory_order_relaxed);
+    int64_t top    = deque->top   .load(std::memory_order_acquire);
+
+    if (bottom - top > deque->mask) {
+        return false;
+    }
+
+    deque->cells[bottom & deque->mask].store(value, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_release);
+
+    deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+
+    return true;
+}
+
+// Owner only, takes the newest element
+
+template <typename Elem>
+bool WorkDequePop(Work_deque<Elem> *deque, Elem *value) {
+    int64_t bottom = deque->bottom.load(std::memory_order_relaxed) - 1;
+
+    deque->bottom.store(bottom, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t top = deque->top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    *value = deque->cells[bottom & deque->mask].load(std::memory_order_relaxed);
+
+    if (top != bottom) {
+        return true;
+    }
+
+    bool is_taken = deque->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                                     std::memory_order_relaxed);
+
+    deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+
+    return is_taken;
+}
+
+// Any thread, takes the oldest element
+
+template <typename Elem>
+Steal_result WorkDequeSteal(Work_deque<Elem> *deque, Elem *value) {
+    int64_t top = deque->top.load(std::memory_order_acquire);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t bottom = deque->bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom) {
+        return Steal_empty;
+    }
+
+    Elem stolen = deque->cells[top & deque->mask].load(std::memory_order_relaxed);
+
+    if (!deque->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                          std::memory_order_relaxed)) {
+        return Steal_lost;
+    }
+
+    *value = stolen;
+
+    return Steal_success;
+}
+
+#endif
@@ -0,0 +1,223 @@
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "comparing.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COMPARING_X86
+#endif
+
+typedef bool (*Compare_impl)(const char *first, const char *second, size_t len);
+
+static Compare_impl get_compare_impl();
+static Compare_impl select_compare_impl();
+
+static bool compare_scalar(const char *first, const char *second, size_t len);
+
+static bool swar_equal_words(uint64_t first, uint64_t second);
+
+static uint64_t load_word(const char *str, size_t len);
+
+#ifdef COMPARING_X86
+
+static bool compare_sse2(const char *first, const char *second, size_t len);
+static bool compare_avx2(const char *first, const char *second, size_t len);
+
+#endif
+
+
+static const size_t Short_len = 16;
+
+
+bool equal_ignoring_case(const char *first, const char *second, size_t len) {
+    assert(first  != nullptr);
+    assert(second != nullptr);
+
+    // Most of names are shorter than vector block, they don't need dispatch
+    if (len < Short_len) {
+        return compare_scalar(first, second, len);
+    }
+
+    return get_compare_impl()(first, second, len);
+}
+
+bool equal_strings_ignoring_case(const char *first, const char *second) {
+    assert(first  != nullptr);
+    assert(second != nullptr);
+
+    size_t len = strlen(first);
+
+    return strlen(second) == len && equal_ignoring_case(first, second, len);
+}
+
+static Compare_impl get_compare_impl() {
+    static const Compare_impl impl = select_compare_impl();
+
+    return impl;
+}
+
+static Compare_impl select_compare_impl() {
+    #ifdef COMPARING_X86
+
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return compare_avx2;
+    }
+
+    if (__builtin_cpu_supports("sse2")) {
+        return compare_sse2;
+    }
+
+    #endif
+
+    return compare_scalar;
+}
+
+/*----------------------------------------- SCALAR -----------------------------------------------*/
+
+// Strings are compared by 8-byte words with bit tricks, the last word
+// overlaps the previous one, so nothing after the end is read
+
+static bool compare_scalar(const char *first, const char *second, size_t len) {
+    const size_t word_size = sizeof(uint64_t);
+
+    if (len < word_size) {
+        return swar_equal_words(load_word(first, len), load_word(second, len));
+    }
+
+    for (size_t i = 0; i + word_size < len; i += word_size) {
+        if (!swar_equal_words(load_word(first + i, word_size), load_word(second + i, word_size))) {
+            return false;
+        }
+    }
+
+    return swar_equal_words(load_word(first  + len - word_size, word_size),
+                            load_word(second + len - word_size, word_size));
+}
+
+// Words may differ only by case bit of bytes which are letters
+
+static bool swar_equal_words(uint64_t first, uint64_t second) {
+    const uint64_t ones = 0x0101010101010101u;
+
+    uint64_t diff = first ^ second;
+
+    if (diff == 0) {
+        return true;
+    }
+
+    uint64_t lower = first | (ones * ('a' - 'A'));
+    uint64_t low7  = lower & (ones * 0x7F);
+
+    uint64_t is_letter = (low7 + ones * (0x80 - 'a')) & ~(low7 + ones * (0x7F - 'z'))
+                       & ~lower & (ones * 0x80);
+
+    return (diff & ~(is_letter >> 2)) == 0;
+}
+
+// Short strings are loaded by two overlapping halves, so equal strings
+// give equal words
+
+static uint64_t load_word(const char *str, size_t len) {
+    uint64_t word = 0;
+
+    if (len >= sizeof(uint64_t)) {
+        memcpy(&word, str, sizeof(uint64_t));
+
+    } else if (len >= sizeof(uint32_t)) {
+        uint32_t head = 0;
+        uint32_t tail = 0;
+
+        memcpy(&head, str, sizeof(uint32_t));
+        memcpy(&tail, str + len - sizeof(uint32_t), sizeof(uint32_t));
+
+        word = ((uint64_t) tail << 32) | head;
+
+    } else {
+        for (size_t i = 0; i < len; ++i) {
+            word |= (uint64_t) (unsigned char) str[i] << (8 * i);
+        }
+    }
+
+    return word;
+}
+
+#ifdef COMPARING_X86
+
+// Vector implementations read strings by unaligned blocks which never cross
+// their ends: the last block overlaps the previous one instead. Strings shorter
+// than block are compared by narrower implementation.
+//
+// Blocks may differ only by case bit of bytes which are letters. Bytes of
+// UTF-8 sequences are never taken for letters and must be equal.
+
+/*------------------------------------------ SSE2 ------------------------------------------------*/
+
+static bool sse2_equal_blocks(const char *first, const char *second) {
+    __m128i first_block  = _mm_loadu_si128((const __m128i*) (const void*) first);
+    __m128i second_block = _mm_loadu_si128((const __m128i*) (const void*) second);
+
+    __m128i diff   = _mm_xor_si128(first_block, second_block);
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(first_block, _mm_set1_epi8('a' - 'A')),
+                                  _mm_set1_epi8('a'));
+
+    letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8('z' - 'a')), letter);
+    diff   = _mm_andnot_si128(_mm_and_si128(letter, _mm_set1_epi8('a' - 'A')), diff);
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) == 0xFFFF;
+}
+
+static bool compare_sse2(const char *first, const char *second, size_t len) {
+    const size_t block_size = sizeof(__m128i);
+
+    if (len < block_size) {
+        return compare_scalar(first, second, len);
+    }
+
+    for (size_t i = 0; i + block_size < len; i += block_size) {
+        if (!sse2_equal_blocks(first + i, second + i)) {
+            return false;
+        }
+    }
+
+    return sse2_equal_blocks(first + len - block_size, second + len - block_size);
+}
+
+/*------------------------------------------ AVX2 ------------------------------------------------*/
+
+__attribute__((target("avx2")))
+static bool avx2_equal_blocks(const char *first, const char *second) {
+    __m256i first_block  = _mm256_loadu_si256((const __m256i*) (const void*) first);
+    __m256i second_block = _mm256_loadu_si256((const __m256i*) (const void*) second);
+
+    __m256i diff   = _mm256_xor_si256(first_block, second_block);
+    __m256i letter = _mm256_sub_epi8(_mm256_or_si256(first_block, _mm256_set1_epi8('a' - 'A')),
+                                     _mm256_set1_epi8('a'));
+
+    letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8('z' - 'a')), letter);
+    diff   = _mm256_andnot_si256(_mm256_and_si256(letter, _mm256_set1_epi8('a' - 'A')), diff);
+
+    return _mm256_testz_si256(diff, diff) != 0;
+}
+
+__attribute__((target("avx2")))
+static bool compare_avx2(const char *first, const char *second, size_t len) {
+    const size_t block_size = sizeof(__m256i);
+
+    if (len < block_size) {
+        return compare_sse2(first, second, len);
+    }
+
+    for (size_t i = 0; i + block_size < len; i += block_size) {
+        if (!avx2_equal_blocks(first + i, second + i)) {
+            return false;
+        }
+    }
+
+    return avx2_equal_blocks(first + len - block_size, second + len - block_size);
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef COMPARING
+#define COMPARING
+
+#include <stdio.h>
+
+// Strings are compared ignoring case of ASCII letters, other bytes (including
+// UTF-8 sequences) must be equal. Unlike strcasecmp it doesn't depend on locale.
+// AVX2 or SSE2 implementation is chosen at runtime, scalar one is used otherwise.
+
+bool equal_ignoring_case(const char *first, const char *second, size_t len);
+
+// Lengths are compared first, so most of different strings are not read
+
+bool equal_strings_ignoring_case(const char *first, const char *second);
+
+#endif
@@ -1,5 +1,9 @@
 #include <stdio.h>
+#include <stdint.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <assert.h>
 #include <string.h>
 
@@ -15,8 +19,16 @@ CLArgs parse_cmd_line(int argc, const char **argv) {
 
     CLArgs args = {};
 
-    args.input  = nullptr;
-    args.output = nullptr;
+    args.input   = nullptr;
+    args.output  = nullptr;
+    args.stream  = false;
+    args.convert = false;
+    args.threads = 1;
+    args.lazy    = false;
+    args.compact = false;
+    args.autosave = 0;
+    args.layout   = nullptr;
+    args.queries  = nullptr;
 
     for (int i = 0; i < argc; ++i) {
         // -o: output filename
@@ -42,6 +54,72 @@ CLArgs parse_cmd_line(int argc, const char **argv) {
 
             args.input = argv[i];
         }
+
+        // -s: read input as stream
+        if (strcmp(argv[i], "-s") == 0) {
+            args.stream = true;
+        }
+
+        // -c: convert input data base to output one
+        if (strcmp(argv[i], "-c") == 0) {
+            args.convert = true;
+        }
+
+        // -l: read data base lazily
+        if (strcmp(argv[i], "-l") == 0) {
+            args.lazy = true;
+        }
+
+        // -m: merge journal into data base
+        if (strcmp(argv[i], "-m") == 0) {
+            args.compact = true;
+        }
+
+        // -q: answer queries from file instead of game
+        if (strcmp(argv[i], "-q") == 0) {
+            ++i;
+
+            if (i >= argc) {
+                fprintf(stderr, "Warning: -q flag requires queries file name\n");
+                break;
+            }
+
+            args.queries = argv[i];
+        }
+
+        // -j: number of threads for loading and answering queries
+        if (strcmp(argv[i], "-j") == 0) {
+            ++i;
+
+            if (i >= argc || sscanf(argv[i], "%zu", &args.threads) != 1 || args.threads == 0) {
+                fprintf(stderr, "Warning: -j flag requires positive number of threads\n");
+                args.threads = 1;
+                break;
+            }
+        }
+
+        // -a: autosave data base after every N new characters
+        if (strcmp(argv[i], "-a") == 0) {
+            ++i;
+
+            if (i >= argc || sscanf(argv[i], "%zu", &args.autosave) != 1) {
+                fprintf(stderr, "Warning: -a flag requires number of characters between autosaves\n");
+                args.autosave = 0;
+                break;
+            }
+        }
+
+        // -r: order of nodes in memory (veb, bfs or none)
+        if (strcmp(argv[i], "-r") == 0) {
+            ++i;
+
+            if (i >= argc) {
+                fprintf(stderr, "Warning: -r flag requires layout name\n");
+                break;
+            }
+
+            args.layout = argv[i];
+        }
     }
 
     return args;
@@ -54,6 +132,18 @@ size_t count_elements_in_file(const char file_name[]) {
     return a.st_size + 1;
 }
 
+bool is_regular_file(const char *file_name) {
+    assert(file_name != nullptr && "file_name is nullptr");
+
+    struct stat file_info = {};
+
+    if (stat(file_name, &file_info) != 0) {
+        return false;
+    }
+
+    return S_ISREG(file_info.st_mode);
+}
+
 size_t read_file(char text[], size_t amount_of_symbols, const char* file_name) {
     assert(text  != nullptr && "text  is nullptr");
     
@@ -74,6 +164,104 @@ size_t read_file(char text[], size_t amount_of_symbols, const char* file_name) {
     return real_amount_of_symbols;
 }
 
+static size_t mapping_len(size_t size) {
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+
+    // At least one byte after the file is needed for '\0' ending
+    return (size / page_size + 1) * page_size;
+}
+
+char* map_file(const char *file_name, size_t *size) {
+    assert(file_name != nullptr && "file_name is nullptr");
+    assert(size      != nullptr && "size is nullptr");
+
+    int fd = open(file_name, O_RDONLY);
+
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat file_info = {};
+
+    if (fstat(fd, &file_info) != 0 || !S_ISREG(file_info.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+
+    *size = (size_t) file_info.st_size;
+
+    size_t len = mapping_len(*size);
+
+    // Anonymous zero pages are reserved first, so the text is '\0'-terminated
+    // even if file size is a multiple of page size. File is mapped over them
+    // privately: writing terminators into the text never touches the file.
+    void *text = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (text == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+
+    if (*size > 0 && mmap(text, *size, PROT_READ | PROT_WRITE, 
+                          MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(text, len);
+        close(fd);
+        return nullptr;
+    }
+
+    close(fd);
+
+    return (char*) text;
+}
+
+// Zeroed memory of given size which can be freed by unmap_file() as mapped
+// file. Pages are really taken only when they are touched.
+
+char* map_anonymous(size_t size) {
+    void *text = mmap(nullptr, mapping_len(size), PROT_READ | PROT_WRITE, 
+                                                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    return (text == MAP_FAILED) ? nullptr : (char*) text;
+}
+
+// Memory got from map_anonymous() is extended to the new size, it can be
+// moved to another address. Old memory stays as it was if it can't grow.
+
+char* grow_anonymous(char *data, size_t old_size, size_t new_size) {
+    if (data == nullptr) {
+        return map_anonymous(new_size);
+    }
+
+    void *grown = mremap(data, mapping_len(old_size), mapping_len(new_size), MREMAP_MAYMOVE);
+
+    return (grown == MAP_FAILED) ? nullptr : (char*) grown;
+}
+
+// Pages of mapped file which are read once and not needed anymore are
+// given back, they are read from file again if they are touched later.
+// Only pages lying inside the range are given back.
+
+void release_pages(char *begin, size_t size) {
+    assert(begin != nullptr && "begin is nullptr");
+
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+
+    uintptr_t first = ((uintptr_t) begin + page_size - 1) / page_size * page_size;
+    uintptr_t last  = ((uintptr_t) begin + size) / page_size * page_size;
+
+    if (first < last) {
+        madvise((void*) first, last - first, MADV_DONTNEED);
+    }
+}
+
+void unmap_file(char *text, size_t size) {
+    if (text == nullptr) {
+        return;
+    }
+
+    munmap(text, mapping_len(size));
+}
+
 int count_strings(char text[], size_t amount_of_symbols) {
     assert(text != nullptr && "text is nullptr");
 
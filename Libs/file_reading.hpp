@@ -6,14 +6,34 @@
 struct CLArgs {
     const char *input;
     const char *output;
+    bool        stream;
+    bool        convert;
+    size_t      threads;
+    bool        lazy;
+    bool        compact;
+    size_t      autosave;
+    const char *layout;
+    const char *queries;
 };
 
 CLArgs parse_cmd_line(int argc, const char **argv);
 
 size_t count_elements_in_file(const char file_name[]);
 
+bool is_regular_file(const char *file_name);
+
 size_t read_file(char text[], size_t amount_of_symbols, const char* file_name);
 
+char* map_file(const char *file_name, size_t *size);
+
+char* map_anonymous(size_t size);
+
+char* grow_anonymous(char *data, size_t old_size, size_t new_size);
+
+void release_pages(char *begin, size_t size);
+
+void unmap_file(char *text, size_t size);
+
 int count_strings(char text[], size_t amount_of_symbols);
 
 int get_val(char *ptr_to_first_elem, int *ptr_to_val);
@@ -0,0 +1,213 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include "scanning.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCANNING_X86
+#endif
+
+enum Scan_kind {
+    SPACES,
+    QUOTE,
+    STRUCTURAL,
+};
+
+typedef size_t (*Scan_impl)(const char *text, size_t ip, Scan_kind kind);
+
+static Scan_impl get_scan_impl();
+static Scan_impl select_scan_impl();
+
+static size_t scan_scalar(const char *text, size_t ip, Scan_kind kind);
+
+static bool stops_scan(char sym, Scan_kind kind);
+
+#ifdef SCANNING_X86
+
+static size_t scan_sse2(const char *text, size_t ip, Scan_kind kind);
+static size_t scan_avx2(const char *text, size_t ip, Scan_kind kind);
+
+#endif
+
+
+size_t scan_spaces(const char *text, size_t ip) {
+    assert(text != nullptr);
+
+    // Spaces between tokens are short, most of the time there is nothing to skip
+    if (stops_scan(text[ip], SPACES)) {
+        return ip;
+    }
+
+    return get_scan_impl()(text, ip, SPACES);
+}
+
+size_t scan_to_quote(const char *text, size_t ip) {
+    assert(text != nullptr);
+
+    return get_scan_impl()(text, ip, QUOTE);
+}
+
+size_t scan_to_structural(const char *text, size_t ip) {
+    assert(text != nullptr);
+
+    return get_scan_impl()(text, ip, STRUCTURAL);
+}
+
+static Scan_impl get_scan_impl() {
+    static const Scan_impl impl = select_scan_impl();
+
+    return impl;
+}
+
+static Scan_impl select_scan_impl() {
+    #ifdef SCANNING_X86
+
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return scan_avx2;
+    }
+
+    if (__builtin_cpu_supports("sse2")) {
+        return scan_sse2;
+    }
+
+    #endif
+
+    return scan_scalar;
+}
+
+/*----------------------------------------- SCALAR -----------------------------------------------*/
+
+static bool stops_scan(char sym, Scan_kind kind) {
+    switch (kind) {
+        case SPACES:
+            return sym != ' ' && (unsigned char) (sym - '\t') > '\r' - '\t';
+
+        case QUOTE:
+            return sym == '"' || sym == '\0';
+
+        case STRUCTURAL:
+            return sym == '"' || sym == '{' || sym == '}' || sym == '\0';
+
+        default:
+            return true;
+    }
+}
+
+static size_t scan_scalar(const char *text, size_t ip, Scan_kind kind) {
+    for (; !stops_scan(text[ip], kind); ++ip);
+
+    return ip;
+}
+
+#ifdef SCANNING_X86
+
+// Vector implementations read text by aligned blocks, so they never cross page
+// border and can safely read some bytes after '\0'. Out-of-bounds bytes are
+// never used, so address sanitizer is turned off for these reads.
+
+/*------------------------------------------ SSE2 ------------------------------------------------*/
+
+static unsigned sse2_stop_mask(__m128i block, Scan_kind kind) {
+    __m128i stops = _mm_cmpeq_epi8(block, _mm_setzero_si128());
+
+    switch (kind) {
+        case SPACES: {
+            __m128i ctrl   = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+            __m128i spaces = _mm_cmpeq_epi8(_mm_min_epu8(ctrl, _mm_set1_epi8('\r' - '\t')), ctrl);
+
+            spaces = _mm_or_si128(spaces, _mm_cmpeq_epi8(block, _mm_set1_epi8(' ')));
+
+            return ~((unsigned) _mm_movemask_epi8(spaces)) & 0xFFFFu;
+        }
+
+        case STRUCTURAL:
+            stops = _mm_or_si128(stops, _mm_cmpeq_epi8(block, _mm_set1_epi8('{')));
+            stops = _mm_or_si128(stops, _mm_cmpeq_epi8(block, _mm_set1_epi8('}')));
+            [[fallthrough]];
+
+        case QUOTE:
+            stops = _mm_or_si128(stops, _mm_cmpeq_epi8(block, _mm_set1_epi8('"')));
+            break;
+
+        default:
+            break;
+    }
+
+    return (unsigned) _mm_movemask_epi8(stops);
+}
+
+__attribute__((no_sanitize_address))
+static size_t scan_sse2(const char *text, size_t ip, Scan_kind kind) {
+    const size_t block_size = sizeof(__m128i);
+
+    size_t offset = (uintptr_t) (text + ip) % block_size;
+
+    const __m128i *block = (const __m128i*) (const void*) (text + ip - offset);
+
+    unsigned mask = sse2_stop_mask(_mm_load_si128(block), kind) & (0xFFFFu << offset);
+
+    while (mask == 0) {
+        ++block;
+
+        mask = sse2_stop_mask(_mm_load_si128(block), kind);
+    }
+
+    return (size_t) ((const char*) block - text) + (size_t) __builtin_ctz(mask);
+}
+
+/*------------------------------------------ AVX2 ------------------------------------------------*/
+
+__attribute__((target("avx2")))
+static unsigned avx2_stop_mask(__m256i block, Scan_kind kind) {
+    __m256i stops = _mm256_cmpeq_epi8(block, _mm256_setzero_si256());
+
+    switch (kind) {
+        case SPACES: {
+            __m256i ctrl   = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+            __m256i spaces = _mm256_cmpeq_epi8(_mm256_min_epu8(ctrl, 
+                                               _mm256_set1_epi8('\r' - '\t')), ctrl);
+
+            spaces = _mm256_or_si256(spaces, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')));
+
+            return ~((unsigned) _mm256_movemask_epi8(spaces));
+        }
+
+        case STRUCTURAL:
+            stops = _mm256_or_si256(stops, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('{')));
+            stops = _mm256_or_si256(stops, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('}')));
+            [[fallthrough]];
+
+        case QUOTE:
+            stops = _mm256_or_si256(stops, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('"')));
+            break;
+
+        default:
+            break;
+    }
+
+    return (unsigned) _mm256_movemask_epi8(stops);
+}
+
+__attribute__((target("avx2"), no_sanitize_address))
+static size_t scan_avx2(const char *text, size_t ip, Scan_kind kind) {
+    const size_t block_size = sizeof(__m256i);
+
+    size_t offset = (uintptr_t) (text + ip) % block_size;
+
+    const __m256i *block = (const __m256i*) (const void*) (text + ip - offset);
+
+    unsigned mask = avx2_stop_mask(_mm256_load_si256(block), kind) & (0xFFFFFFFFu << offset);
+
+    while (mask == 0) {
+        ++block;
+
+        mask = avx2_stop_mask(_mm256_load_si256(block), kind);
+    }
+
+    return (size_t) ((const char*) block - text) + (size_t) __builtin_ctz(mask);
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef SCANNING
+#define SCANNING
+
+#include <stdio.h>
+
+// Scanning functions work with '\0'-terminated text and return index of the
+// first matching symbol at or after ip (index of '\0' if there is no such symbol).
+// AVX2 or SSE2 implementation is chosen at runtime, scalar one is used otherwise.
+
+size_t scan_spaces       (const char *text, size_t ip);
+
+size_t scan_to_quote     (const char *text, size_t ip);
+
+size_t scan_to_structural(const char *text, size_t ip);
+
+#endif
@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "text_buffer.h"
+
+static bool reserve_text(Text_buffer *buffer, size_t len);
+
+
+static const size_t Buffer_start_capacity = 1 << 8;
+
+
+void buffer_append(Text_buffer *buffer, const char *data, size_t len) {
+    assert(buffer != nullptr);
+    assert(data   != nullptr);
+
+    if (!reserve_text(buffer, len)) {
+        return;
+    }
+
+    memcpy(buffer->data + buffer->size, data, len);
+
+    buffer->size += len;
+
+    buffer->data[buffer->size] = '\0';
+}
+
+// Text is formatted right into the buffer, it is formatted again only if
+// there is no place for it
+
+void buffer_printf(Text_buffer *buffer, const char *format, ...) {
+    assert(buffer != nullptr);
+    assert(format != nullptr);
+
+    if (!reserve_text(buffer, 0)) {
+        return;
+    }
+
+    va_list args = {};
+    va_start(args, format);
+
+    size_t free_place = buffer->capacity - buffer->size;
+
+    int len = vsnprintf(buffer->data + buffer->size, free_place, format, args);
+
+    va_end(args);
+
+    if (len < 0) {
+        buffer->is_ok = false;
+        return;
+    }
+
+    if ((size_t) len >= free_place) {
+        if (!reserve_text(buffer, (size_t) len)) {
+            return;
+        }
+
+        va_start(args, format);
+
+        vsnprintf(buffer->data + buffer->size, (size_t) len + 1, format, args);
+
+        va_end(args);
+    }
+
+    buffer->size += (size_t) len;
+}
+
+void text_buffer_dtor(Text_buffer *buffer) {
+    assert(buffer != nullptr);
+
+    free(buffer->data);
+
+    *buffer = {};
+}
+
+// Place for len symbols and '\0' after them
+
+static bool reserve_text(Text_buffer *buffer, size_t len) {
+    assert(buffer != nullptr);
+
+    if (!buffer->is_ok) {
+        return false;
+    }
+
+    if (buffer->size + len < buffer->capacity) {
+        return true;
+    }
+
+    size_t new_capacity = (buffer->capacity == 0) ? Buffer_start_capacity : buffer->capacity;
+
+    while (buffer->size + len >= new_capacity) {
+        new_capacity *= 2;
+    }
+
+    char *new_data = (char*) realloc(buffer->data, new_capacity);
+
+    if (new_data == nullptr) {
+        buffer->is_ok = false;
+        return false;
+    }
+
+    buffer->data     = new_data;
+    buffer->capacity = new_capacity;
+
+    return true;
+}
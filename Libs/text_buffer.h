@@ -0,0 +1,23 @@
+#ifndef TEXT_BUFFER
+#define TEXT_BUFFER
+
+#include <stdio.h>
+
+// Growing buffer of text. If memory can't be taken, buffer stops growing
+// and is_ok is cleared, so text is checked once after it is written.
+
+struct Text_buffer {
+    char*  data     = nullptr;
+    size_t size     = 0;
+    size_t capacity = 0;
+    bool   is_ok    = true;
+};
+
+void buffer_append(Text_buffer *buffer, const char *data, size_t len);
+
+__attribute__((format(printf, 2, 3)))
+void buffer_printf(Text_buffer *buffer, const char *format, ...);
+
+void text_buffer_dtor(Text_buffer *buffer);
+
+#endif
@@ -0,0 +1,390 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <atomic>
+
+#include "batch_queries.h"
+#include "../Tree/definitions.h"
+#include "../Libs/file_reading.hpp"
+#include "../Libs/scanning.h"
+#include "../Libs/text_buffer.h"
+
+// Answers of chunk lie one after another in buffer of the thread which
+// answered them
+
+struct Query_chunk {
+    size_t thread = 0;
+    size_t begin  = 0;
+    size_t end    = 0;
+};
+
+struct Batch {
+    const Query_sources* sources    = nullptr;
+    char**               lines      = nullptr;
+    size_t               n_lines    = 0;
+    Query_chunk*         chunks     = nullptr;
+    size_t               n_chunks   = 0;
+    Text_buffer*         answers    = nullptr;  // buffer of every thread
+    std::atomic<size_t>  next       = 0;        // first chunk not taken by threads
+    std::atomic<bool>    is_correct = true;
+};
+
+struct Batch_thread {
+    Batch* batch = nullptr;
+    size_t index = 0;
+};
+
+static bool split_lines(char *text, size_t size, char ***lines, size_t *n_lines);
+
+static bool run_batch(Batch *batch, size_t n_threads);
+
+static void* answer_chunks(void *thread_ptr);
+
+static void answer_query(const Query_sources *sources, Text_buffer *answers, char *line, size_t line_number);
+
+static Node_id find_query_character(const Query_sources *sources, Text_buffer *answers, const char *name);
+
+static char* read_query_name(char **line, bool is_last);
+
+static bool is_command(const char *line, const char *command);
+
+static bool write_answers(const Batch *batch, const char *output);
+
+
+static const size_t Query_chunk_size = 1 << 6;
+
+
+bool answer_queries(const Query_sources *sources, const char *queries, const char *output,
+                    size_t n_threads) {
+    assert(sources           != nullptr);
+    assert(sources->tree     != nullptr);
+    assert(sources->names    != nullptr);
+    assert(sources->ancestry != nullptr);
+    assert(queries           != nullptr);
+    assert(output            != nullptr);
+
+    size_t size = 0;
+    char  *text = map_file(queries, &size);
+
+    if (text == nullptr) {
+        printf("Error: can't open queries file %s\n", queries);
+        return false;
+    }
+
+    Batch batch = {};
+
+    batch.sources = sources;
+
+    bool result = split_lines(text, size, &batch.lines, &batch.n_lines);
+
+    if (!result) {
+        printf("Error: can't read queries - not enought memory\n");
+    }
+
+    if (result && !run_batch(&batch, n_threads)) {
+        printf("Error: can't answer queries - not enought memory\n");
+        result = false;
+    }
+
+    if (result && !write_answers(&batch, output)) {
+        printf("Error: can't write answers to file %s\n", output);
+        result = false;
+    }
+
+    if (batch.answers != nullptr) {
+        for (size_t i = 0; i < n_threads; ++i) {
+            text_buffer_dtor(&batch.answers[i]);
+        }
+    }
+
+    free(batch.answers);
+    free(batch.chunks);
+    free(batch.lines);
+
+    unmap_file(text, size);
+
+    return result;
+}
+
+// Lines are ended with '\0' in place of '\n', text is mapped privately
+
+static bool split_lines(char *text, size_t size, char ***lines, size_t *n_lines) {
+    assert(text    != nullptr);
+    assert(lines   != nullptr);
+    assert(n_lines != nullptr);
+
+    size_t n_ends = 0;
+
+    for (char *end = text; (end = (char*) memchr(end, '\n', size - (size_t) (end - text))) != nullptr; ++end) {
+        ++n_ends;
+    }
+
+    *lines = (char**) calloc(n_ends + 1, sizeof(char*));
+
+    if (*lines == nullptr) {
+        return false;
+    }
+
+    char *line = text;
+
+    for (size_t i = 0; i <= n_ends; ++i) {
+        char *end = (i < n_ends) ? (char*) memchr(line, '\n', size - (size_t) (line - text)) : text + size;
+
+        if (end > line && end[-1] == '\r') {
+            end[-1] = '\0';
+        }
+
+        *end = '\0';
+
+        (*lines)[i] = line;
+
+        line = end + 1;
+    }
+
+    *n_lines = n_ends + 1;
+
+    return true;
+}
+
+// Calling thread answers queries too, so if threads can't be started
+// all of them are answered by it
+
+static bool run_batch(Batch *batch, size_t n_threads) {
+    assert(batch     != nullptr);
+    assert(n_threads != 0);
+
+    batch->n_chunks = (batch->n_lines + Query_chunk_size - 1) / Query_chunk_size;
+
+    batch->chunks  = (Query_chunk*)  calloc(batch->n_chunks, sizeof(Query_chunk));
+    batch->answers = (Text_buffer*)  calloc(n_threads,       sizeof(Text_buffer));
+
+    Batch_thread *threads  = (Batch_thread*) calloc(n_threads, sizeof(Batch_thread));
+    pthread_t    *handles  = (pthread_t*)    calloc(n_threads, sizeof(pthread_t));
+
+    if (batch->chunks == nullptr || batch->answers == nullptr || threads == nullptr || handles == nullptr) {
+        free(threads);
+        free(handles);
+        return false;
+    }
+
+    for (size_t i = 0; i < n_threads; ++i) {
+        batch->answers[i] = {};
+
+        threads[i].batch = batch;
+        threads[i].index = i;
+    }
+
+    size_t n_started = 1;
+
+    for (; n_started < n_threads; ++n_started) {
+        if (pthread_create(&handles[n_started], nullptr, answer_chunks, &threads[n_started]) != 0) {
+            break;
+        }
+    }
+
+    answer_chunks(&threads[0]);
+
+    for (size_t i = 1; i < n_started; ++i) {
+        pthread_join(handles[i], nullptr);
+    }
+
+    free(threads);
+    free(handles);
+
+    return batch->is_correct;
+}
+
+static void* answer_chunks(void *thread_ptr) {
+    assert(thread_ptr != nullptr);
+
+    Batch_thread *thread  = (Batch_thread*) thread_ptr;
+    Batch        *batch   = thread->batch;
+    Text_buffer  *answers = &batch->answers[thread->index];
+
+    while (batch->is_correct) {
+        size_t i = batch->next++;
+
+        if (i >= batch->n_chunks) {
+            break;
+        }
+
+        size_t first = i * Query_chunk_size;
+        size_t end   = (first + Query_chunk_size < batch->n_lines) ? first + Query_chunk_size : batch->n_lines;
+
+        batch->chunks[i].thread = thread->index;
+        batch->chunks[i].begin  = answers->size;
+
+        for (size_t line = first; line < end; ++line) {
+            answer_query(batch->sources, answers, batch->lines[line], line + 1);
+        }
+
+        batch->chunks[i].end = answers->size;
+
+        if (!answers->is_ok) {
+            batch->is_correct = false;
+        }
+    }
+
+    return nullptr;
+}
+
+static void answer_query(const Query_sources *sources, Text_buffer *answers, char *line, size_t line_number) {
+    assert(sources != nullptr);
+    assert(answers != nullptr);
+    assert(line    != nullptr);
+
+    line += scan_spaces(line, 0);
+
+    if (*line == '\0') {
+        return;
+    }
+
+    if (is_command(line, "define")) {
+        line += sizeof("define") - 1;
+
+        char *name = read_query_name(&line, true);
+
+        if (name == nullptr) {
+            buffer_printf(answers, "Error: incorrect query at line %zu\n", line_number);
+            return;
+        }
+
+        Node_id leaf = find_query_character(sources, answers, name);
+
+        if (leaf != No_node) {
+            write_definition(answers, sources->tree, leaf);
+        }
+
+        return;
+    }
+
+    if (is_command(line, "diff")) {
+        line += sizeof("diff") - 1;
+
+        char *name1 = read_query_name(&line, false);
+        char *name2 = (name1 == nullptr) ? nullptr : read_query_name(&line, true);
+
+        if (name2 == nullptr) {
+            buffer_printf(answers, "Error: incorrect query at line %zu\n", line_number);
+            return;
+        }
+
+        Node_id leaf1 = find_query_character(sources, answers, name1);
+        Node_id leaf2 = find_query_character(sources, answers, name2);
+
+        if (leaf1 == No_node || leaf2 == No_node) {
+            return;
+        }
+
+        if (leaf1 == leaf2) {
+            buffer_printf(answers, "Characters %s and %s are the same.\n", name1, name2);
+            return;
+        }
+
+        write_difference(answers, sources->tree, sources->ancestry, name1, leaf1, name2, leaf2);
+        return;
+    }
+
+    buffer_printf(answers, "Error: unknown query at line %zu\n", line_number);
+}
+
+static Node_id find_query_character(const Query_sources *sources, Text_buffer *answers, const char *name) {
+    assert(sources != nullptr);
+    assert(answers != nullptr);
+    assert(name    != nullptr);
+
+    Node_id node = find_name(sources->names, sources->tree, name);
+
+    if (node == No_node) {
+        buffer_printf(answers, "Sorry, I don't know character %s.\n", name);
+        return No_node;
+    }
+
+    if (!is_leaf(sources->tree, node)) {
+        buffer_printf(answers, "Entered name %s is not a characters, but a property of character.\n", name);
+        return No_node;
+    }
+
+    return node;
+}
+
+// Name is ended with '\0' in place, line is moved after it. The last name
+// of query without quotes takes the rest of the line.
+
+static char* read_query_name(char **line, bool is_last) {
+    assert(line  != nullptr);
+    assert(*line != nullptr);
+
+    char *name = *line + scan_spaces(*line, 0);
+    char *end  = nullptr;
+
+    if (*name == '"') {
+        ++name;
+
+        end = strchr(name, '"');
+
+        if (end == nullptr) {
+            return nullptr;
+        }
+
+    } else if (is_last) {
+        end = name + strlen(name);
+
+        while (end > name && (end[-1] == ' ' || end[-1] == '\t')) {
+            --end;
+        }
+
+    } else {
+        end = name + strcspn(name, " \t");
+    }
+
+    if (end == name) {
+        return nullptr;
+    }
+
+    *line = (*end == '\0') ? end : end + 1;
+    *end  = '\0';
+
+    if (is_last && (*line)[scan_spaces(*line, 0)] != '\0') {
+        return nullptr;
+    }
+
+    return name;
+}
+
+static bool is_command(const char *line, const char *command) {
+    assert(line    != nullptr);
+    assert(command != nullptr);
+
+    size_t len = strlen(command);
+
+    return strncmp(line, command, len) == 0 && (line[len] == ' ' || line[len] == '\t');
+}
+
+static bool write_answers(const Batch *batch, const char *output) {
+    assert(batch  != nullptr);
+    assert(output != nullptr);
+
+    FILE *file = fopen(output, "w");
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool result = true;
+
+    for (size_t i = 0; i < batch->n_chunks && result; ++i) {
+        const Query_chunk *chunk = &batch->chunks[i];
+
+        size_t len = chunk->end - chunk->begin;
+
+        if (len != 0) {
+            result = fwrite(batch->answers[chunk->thread].data + chunk->begin, sizeof(char), len, file) == len;
+        }
+    }
+
+    return fclose(file) == 0 && result;
+}
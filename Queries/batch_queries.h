@@ -0,0 +1,29 @@
+#ifndef BATCH_QUERIES_H
+#define BATCH_QUERIES_H
+
+#include "../Tree/tree.h"
+#include "../Tree/name_index.h"
+#include "../Tree/ancestry.h"
+
+// Queries are lines of text file:
+//
+//   define <name>
+//   diff <name> <name>
+//
+// Names with spaces are written in quotes, name of define can be written
+// without them. Empty lines are skipped.
+//
+// Queries are answered by several threads over tree which is not changed
+// meanwhile. Every thread writes answers to its own buffer, they are
+// written to output file in order of queries.
+
+struct Query_sources {
+    const Tree*       tree     = nullptr;
+    const Name_index* names    = nullptr;
+    const Ancestry*   ancestry = nullptr;
+};
+
+bool answer_queries(const Query_sources *sources, const char *queries, const char *output,
+                    size_t n_threads);
+
+#endif
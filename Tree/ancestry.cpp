@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <assert.h>
+
+#include "ancestry.h"
+#include "../Libs/file_reading.hpp"
+
+static Node_id lift_common_ancestor(const Tree *tree, Node_id first, Node_id second);
+
+static uint32_t get_depth(const Tree *tree, Node_id node);
+
+static bool reserve_ancestry(Ancestry *ancestry, size_t capacity);
+
+
+// Arrays have place for all nodes of node array and grow together with
+// it. Nodes are added in preorder, parent goes before children, tree is
+// walked by parent ids without stack.
+
+bool build_ancestry(Ancestry *ancestry, const Tree *tree) {
+    assert(ancestry != nullptr);
+    assert(tree     != nullptr);
+
+    if (!reserve_ancestry(ancestry, tree->capacity)) {
+        ancestry_dtor(ancestry);
+        return false;
+    }
+
+    if (tree->head == No_node) {
+        return true;
+    }
+
+    ancestry->depths[tree->head] = 0;
+    ancestry->jumps [tree->head] = tree->head;
+
+    Node_id node = tree->head;
+
+    while (true) {
+        if (!is_leaf(tree, node)) {
+            node = node_left(tree, node);
+
+            if (!add_ancestry_node(ancestry, tree, node)) {
+                return false;
+            }
+
+            continue;
+        }
+
+        while (node != tree->head && !is_left_child(tree, node)) {
+            node = node_parent(tree, node);
+        }
+
+        if (node == tree->head) {
+            return true;
+        }
+
+        node = node_right(tree, node_parent(tree, node));
+
+        if (!add_ancestry_node(ancestry, tree, node)) {
+            return false;
+        }
+    }
+}
+
+// Node jumps over two equal jumps of its parent if there are such, so
+// lengths of jumps on any path are 1, 1, 3, 1, 1, 3, 7...
+
+bool add_ancestry_node(Ancestry *ancestry, const Tree *tree, Node_id node) {
+    assert(ancestry         != nullptr);
+    assert(ancestry->depths != nullptr);
+    assert(tree             != nullptr);
+    assert(node             != No_node);
+
+    if (node >= ancestry->capacity && !reserve_ancestry(ancestry, tree->capacity)) {
+        return false;
+    }
+
+    uint32_t *depths = ancestry->depths;
+    Node_id  *jumps  = ancestry->jumps;
+
+    Node_id parent = node_parent(tree, node);
+    Node_id jump   = jumps[parent];
+
+    depths[node] = depths[parent] + 1;
+
+    if (depths[parent] - depths[jump] == depths[jump] - depths[jumps[jump]]) {
+        jumps[node] = jumps[jump];
+    } else {
+        jumps[node] = parent;
+    }
+
+    return true;
+}
+
+Node_id find_ancestor(const Ancestry *ancestry, const Tree *tree, Node_id node, uint32_t depth) {
+    assert(ancestry         != nullptr);
+    assert(ancestry->depths != nullptr);
+    assert(tree             != nullptr);
+    assert(node             != No_node);
+    assert(ancestry->depths[node] >= depth);
+
+    while (ancestry->depths[node] > depth) {
+        if (ancestry->depths[ancestry->jumps[node]] >= depth) {
+            node = ancestry->jumps[node];
+        } else {
+            node = node_parent(tree, node);
+        }
+    }
+
+    return node;
+}
+
+// Nodes of the same depth have jumps of the same length, so they jump
+// together while they don't meet
+
+Node_id find_common_ancestor(const Ancestry *ancestry, const Tree *tree,
+                             Node_id first, Node_id second) {
+    assert(ancestry != nullptr);
+    assert(tree     != nullptr);
+    assert(first    != No_node);
+    assert(second   != No_node);
+
+    if (ancestry->depths == nullptr) {
+        return lift_common_ancestor(tree, first, second);
+    }
+
+    uint32_t first_depth  = ancestry->depths[first];
+    uint32_t second_depth = ancestry->depths[second];
+
+    if (first_depth > second_depth) {
+        first  = find_ancestor(ancestry, tree, first,  second_depth);
+    } else {
+        second = find_ancestor(ancestry, tree, second, first_depth);
+    }
+
+    while (first != second) {
+        if (ancestry->jumps[first] != ancestry->jumps[second]) {
+            first  = ancestry->jumps[first];
+            second = ancestry->jumps[second];
+        } else {
+            first  = node_parent(tree, first);
+            second = node_parent(tree, second);
+        }
+    }
+
+    return first;
+}
+
+void ancestry_dtor(Ancestry *ancestry) {
+    assert(ancestry != nullptr);
+
+    unmap_file((char*) ancestry->depths, ancestry->capacity * sizeof(uint32_t));
+    unmap_file((char*) ancestry->jumps,  ancestry->capacity * sizeof(Node_id));
+
+    ancestry->depths   = nullptr;
+    ancestry->jumps    = nullptr;
+    ancestry->capacity = 0;
+}
+
+// Arrays take the size of node array, they are not moved if they are big enough
+
+static bool reserve_ancestry(Ancestry *ancestry, size_t capacity) {
+    assert(ancestry != nullptr);
+
+    if (ancestry->depths != nullptr && capacity <= ancestry->capacity) {
+        return true;
+    }
+
+    uint32_t *depths = (uint32_t*) (void*) grow_anonymous((char*) ancestry->depths,
+                                                          ancestry->capacity * sizeof(uint32_t),
+                                                          capacity           * sizeof(uint32_t));
+    if (depths == nullptr) {
+        return false;
+    }
+
+    ancestry->depths = depths;
+
+    Node_id *jumps = (Node_id*) (void*) grow_anonymous((char*) ancestry->jumps,
+                                                       ancestry->capacity * sizeof(Node_id),
+                                                       capacity           * sizeof(Node_id));
+    if (jumps == nullptr) {
+        unmap_file((char*) ancestry->depths, capacity * sizeof(uint32_t));
+
+        ancestry->depths = nullptr;             // jumps are unmapped by ancestry_dtor()
+        return false;
+    }
+
+    ancestry->jumps    = jumps;
+    ancestry->capacity = capacity;
+
+    return true;
+}
+
+static Node_id lift_common_ancestor(const Tree *tree, Node_id first, Node_id second) {
+    assert(tree != nullptr);
+
+    uint32_t first_depth  = get_depth(tree, first);
+    uint32_t second_depth = get_depth(tree, second);
+
+    for (; first_depth > second_depth; --first_depth) {
+        first = node_parent(tree, first);
+    }
+
+    for (; second_depth > first_depth; --second_depth) {
+        second = node_parent(tree, second);
+    }
+
+    while (first != second) {
+        first  = node_parent(tree, first);
+        second = node_parent(tree, second);
+    }
+
+    return first;
+}
+
+static uint32_t get_depth(const Tree *tree, Node_id node) {
+    assert(tree != nullptr);
+
+    uint32_t depth = 0;
+
+    while (node_parent(tree, node) != No_node) {
+        node = node_parent(tree, node);
+        ++depth;
+    }
+
+    return depth;
+}
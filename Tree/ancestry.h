@@ -0,0 +1,35 @@
+#ifndef ANCESTRY_H
+#define ANCESTRY_H
+
+#include "tree.h"
+
+// Depth and jump pointer of every node: jump of node leads to its ancestor
+// chosen so that jumps of different length form skew-binary sequence. Any
+// ancestor and the lowest common ancestor of two nodes are found in O(log n)
+// jumps, while node added to the tree takes O(1) time and 8 bytes.
+//
+// Arrays are indexed by node ids, so they are built again after ids are
+// changed by relayout of the tree.
+
+struct Ancestry {
+    uint32_t* depths   = nullptr;       // nullptr if ancestry is not built
+    Node_id*  jumps    = nullptr;
+    size_t    capacity = 0;             // ids which have place in arrays
+};
+
+bool build_ancestry(Ancestry *ancestry, const Tree *tree);
+
+// Parent of node must be in ancestry already. Returns false if arrays can't grow.
+
+bool add_ancestry_node(Ancestry *ancestry, const Tree *tree, Node_id node);
+
+Node_id find_ancestor(const Ancestry *ancestry, const Tree *tree, Node_id node, uint32_t depth);
+
+// Without built ancestry nodes are lifted by parents
+
+Node_id find_common_ancestor(const Ancestry *ancestry, const Tree *tree,
+                             Node_id first, Node_id second);
+
+void ancestry_dtor(Ancestry *ancestry);
+
+#endif
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <assert.h>
+
+#include "definitions.h"
+
+static void write_properties(Text_buffer *text, const Tree *tree, Node_id top, Node_id node);
+
+static void write_property(Text_buffer *text, const Tree *tree, Node_id node, const char *comma);
+
+
+void write_definition(Text_buffer *text, const Tree *tree, Node_id leaf) {
+    assert(text != nullptr);
+    assert(tree != nullptr);
+    assert(leaf != No_node);
+
+    buffer_printf(text, "%s", node_text(tree, leaf));
+
+    for (Node_id node = leaf; node != tree->head; node = node_parent(tree, node)) {
+        write_property(text, tree, node, (node == leaf) ? " " : ", ");
+    }
+
+    buffer_append(text, ".\n", 2);
+}
+
+void write_difference(Text_buffer *text, const Tree *tree, const Ancestry *ancestry,
+                      const char *name1, Node_id leaf1, const char *name2, Node_id leaf2) {
+    assert(text     != nullptr);
+    assert(tree     != nullptr);
+    assert(ancestry != nullptr);
+    assert(name1    != nullptr);
+    assert(name2    != nullptr);
+    assert(leaf1    != leaf2);
+
+    Node_id common = find_common_ancestor(ancestry, tree, leaf1, leaf2);
+
+    if (common == tree->head) {
+        buffer_printf(text, "Characters %s and %s have nothing in common.\n", name1, name2);
+    } else {
+        buffer_printf(text, "%s like %s", name1, name2);
+
+        write_properties(text, tree, tree->head, common);
+    }
+
+    buffer_printf(text, "Unlike %s, %s", name2, name1);
+
+    write_properties(text, tree, common, leaf1);
+
+    buffer_printf(text, "At the same time %s", name2);
+
+    write_properties(text, tree, common, leaf2);
+}
+
+// Properties are answers on the path from top to node. They are written
+// from top, so the path is collected first.
+
+static void write_properties(Text_buffer *text, const Tree *tree, Node_id top, Node_id node) {
+    assert(text != nullptr);
+    assert(tree != nullptr);
+    assert(top  != No_node);
+    assert(node != top);
+
+    size_t n_props = 0;
+
+    for (Node_id prop = node; prop != top; prop = node_parent(tree, prop)) {
+        ++n_props;
+    }
+
+    Node_id *props = (Node_id*) calloc(n_props, sizeof(Node_id));
+
+    if (props == nullptr) {
+        text->is_ok = false;
+        return;
+    }
+
+    for (size_t i = n_props; i > 0; --i, node = node_parent(tree, node)) {
+        props[i - 1] = node;
+    }
+
+    for (size_t i = 0; i < n_props; ++i) {
+        write_property(text, tree, props[i], (i == 0) ? " " : ", ");
+    }
+
+    buffer_append(text, ".\n", 2);
+
+    free(props);
+}
+
+// Property of node is answer on the question of its parent
+
+static void write_property(Text_buffer *text, const Tree *tree, Node_id node, const char *comma) {
+    assert(text  != nullptr);
+    assert(tree  != nullptr);
+    assert(comma != nullptr);
+
+    if (is_left_child(tree, node)) {
+        buffer_printf(text, "%s%s",     comma, node_text(tree, node_parent(tree, node)));
+    } else {
+        buffer_printf(text, "%snot %s", comma, node_text(tree, node_parent(tree, node)));
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef DEFINITIONS_H
+#define DEFINITIONS_H
+
+#include "tree.h"
+#include "ancestry.h"
+#include "../Libs/text_buffer.h"
+
+// Texts of definition and difference modes. They only read the tree, so
+// several threads can write them at once to their own buffers.
+
+// Properties go from the character to the root
+
+void write_definition(Text_buffer *text, const Tree *tree, Node_id leaf);
+
+// Common properties are above common ancestor of characters, different
+// ones are below it. Characters are named as they were entered.
+
+void write_difference(Text_buffer *text, const Tree *tree, const Ancestry *ancestry,
+                      const char *name1, Node_id leaf1, const char *name2, Node_id leaf2);
+
+#endif
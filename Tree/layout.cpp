@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "layout.h"
+#include "../Libs/file_reading.hpp"
+
+struct Node_list {
+    Node_id* data     = nullptr;
+    size_t   size     = 0;
+    size_t   capacity = 0;
+};
+
+static bool get_veb_order(const Tree *tree, Node_id root, size_t height, Node_list *order);
+
+static bool get_bfs_order(const Tree *tree, Node_list *order);
+
+static bool collect_level(const Tree *tree, Node_id root, size_t depth, Node_list *nodes);
+
+static size_t get_height(const Tree *tree, Node_id root);
+
+static bool move_nodes(Tree *tree, const Node_list *order);
+
+static bool append_node(Node_list *list, Node_id node);
+
+
+bool relayout_tree(Tree *tree, Tree_layout layout) {
+    assert(tree           != nullptr);
+    assert(tree->snapshot == nullptr);
+    assert(tree->expander == nullptr);
+
+    if (layout == No_layout || tree->head == No_node) {
+        return true;
+    }
+
+    // Every node is put to order once, so its size is known
+
+    Node_list order = {};
+
+    order.capacity = tree->n_nodes;
+    order.data     = (Node_id*) calloc(order.capacity, sizeof(Node_id));
+
+    if (order.data == nullptr) {
+        return false;
+    }
+
+    bool is_ordered = (layout == Veb_layout)
+                    ? get_veb_order(tree, tree->head, get_height(tree, tree->head), &order)
+                    : get_bfs_order(tree, &order);
+
+    bool result = is_ordered && move_nodes(tree, &order);
+
+    free(order.data);
+
+    return result;
+}
+
+// Subtree of given height is split into top subtree of half height and
+// bottom subtrees hanging from it, each of them is laid out recursively.
+// Depth of recursion is logarithm of height.
+
+static bool get_veb_order(const Tree *tree, Node_id root, size_t height, Node_list *order) {
+    assert(tree  != nullptr);
+    assert(root  != No_node);
+    assert(order != nullptr);
+
+    if (height <= 1 || is_leaf(tree, root)) {
+        return append_node(order, root);
+    }
+
+    size_t top_height = height / 2;
+
+    if (!get_veb_order(tree, root, top_height, order)) {
+        return false;
+    }
+
+    Node_list bottom_roots = {};
+
+    bool result = collect_level(tree, root, top_height, &bottom_roots);
+
+    for (size_t i = 0; i < bottom_roots.size && result; ++i) {
+        result = get_veb_order(tree, bottom_roots.data[i], height - top_height, order);
+    }
+
+    free(bottom_roots.data);
+
+    return result;
+}
+
+static bool get_bfs_order(const Tree *tree, Node_list *order) {
+    assert(tree  != nullptr);
+    assert(order != nullptr);
+
+    if (!append_node(order, tree->head)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < order->size; ++i) {
+        Node_id node = order->data[i];
+
+        if (is_leaf(tree, node)) {
+            continue;
+        }
+
+        if (!append_node(order, node_left(tree, node)) || !append_node(order, node_right(tree, node))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Nodes lying depth levels below root are collected from left to right.
+// Subtree is walked by parent ids without stack, so deep trees are fine.
+
+static bool collect_level(const Tree *tree, Node_id root, size_t depth, Node_list *nodes) {
+    assert(tree  != nullptr);
+    assert(root  != No_node);
+    assert(nodes != nullptr);
+
+    Node_id node  = root;
+    size_t  level = 0;
+
+    while (true) {
+        if (level < depth && !is_leaf(tree, node)) {
+
+            node = node_left(tree, node);
+
+            ++level;
+
+            continue;
+        }
+
+        if (level == depth && !append_node(nodes, node)) {
+            return false;
+        }
+
+        while (node != root && !is_left_child(tree, node)) {
+
+            node = node_parent(tree, node);
+
+            --level;
+        }
+
+        if (node == root) {
+            return true;
+        }
+
+        node = node_right(tree, node_parent(tree, node));
+    }
+}
+
+static size_t get_height(const Tree *tree, Node_id root) {
+    assert(tree != nullptr);
+    assert(root != No_node);
+
+    Node_id node   = root;
+    size_t  level  = 0;
+    size_t  height = 0;
+
+    while (true) {
+        if (!is_leaf(tree, node)) {
+
+            node = node_left(tree, node);
+
+            ++level;
+
+            continue;
+        }
+
+        height = (level + 1 > height) ? level + 1 : height;
+
+        while (node != root && !is_left_child(tree, node)) {
+
+            node = node_parent(tree, node);
+
+            --level;
+        }
+
+        if (node == root) {
+            return height;
+        }
+
+        node = node_right(tree, node_parent(tree, node));
+    }
+}
+
+// Nodes are copied to new array in given order, ids in their links are
+// replaced with new ones. Freed nodes are not copied, so free list is empty.
+
+static bool move_nodes(Tree *tree, const Node_list *order) {
+    assert(tree  != nullptr);
+    assert(order != nullptr);
+
+    size_t capacity = order->size + 1;
+
+    Tree_node *nodes   = (Tree_node*) (void*) map_anonymous(capacity * sizeof(Tree_node));
+    Node_id   *new_ids = (Node_id*)   calloc(tree->n_nodes, sizeof(Node_id));
+
+    if (nodes == nullptr || new_ids == nullptr) {
+        unmap_file((char*) nodes, capacity * sizeof(Tree_node));
+        free(new_ids);
+
+        return false;
+    }
+
+    for (size_t i = 0; i < order->size; ++i) {
+        new_ids[order->data[i]] = (Node_id) i + 1;
+    }
+
+    for (size_t i = 0; i < order->size; ++i) {
+        const Tree_node *node  = &tree->nodes[order->data[i]];
+        Tree_node       *moved = &nodes[i + 1];
+
+        moved->left   = new_ids[node->left];
+        moved->right  = new_ids[node->right];
+        moved->parent = new_ids[node->parent & Node_id_mask] | (node->parent & ~Node_id_mask);
+        moved->text   = node->text;
+    }
+
+    unmap_file((char*) tree->nodes, tree->capacity * sizeof(Tree_node));
+
+    tree->nodes      = nodes;
+    tree->capacity   = (Node_id) capacity;
+    tree->head       = new_ids[tree->head];
+    tree->n_nodes    = (Node_id) order->size + 1;
+    tree->free_nodes = No_node;
+
+    free(new_ids);
+
+    return true;
+}
+
+static bool append_node(Node_list *list, Node_id node) {
+    assert(list != nullptr);
+
+    if (list->size == list->capacity) {
+        size_t capacity = (list->capacity == 0) ? 16 : 2 * list->capacity;
+
+        Node_id *data = (Node_id*) realloc(list->data, capacity * sizeof(Node_id));
+
+        if (data == nullptr) {
+            return false;
+        }
+
+        list->data     = data;
+        list->capacity = capacity;
+    }
+
+    list->data[list->size++] = node;
+
+    return true;
+}
@@ -0,0 +1,24 @@
+#ifndef TREE_LAYOUT_H
+#define TREE_LAYOUT_H
+
+#include "tree.h"
+
+// Nodes of tree can be moved to the beginning of node array in order which
+// keeps nodes of one root-to-leaf path close to each other:
+//
+//   Veb_layout - van Emde Boas order: top half of levels is laid out first,
+//                then every subtree hanging from it, both recursively, so
+//                a path crosses O(log n / log B) blocks of any size B;
+//   Bfs_layout - breadth-first order, top levels are packed together.
+//
+// Ids of nodes are changed, so nobody should keep them while tree is laid out.
+
+enum Tree_layout {
+    No_layout = 0,
+    Veb_layout,
+    Bfs_layout,
+};
+
+bool relayout_tree(Tree *tree, Tree_layout layout);
+
+#endif
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "name_index.h"
+
+static Name_slot* find_slot(const Name_index *index, const Tree *tree, 
+                            const char *name, size_t len, uint32_t hash);
+
+static bool grow_index(Name_index *index);
+
+static size_t get_slot(uint32_t hash, size_t capacity);
+
+
+static const size_t Index_start_capacity = 1 << 4;
+
+
+// Leaves are added in preorder, tree is walked by parent ids without stack
+
+bool build_name_index(Name_index *index, const Tree *tree) {
+    assert(index != nullptr);
+    assert(tree  != nullptr);
+
+    name_index_dtor(index);
+
+    if (tree->head == No_node) {
+        return true;
+    }
+
+    Node_id node = tree->head;
+
+    while (true) {
+        if (!is_leaf(tree, node)) {
+            node = node_left(tree, node);
+            continue;
+        }
+
+        if (!add_name(index, tree, node)) {
+            return false;
+        }
+
+        while (node != tree->head && !is_left_child(tree, node)) {
+            node = node_parent(tree, node);
+        }
+
+        if (node == tree->head) {
+            return true;
+        }
+
+        node = node_right(tree, node_parent(tree, node));
+    }
+}
+
+bool add_name(Name_index *index, const Tree *tree, Node_id leaf, Node_id *existing) {
+    assert(index != nullptr);
+    assert(tree  != nullptr);
+    assert(leaf  != No_node);
+
+    if (existing != nullptr) {
+        *existing = No_node;
+    }
+
+    if (4 * (index->size + 1) > 3 * index->capacity && !grow_index(index)) {
+        return false;
+    }
+
+    Text_id text = tree->nodes[leaf].text;
+
+    const char *name = get_text(tree, text);
+    size_t      len  = get_string_len(&tree->strings, text);
+    uint32_t    hash = tree->strings.entries[text].hash;
+
+    Name_slot *slot = find_slot(index, tree, name, len, hash);
+
+    if (slot->node != No_node) {
+        ++(index->n_duplicates);
+
+        index->duplicate = leaf;
+
+        if (existing != nullptr) {
+            *existing = slot->node;
+        }
+
+        return true;
+    }
+
+    slot->hash = hash;
+    slot->node = leaf;
+
+    ++(index->size);
+
+    return true;
+}
+
+void move_name(Name_index *index, const Tree *tree, Node_id old_leaf, Node_id new_leaf) {
+    assert(index    != nullptr);
+    assert(tree     != nullptr);
+    assert(old_leaf != No_node);
+    assert(new_leaf != No_node);
+
+    if (index->capacity == 0) {
+        return;
+    }
+
+    // Old leaf can have another text already, so its slot is found by id.
+    // Duplicate name is not indexed, so nothing is moved for it.
+
+    uint32_t hash = tree->strings.entries[tree->nodes[new_leaf].text].hash;
+
+    for (size_t slot = get_slot(hash, index->capacity); index->slots[slot].node != No_node;
+                                                        slot = (slot + 1) & (index->capacity - 1)) {
+
+        if (index->slots[slot].node == old_leaf) {
+            index->slots[slot].node = new_leaf;
+            return;
+        }
+    }
+}
+
+Node_id find_name(const Name_index *index, const Tree *tree, const char *name) {
+    assert(index != nullptr);
+    assert(tree  != nullptr);
+    assert(name  != nullptr);
+
+    if (index->capacity == 0) {
+        return No_node;
+    }
+
+    size_t len = strlen(name);
+
+    return find_slot(index, tree, name, len, get_folded_hash(name, len))->node;
+}
+
+void name_index_dtor(Name_index *index) {
+    assert(index != nullptr);
+
+    free(index->slots);
+
+    index->slots        = nullptr;
+    index->capacity     = 0;
+    index->size         = 0;
+    index->n_duplicates = 0;
+    index->duplicate    = No_node;
+}
+
+// Returns slot with the name or empty slot where it should be
+
+static Name_slot* find_slot(const Name_index *index, const Tree *tree, 
+                            const char *name, size_t len, uint32_t hash) {
+    assert(index           != nullptr);
+    assert(index->capacity != 0);
+    assert(tree            != nullptr);
+    assert(name            != nullptr);
+
+    size_t slot = get_slot(hash, index->capacity);
+
+    while (index->slots[slot].node != No_node) {
+        if (index->slots[slot].hash == hash && 
+            equal_folded(&tree->strings, tree->nodes[index->slots[slot].node].text, name, len, hash)) {
+            break;
+        }
+
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+
+    return &index->slots[slot];
+}
+
+static bool grow_index(Name_index *index) {
+    assert(index != nullptr);
+
+    size_t capacity = (index->capacity == 0) ? Index_start_capacity : 2 * index->capacity;
+
+    Name_slot *slots = (Name_slot*) calloc(capacity, sizeof(Name_slot));
+
+    if (slots == nullptr) {
+        return false;
+    }
+
+    for (size_t i = 0; i < index->capacity; ++i) {
+        if (index->slots[i].node == No_node) {
+            continue;
+        }
+
+        size_t slot = get_slot(index->slots[i].hash, capacity);
+
+        while (slots[slot].node != No_node) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        slots[slot] = index->slots[i];
+    }
+
+    free(index->slots);
+
+    index->slots    = slots;
+    index->capacity = capacity;
+
+    return true;
+}
+
+static size_t get_slot(uint32_t hash, size_t capacity) {
+    return hash & (capacity - 1);
+}
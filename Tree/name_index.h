@@ -0,0 +1,39 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include "tree.h"
+
+// Hash index of character names: leaves of the tree by their names
+// regardless of case. If several leaves have the same name, the first one
+// in preorder is indexed (as full search would find it) and others are
+// counted as duplicates.
+
+struct Name_slot {
+    uint32_t hash = 0;
+    Node_id  node = No_node;        // No_node for empty slot
+};
+
+struct Name_index {
+    Name_slot* slots        = nullptr;
+    size_t     capacity     = 0;
+    size_t     size         = 0;
+    size_t     n_duplicates = 0;
+    Node_id    duplicate    = No_node;  // some leaf which name is taken by another one
+};
+
+bool build_name_index(Name_index *index, const Tree *tree);
+
+// If another leaf already has the same name, it is kept in index and
+// given to existing (if it is not nullptr), otherwise existing gets No_node
+
+bool add_name(Name_index *index, const Tree *tree, Node_id leaf, Node_id *existing = nullptr);
+
+// Leaf's name now belongs to another node, e.g. after split of the leaf
+
+void move_name(Name_index *index, const Tree *tree, Node_id old_leaf, Node_id new_leaf);
+
+Node_id find_name(const Name_index *index, const Tree *tree, const char *name);
+
+void name_index_dtor(Name_index *index);
+
+#endif
@@ -0,0 +1,596 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "name_search.h"
+
+static const size_t Max_similar = 16;
+
+// Beginning of name in lower case, read as big-endian number, orders
+// most of names without reading their texts
+
+struct Sort_key {
+    uint64_t prefix = 0;
+    Text_id  text   = No_text;
+};
+
+struct Similar_names {
+    Text_id* found                  = nullptr;
+    size_t   distances[Max_similar] = {};
+    size_t   n_found                = 0;
+    size_t   max_found              = 0;
+};
+
+static bool add_leaf_names(Name_search *search, const Tree *tree);
+
+static bool sort_names(Name_search *search, const Tree *tree);
+
+static size_t remove_equal_names(Name_search *search, const Tree *tree);
+
+static bool build_typo_index(Name_search *search, const Tree *tree);
+
+static size_t hash_keys(const Name_search *search, const Tree *tree, size_t *name,
+                        uint32_t *buckets, Text_id *names);
+
+static size_t get_n_keys(size_t len);
+
+static uint32_t mix_hash(uint64_t hash);
+
+static size_t get_key_hashes(const char *name, size_t len, uint32_t *hashes);
+
+static void check_similar(const Tree *tree, Text_id text, const char *name, size_t len,
+                          size_t max_typos, Similar_names *similar);
+
+static size_t find_position(const Name_search *search, const Tree *tree, const char *name, size_t len);
+
+static int compare_names(const char *first, size_t first_len, const char *second, size_t second_len);
+
+static int compare_texts(const Tree *tree, Text_id first, Text_id second);
+
+static size_t get_distance(const char *first, size_t first_len, const char *second, size_t second_len);
+
+static bool append_text(Text_id **texts, size_t *size, size_t *capacity, Text_id text);
+
+static unsigned char fold_case(char sym);
+
+
+static const size_t Search_start_capacity = 1 << 4;
+
+static const size_t Max_distance      = Max_typos + 1;  // larger distances are not counted
+static const size_t Max_compared_len  = 64;             // only beginnings of long names are compared
+static const size_t Max_key_len       = 16;             // keys are made of beginnings of names
+static const size_t Short_name_len    = 4;              // short names can have only one typo
+static const size_t Prefetch_distance = 16;             // keys between prefetch and use of bucket
+static const size_t Key_chunk_size    = 1 << 9;         // should be more than keys of one name, chunk is on stack
+
+static const uint64_t Hash_base  = 0x100000001B3u;
+static const uint64_t Hash_mixer = 0xBF58476D1CE4E5B9u;
+
+
+// Names of leaves are sorted, names equal to previous ones are dropped
+// and the rest is put to typo index
+
+bool build_name_search(Name_search *search, const Tree *tree) {
+    assert(search != nullptr);
+    assert(tree   != nullptr);
+
+    name_search_dtor(search);
+
+    if (tree->head == No_node) {
+        return true;
+    }
+
+    if (!add_leaf_names(search, tree)) {
+        return false;
+    }
+
+    if (!sort_names(search, tree)) {
+        return false;
+    }
+
+    search->size = remove_equal_names(search, tree);
+
+    return build_typo_index(search, tree);
+}
+
+bool add_searched_name(Name_search *search, const Tree *tree, Text_id name) {
+    assert(search != nullptr);
+    assert(tree   != nullptr);
+    assert(name   != No_text);
+
+    size_t position = find_position(search, tree, get_text(tree, name), get_string_len(&tree->strings, name));
+
+    if (position < search->size && compare_texts(tree, search->sorted[position], name) == 0) {
+        return true;
+    }
+
+    if (!append_text(&search->sorted, &search->size, &search->capacity, name)) {
+        return false;
+    }
+
+    memmove(search->sorted + position + 1, search->sorted + position,
+                                          (search->size - 1 - position) * sizeof(Text_id));
+
+    search->sorted[position] = name;
+
+    return append_text(&search->added, &search->n_added, &search->added_capacity, name);
+}
+
+size_t complete_name(const Name_search *search, const Tree *tree, const char *prefix,
+                     Text_id *found, size_t max_found) {
+    assert(search != nullptr);
+    assert(tree   != nullptr);
+    assert(prefix != nullptr);
+    assert(found  != nullptr);
+
+    size_t len     = strlen(prefix);
+    size_t n_found = 0;
+
+    for (size_t i = find_position(search, tree, prefix, len); i < search->size && n_found < max_found; ++i) {
+        Text_id name = search->sorted[i];
+
+        if (get_string_len(&tree->strings, name) < len ||
+            compare_names(get_text(tree, name), len, prefix, len) != 0) {
+            break;
+        }
+
+        found[n_found++] = name;
+    }
+
+    return n_found;
+}
+
+// Buckets of all keys of entered name are checked, names with more typos
+// can be found if they have common key with it
+
+size_t find_similar_names(const Name_search *search, const Tree *tree, const char *name,
+                          Text_id *found, size_t max_found) {
+    assert(search != nullptr);
+    assert(tree   != nullptr);
+    assert(name   != nullptr);
+    assert(found  != nullptr);
+
+    size_t len       = strlen(name);
+    size_t max_typos = (len <= Short_name_len) ? 1 : Max_typos;
+
+    Similar_names similar = {};
+
+    similar.found     = found;
+    similar.max_found = std::min(max_found, Max_similar);
+
+    uint32_t hashes[Max_key_len + 1] = {};
+
+    size_t n_keys = (search->n_buckets != 0) ? get_key_hashes(name, len, hashes) : 0;
+
+    for (size_t key = 0; key < n_keys; ++key) {
+        size_t bucket = hashes[key] & (search->n_buckets - 1);
+
+        for (size_t i = search->buckets[bucket]; i < search->buckets[bucket + 1]; ++i) {
+            check_similar(tree, search->typo_names[i], name, len, max_typos, &similar);
+        }
+    }
+
+    for (size_t i = 0; i < search->n_added; ++i) {
+        check_similar(tree, search->added[i], name, len, max_typos, &similar);
+    }
+
+    return similar.n_found;
+}
+
+void name_search_dtor(Name_search *search) {
+    assert(search != nullptr);
+
+    free(search->sorted);
+    free(search->buckets);
+    free(search->typo_names);
+    free(search->added);
+
+    *search = {};
+}
+
+// Leaves are walked in preorder by parent ids without stack
+
+static bool add_leaf_names(Name_search *search, const Tree *tree) {
+    assert(search != nullptr);
+    assert(tree   != nullptr);
+
+    Node_id node = tree->head;
+
+    while (true) {
+        if (!is_leaf(tree, node)) {
+            node = node_left(tree, node);
+            continue;
+        }
+
+        if (!append_text(&search->sorted, &search->size, &search->capacity, tree->nodes[node].text)) {
+            return false;
+        }
+
+        while (node != tree->head && !is_left_child(tree, node)) {
+            node = node_parent(tree, node);
+        }
+
+        if (node == tree->head) {
+            return true;
+        }
+
+        node = node_right(tree, node_parent(tree, node));
+    }
+}
+
+static bool sort_names(Name_search *search, const Tree *tree) {
+    assert(search != nullptr);
+    assert(tree   != nullptr);
+
+    Sort_key *keys = (Sort_key*) calloc(search->size, sizeof(Sort_key));
+
+    if (keys == nullptr) {
+        return false;
+    }
+
+    for (size_t i = 0; i < search->size; ++i) {
+        const char *name = get_text(tree, search->sorted[i]);
+        size_t      len  = std::min(get_string_len(&tree->strings, search->sorted[i]), sizeof(uint64_t));
+
+        for (size_t j = 0; j < len; ++j) {
+            keys[i].prefix |= (uint64_t) fold_case(name[j]) << (8 * (sizeof(uint64_t) - 1 - j));
+        }
+
+        keys[i].text = search->sorted[i];
+    }
+
+    std::sort(keys, keys + search->size, [tree](const Sort_key &first, const Sort_key &second) {
+        if (first.prefix != second.prefix) {
+            return first.prefix < second.prefix;
+        }
+
+        return compare_texts(tree, first.text, second.text) < 0;
+    });
+
+    for (size_t i = 0; i < search->size; ++i) {
+        search->sorted[i] = keys[i].text;
+    }
+
+    free(keys);
+
+    return true;
+}
+
+static size_t remove_equal_names(Name_search *search, const Tree *tree) {
+    assert(search != nullptr);
+    assert(tree   != nullptr);
+
+    size_t size = 0;
+
+    for (size_t i = 0; i < search->size; ++i) {
+        if (size == 0 || compare_texts(tree, search->sorted[size - 1], search->sorted[i]) != 0) {
+            search->sorted[size++] = search->sorted[i];
+        }
+    }
+
+    return size;
+}
+
+// Buckets are counted first and then filled, so names of all buckets lie
+// in one array. There are about four keys in bucket. Buckets are hit at
+// random, so keys are hashed by chunks and buckets are prefetched.
+
+static bool build_typo_index(Name_search *search, const Tree *tree) {
+    assert(search != nullptr);
+    assert(tree   != nullptr);
+
+    size_t n_keys = 0;
+
+    for (size_t i = 0; i < search->size; ++i) {
+        n_keys += get_n_keys(get_string_len(&tree->strings, search->sorted[i]));
+    }
+
+    if (n_keys >= UINT32_MAX) {
+        return false;
+    }
+
+    size_t n_buckets = Search_start_capacity;
+
+    while (4 * n_buckets < n_keys) {
+        n_buckets *= 2;
+    }
+
+    search->buckets    = (uint32_t*) calloc(n_buckets + 1, sizeof(uint32_t));
+    search->typo_names = (Text_id*)  calloc(n_keys,        sizeof(Text_id));
+
+    if (search->buckets == nullptr || search->typo_names == nullptr) {
+        return false;
+    }
+
+    search->n_buckets = n_buckets;
+
+    uint32_t *buckets = search->buckets;
+
+    uint32_t chunk_buckets[Key_chunk_size] = {};
+    Text_id  chunk_names  [Key_chunk_size] = {};
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t name = 0; name < search->size; ) {
+            size_t chunk_size = hash_keys(search, tree, &name, chunk_buckets, chunk_names);
+
+            for (size_t key = 0; key < chunk_size; ++key) {
+                if (key + Prefetch_distance < chunk_size) {
+                    __builtin_prefetch(&buckets[chunk_buckets[key + Prefetch_distance]], 1);
+                }
+
+                if (pass == 0) {
+                    ++buckets[chunk_buckets[key]];
+                    continue;
+                }
+
+                if (key + Prefetch_distance / 2 < chunk_size) {
+                    __builtin_prefetch(&search->typo_names[buckets[chunk_buckets[key + Prefetch_distance / 2]]], 1);
+                }
+
+                search->typo_names[buckets[chunk_buckets[key]]++] = chunk_names[key];
+            }
+        }
+
+        // Sizes of buckets are replaced with their beginnings, after filling
+        // beginnings become ends, so they are shifted by one bucket
+
+        if (pass == 0) {
+            uint32_t begin = 0;
+
+            for (size_t bucket = 0; bucket < n_buckets; ++bucket) {
+                uint32_t size = buckets[bucket];
+
+                buckets[bucket] = begin;
+
+                begin += size;
+            }
+        } else {
+            memmove(buckets + 1, buckets, n_buckets * sizeof(uint32_t));
+
+            buckets[0] = 0;
+        }
+    }
+
+    return true;
+}
+
+// Keys of whole names starting from given one are hashed while they fit
+// to chunk, name is moved to the first name which is not hashed
+
+static size_t hash_keys(const Name_search *search, const Tree *tree, size_t *name,
+                        uint32_t *buckets, Text_id *names) {
+    assert(search  != nullptr);
+    assert(tree    != nullptr);
+    assert(name    != nullptr);
+    assert(buckets != nullptr);
+    assert(names   != nullptr);
+
+    size_t chunk_size = 0;
+
+    for (; *name < search->size; ++(*name)) {
+        Text_id     text = search->sorted[*name];
+        const char *str  = get_text(tree, text);
+        size_t      len  = get_string_len(&tree->strings, text);
+
+        if (chunk_size + get_n_keys(len) > Key_chunk_size) {
+            break;
+        }
+
+        size_t n_keys = get_key_hashes(str, len, buckets + chunk_size);
+
+        for (size_t key = 0; key < n_keys; ++key, ++chunk_size) {
+            buckets[chunk_size] &= (uint32_t) (search->n_buckets - 1);
+            names  [chunk_size]  = text;
+        }
+    }
+
+    return chunk_size;
+}
+
+// Key number i is the name without its letter i, the last key is the name itself
+
+static size_t get_n_keys(size_t len) {
+    return std::min(len, Max_key_len) + 1;
+}
+
+// Polynomial hash, so hashes of all keys are counted from hashes of
+// prefixes and suffixes of name. Keys get the same hashes as equal names.
+
+static size_t get_key_hashes(const char *name, size_t len, uint32_t *hashes) {
+    assert(name   != nullptr);
+    assert(hashes != nullptr);
+
+    size_t key_len = std::min(len, Max_key_len);
+
+    uint64_t prefixes[Max_key_len + 1] = {};
+
+    for (size_t i = 0; i < key_len; ++i) {
+        prefixes[i + 1] = prefixes[i] * Hash_base + fold_case(name[i]);
+    }
+
+    uint64_t suffix = 0;
+    uint64_t power  = 1;
+
+    for (size_t skipped = key_len; skipped-- > 0; ) {
+        hashes[skipped] = mix_hash(prefixes[skipped] * power + suffix);
+
+        suffix += fold_case(name[skipped]) * power;
+        power  *= Hash_base;
+    }
+
+    hashes[key_len] = mix_hash(prefixes[key_len]);
+
+    return key_len + 1;
+}
+
+static uint32_t mix_hash(uint64_t hash) {
+    hash ^= hash >> 31;
+    hash *= Hash_mixer;
+
+    return (uint32_t) (hash >> 32);
+}
+
+// Found names are kept sorted by distance, the farthest one is replaced
+
+static void check_similar(const Tree *tree, Text_id text, const char *name, size_t len,
+                          size_t max_typos, Similar_names *similar) {
+    assert(tree    != nullptr);
+    assert(name    != nullptr);
+    assert(similar != nullptr);
+
+    for (size_t i = 0; i < similar->n_found; ++i) {
+        if (similar->found[i] == text) {
+            return;
+        }
+    }
+
+    size_t distance = get_distance(get_text(tree, text), get_string_len(&tree->strings, text), name, len);
+
+    if (distance > max_typos) {
+        return;
+    }
+
+    size_t i = similar->n_found;
+
+    if (i == similar->max_found) {
+        if (i == 0 || similar->distances[i - 1] <= distance) {
+            return;
+        }
+
+        --i;
+    } else {
+        ++(similar->n_found);
+    }
+
+    for (; i > 0 && similar->distances[i - 1] > distance; --i) {
+        similar->distances[i] = similar->distances[i - 1];
+        similar->found[i]     = similar->found[i - 1];
+    }
+
+    similar->distances[i] = distance;
+    similar->found[i]     = text;
+}
+
+// Returns index of the first name which is not less than given one
+
+static size_t find_position(const Name_search *search, const Tree *tree, const char *name, size_t len) {
+    assert(search != nullptr);
+    assert(tree   != nullptr);
+    assert(name   != nullptr);
+
+    size_t left  = 0;
+    size_t right = search->size;
+
+    while (left < right) {
+        size_t  middle = left + (right - left) / 2;
+        Text_id text   = search->sorted[middle];
+
+        if (compare_names(get_text(tree, text), get_string_len(&tree->strings, text), name, len) < 0) {
+            left = middle + 1;
+        } else {
+            right = middle;
+        }
+    }
+
+    return left;
+}
+
+static int compare_names(const char *first, size_t first_len, const char *second, size_t second_len) {
+    assert(first  != nullptr);
+    assert(second != nullptr);
+
+    size_t len = std::min(first_len, second_len);
+
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char first_sym  = fold_case(first[i]);
+        unsigned char second_sym = fold_case(second[i]);
+
+        if (first_sym != second_sym) {
+            return (first_sym < second_sym) ? -1 : 1;
+        }
+    }
+
+    return (first_len == second_len) ? 0 : (first_len < second_len) ? -1 : 1;
+}
+
+static int compare_texts(const Tree *tree, Text_id first, Text_id second) {
+    assert(tree != nullptr);
+
+    return compare_names(get_text(tree, first),  get_string_len(&tree->strings, first),
+                         get_text(tree, second), get_string_len(&tree->strings, second));
+}
+
+// Levenshtein distance ignoring case, cut to Max_distance. Cells of table are
+// cut too, so rows stop changing when all of them reach it.
+
+static size_t get_distance(const char *first, size_t first_len, const char *second, size_t second_len) {
+    assert(first  != nullptr);
+    assert(second != nullptr);
+
+    first_len  = std::min(first_len,  Max_compared_len);
+    second_len = std::min(second_len, Max_compared_len);
+
+    if (std::max(first_len, second_len) - std::min(first_len, second_len) >= Max_distance) {
+        return Max_distance;
+    }
+
+    size_t rows[2][Max_compared_len + 1] = {};
+
+    size_t *previous = rows[0];
+    size_t *current  = rows[1];
+
+    for (size_t j = 0; j <= second_len; ++j) {
+        previous[j] = std::min(j, Max_distance);
+    }
+
+    for (size_t i = 1; i <= first_len; ++i) {
+        current[0] = std::min(i, Max_distance);
+
+        size_t row_min = current[0];
+
+        for (size_t j = 1; j <= second_len; ++j) {
+            size_t replace = previous[j - 1] + (fold_case(first[i - 1]) != fold_case(second[j - 1]));
+
+            current[j] = std::min({replace, previous[j] + 1, current[j - 1] + 1, Max_distance});
+            row_min    = std::min(row_min, current[j]);
+        }
+
+        if (row_min == Max_distance) {
+            return Max_distance;
+        }
+
+        std::swap(previous, current);
+    }
+
+    return previous[second_len];
+}
+
+static bool append_text(Text_id **texts, size_t *size, size_t *capacity, Text_id text) {
+    assert(texts    != nullptr);
+    assert(size     != nullptr);
+    assert(capacity != nullptr);
+
+    if (*size == *capacity) {
+        size_t new_capacity = (*capacity == 0) ? Search_start_capacity : 2 * (*capacity);
+
+        Text_id *new_texts = (Text_id*) realloc(*texts, new_capacity * sizeof(Text_id));
+
+        if (new_texts == nullptr) {
+            return false;
+        }
+
+        *texts    = new_texts;
+        *capacity = new_capacity;
+    }
+
+    (*texts)[(*size)++] = text;
+
+    return true;
+}
+
+static unsigned char fold_case(char sym) {
+    return (sym >= 'A' && sym <= 'Z') ? (unsigned char) (sym - 'A' + 'a') : (unsigned char) sym;
+}
@@ -0,0 +1,49 @@
+#ifndef NAME_SEARCH_H
+#define NAME_SEARCH_H
+
+#include "tree.h"
+
+// Names of characters which can be offered instead of unknown name:
+//
+//   sorted array - names in case-insensitive order, names with given
+//                  prefix lie in it one after another;
+//   typo index   - every name is put to hash buckets of its keys: the name
+//                  itself and the name without one of its letters. Names
+//                  with one typo (or two swapped letters) share a key with
+//                  entered one, so only few buckets are checked by edit
+//                  distance instead of all names.
+//
+// Both keep handles of texts, which don't change when nodes are moved.
+// Names which differ only in case are kept once. Names added after typo
+// index is built are checked one by one.
+
+const size_t Max_typos = 2;
+
+struct Name_search {
+    Text_id*  sorted         = nullptr;
+    size_t    size           = 0;
+    size_t    capacity       = 0;
+    uint32_t* buckets        = nullptr;  // n_buckets + 1 offsets of buckets in typo_names
+    Text_id*  typo_names     = nullptr;
+    size_t    n_buckets      = 0;        // power of two
+    Text_id*  added          = nullptr;  // names which are not in typo index
+    size_t    n_added        = 0;
+    size_t    added_capacity = 0;
+};
+
+bool build_name_search(Name_search *search, const Tree *tree);
+
+bool add_searched_name(Name_search *search, const Tree *tree, Text_id name);
+
+// Functions return number of names put to found, no more than max_found.
+// Completions go in case-insensitive order, similar names go by distance.
+
+size_t complete_name(const Name_search *search, const Tree *tree, const char *prefix,
+                     Text_id *found, size_t max_found);
+
+size_t find_similar_names(const Name_search *search, const Tree *tree, const char *name,
+                          Text_id *found, size_t max_found);
+
+void name_search_dtor(Name_search *search);
+
+#endif
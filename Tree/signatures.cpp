@@ -0,0 +1,579 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+
+#include "signatures.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIGNATURES_X86
+#endif
+
+// Question node on the path from root to current node
+
+struct Path_entry {
+    uint32_t first_leaf = 0;    // leaves before subtree of the question
+    int      bit        = -1;   // -1 if question is not in signature or was asked above
+};
+
+// Every count keeps different answers in lower half and common questions in upper one
+
+typedef void (*Count_impl)(const Signature *signs, size_t n_signs, const Signature *query, uint64_t *counts);
+
+static bool choose_questions(Signatures *signs, const Tree *tree, Path_entry *path, size_t *n_leaves);
+
+static void fill_signatures(Signatures *signs, const Tree *tree, Path_entry *path);
+
+static void get_signature(const Signatures *signs, const Tree *tree, Node_id leaf, Signature *sign);
+
+static int get_bit(const Signatures *signs, Text_id question);
+
+static size_t get_question_slot(Text_id question);
+
+static bool append_signature(Signatures *signs, Node_id leaf, const Signature *sign);
+
+static bool set_leaf_sign(Signatures *signs, Node_id leaf, uint32_t sign);
+
+static void add_similar(Similar_character *found, size_t *n_found, size_t max_found,
+                        Similar_character similar);
+
+static bool is_more_similar(Similar_character first, Similar_character second);
+
+static inline void set_bit(uint64_t *words, int bit, bool value);
+
+static Count_impl get_count_impl();
+static Count_impl select_count_impl();
+
+static void count_scalar(const Signature *signs, size_t n_signs, const Signature *query, uint64_t *counts);
+
+#ifdef SIGNATURES_X86
+
+static void count_popcnt(const Signature *signs, size_t n_signs, const Signature *query, uint64_t *counts);
+static void count_avx2  (const Signature *signs, size_t n_signs, const Signature *query, uint64_t *counts);
+
+#endif
+
+
+static const size_t Signs_start_capacity = 1 << 4;
+
+static const size_t Question_slots   = 2 * Signature_bits;  // power of two
+static const size_t Count_chunk_size = 1 << 9;              // signatures counted at once
+
+static const uint32_t Slot_mixer = 0x9E3779B1u;
+
+
+// Questions are chosen by number of characters asked them, so signatures
+// of most characters have many common bits. Tree is walked twice in
+// preorder by parent ids, questions on the path are kept in path array.
+
+bool build_signatures(Signatures *signs, const Tree *tree) {
+    assert(signs != nullptr);
+    assert(tree  != nullptr);
+
+    signatures_dtor(signs);
+
+    if (tree->head == No_node) {
+        return true;
+    }
+
+    Path_entry *path = (Path_entry*) calloc(tree->n_nodes, sizeof(Path_entry));
+
+    if (path == nullptr) {
+        return false;
+    }
+
+    size_t n_leaves = 0;
+
+    if (!choose_questions(signs, tree, path, &n_leaves)) {
+        free(path);
+        return false;
+    }
+
+    signs->signs      = (Signature*) calloc(n_leaves, sizeof(Signature));
+    signs->leaves     = (Node_id*)   calloc(n_leaves, sizeof(Node_id));
+    signs->leaf_signs = (uint32_t*)  malloc(tree->n_nodes * sizeof(uint32_t));
+
+    if (signs->signs == nullptr || signs->leaves == nullptr || signs->leaf_signs == nullptr) {
+        free(path);
+        return false;
+    }
+
+    memset(signs->leaf_signs, 0xFF, tree->n_nodes * sizeof(uint32_t));
+
+    signs->capacity = n_leaves;
+    signs->n_ids    = tree->n_nodes;
+
+    fill_signatures(signs, tree, path);
+
+    free(path);
+
+    return true;
+}
+
+// Questions are not chosen again, so new question gets its bit only
+// after signatures are built next time
+
+bool split_signature(Signatures *signs, const Tree *tree, Node_id old_leaf) {
+    assert(signs    != nullptr);
+    assert(tree     != nullptr);
+    assert(old_leaf != No_node);
+
+    Signature sign = {};
+
+    uint32_t old_sign = (old_leaf < signs->n_ids) ? signs->leaf_signs[old_leaf] : No_sign;
+
+    if (old_sign != No_sign) {
+        signs->leaves[old_sign] = node_right(tree, old_leaf);
+
+        signs->leaf_signs[old_leaf] = No_sign;
+
+        if (!set_leaf_sign(signs, signs->leaves[old_sign], old_sign)) {
+            return false;
+        }
+
+        get_signature(signs, tree, signs->leaves[old_sign], &signs->signs[old_sign]);
+    }
+
+    get_signature(signs, tree, node_left(tree, old_leaf), &sign);
+
+    return append_signature(signs, node_left(tree, old_leaf), &sign);
+}
+
+size_t find_similar_characters(const Signatures *signs, const Tree *tree, Node_id leaf,
+                               Similar_character *found, size_t max_found) {
+    assert(signs != nullptr);
+    assert(tree  != nullptr);
+    assert(leaf  != No_node);
+    assert(found != nullptr);
+
+    Signature query = {};
+
+    get_signature(signs, tree, leaf, &query);
+
+    uint64_t counts[Count_chunk_size] = {};
+
+    size_t n_found = 0;
+
+    for (size_t i = 0; i < signs->size; i += Count_chunk_size) {
+        size_t n_counted = std::min(Count_chunk_size, signs->size - i);
+
+        get_count_impl()(signs->signs + i, n_counted, &query, counts);
+
+        for (size_t j = 0; j < n_counted; ++j) {
+            Similar_character similar = {signs->leaves[i + j], (uint32_t) counts[j],
+                                                               (uint32_t) (counts[j] >> 32)};
+
+            if (similar.node != leaf && similar.n_common != 0) {
+                add_similar(found, &n_found, max_found, similar);
+            }
+        }
+    }
+
+    return n_found;
+}
+
+void signatures_dtor(Signatures *signs) {
+    assert(signs != nullptr);
+
+    free(signs->questions);
+    free(signs->slots);
+    free(signs->signs);
+    free(signs->leaves);
+    free(signs->leaf_signs);
+
+    *signs = {};
+}
+
+// Characters asked a question are leaves of its subtree, they are counted
+// when the walk leaves the subtree
+
+static bool choose_questions(Signatures *signs, const Tree *tree, Path_entry *path, size_t *n_leaves) {
+    assert(signs    != nullptr);
+    assert(tree     != nullptr);
+    assert(path     != nullptr);
+    assert(n_leaves != nullptr);
+
+    size_t n_texts = tree->strings.n_entries;
+
+    uint32_t *n_asked = (uint32_t*) calloc(n_texts, sizeof(uint32_t));
+
+    if (n_asked == nullptr) {
+        return false;
+    }
+
+    Node_id node  = tree->head;
+    size_t  depth = 0;
+
+    while (true) {
+        if (!is_leaf(tree, node)) {
+            path[depth++].first_leaf = (uint32_t) *n_leaves;
+
+            node = node_left(tree, node);
+            continue;
+        }
+
+        ++(*n_leaves);
+
+        while (node != tree->head && !is_left_child(tree, node)) {
+            node = node_parent(tree, node);
+
+            n_asked[tree->nodes[node].text] += (uint32_t) *n_leaves - path[--depth].first_leaf;
+        }
+
+        if (node == tree->head) {
+            break;
+        }
+
+        node = node_right(tree, node_parent(tree, node));
+    }
+
+    // Questions asked to the same number of characters go by their handles
+
+    size_t    n_questions = 0;
+    uint64_t *keys        = (uint64_t*) calloc(n_texts, sizeof(uint64_t));
+
+    signs->questions = (Text_id*)  calloc(Signature_bits, sizeof(Text_id));
+    signs->slots     = (uint16_t*) calloc(Question_slots, sizeof(uint16_t));
+
+    if (keys == nullptr || signs->questions == nullptr || signs->slots == nullptr) {
+        free(n_asked);
+        free(keys);
+        return false;
+    }
+
+    for (size_t text = 0; text < n_texts; ++text) {
+        if (n_asked[text] != 0) {
+            keys[n_questions++] = ((uint64_t) n_asked[text] << 32) | (UINT32_MAX - (uint32_t) text);
+        }
+    }
+
+    signs->n_questions = std::min(n_questions, Signature_bits);
+
+    std::partial_sort(keys, keys + signs->n_questions, keys + n_questions, std::greater<uint64_t>());
+
+    for (size_t bit = 0; bit < signs->n_questions; ++bit) {
+        Text_id question = UINT32_MAX - (uint32_t) keys[bit];
+
+        size_t slot = get_question_slot(question);
+
+        while (signs->slots[slot] != 0) {
+            slot = (slot + 1) & (Question_slots - 1);
+        }
+
+        signs->questions[bit] = question;
+        signs->slots[slot]    = (uint16_t) (bit + 1);
+    }
+
+    free(n_asked);
+    free(keys);
+
+    return true;
+}
+
+// Signature of current node is changed on the way: bits of question are set
+// when the walk goes to its left child, answer is cleared on the way to the
+// right one and both are cleared when the walk leaves the subtree
+
+static void fill_signatures(Signatures *signs, const Tree *tree, Path_entry *path) {
+    assert(signs != nullptr);
+    assert(tree  != nullptr);
+    assert(path  != nullptr);
+
+    Signature sign  = {};
+    Node_id   node  = tree->head;
+    size_t    depth = 0;
+
+    while (true) {
+        if (!is_leaf(tree, node)) {
+            int bit = get_bit(signs, tree->nodes[node].text);
+
+            if (bit >= 0 && (sign.asked[bit / 64] >> (bit % 64)) & 1) {
+                bit = -1;
+            }
+
+            if (bit >= 0) {
+                set_bit(sign.asked,   bit, true);
+                set_bit(sign.answers, bit, true);
+            }
+
+            path[depth++].bit = bit;
+
+            node = node_left(tree, node);
+            continue;
+        }
+
+        append_signature(signs, node, &sign);
+
+        while (node != tree->head && !is_left_child(tree, node)) {
+            node = node_parent(tree, node);
+
+            int bit = path[--depth].bit;
+
+            if (bit >= 0) {
+                set_bit(sign.asked,   bit, false);
+                set_bit(sign.answers, bit, false);
+            }
+        }
+
+        if (node == tree->head) {
+            return;
+        }
+
+        if (path[depth - 1].bit >= 0) {
+            set_bit(sign.answers, path[depth - 1].bit, false);
+        }
+
+        node = node_right(tree, node_parent(tree, node));
+    }
+}
+
+// Question asked several times on the path is answered by the upper node,
+// as in walk of the whole tree
+
+static void get_signature(const Signatures *signs, const Tree *tree, Node_id leaf, Signature *sign) {
+    assert(signs != nullptr);
+    assert(tree  != nullptr);
+    assert(leaf  != No_node);
+    assert(sign  != nullptr);
+
+    *sign = {};
+
+    for (Node_id node = leaf; node != tree->head; node = node_parent(tree, node)) {
+        int bit = get_bit(signs, tree->nodes[node_parent(tree, node)].text);
+
+        if (bit >= 0) {
+            set_bit(sign->asked,   bit, true);
+            set_bit(sign->answers, bit, is_left_child(tree, node));
+        }
+    }
+}
+
+static int get_bit(const Signatures *signs, Text_id question) {
+    assert(signs != nullptr);
+
+    for (size_t slot = get_question_slot(question); signs->slots[slot] != 0;
+                slot = (slot + 1) & (Question_slots - 1)) {
+
+        if (signs->questions[signs->slots[slot] - 1] == question) {
+            return signs->slots[slot] - 1;
+        }
+    }
+
+    return -1;
+}
+
+static size_t get_question_slot(Text_id question) {
+    return (question * Slot_mixer) & (Question_slots - 1);
+}
+
+static bool append_signature(Signatures *signs, Node_id leaf, const Signature *sign) {
+    assert(signs != nullptr);
+    assert(sign  != nullptr);
+
+    if (signs->size == signs->capacity) {
+        size_t new_capacity = (signs->capacity == 0) ? Signs_start_capacity : 2 * signs->capacity;
+
+        Signature *new_signs = (Signature*) realloc(signs->signs, new_capacity * sizeof(Signature));
+
+        if (new_signs == nullptr) {
+            return false;
+        }
+
+        signs->signs = new_signs;
+
+        Node_id *new_leaves = (Node_id*) realloc(signs->leaves, new_capacity * sizeof(Node_id));
+
+        if (new_leaves == nullptr) {
+            return false;
+        }
+
+        signs->leaves   = new_leaves;
+        signs->capacity = new_capacity;
+    }
+
+    if (!set_leaf_sign(signs, leaf, (uint32_t) signs->size)) {
+        return false;
+    }
+
+    signs->signs [signs->size] = *sign;
+    signs->leaves[signs->size] = leaf;
+
+    ++(signs->size);
+
+    return true;
+}
+
+// Leaves of split nodes get ids after the last built one, so place for ids is grown
+
+static bool set_leaf_sign(Signatures *signs, Node_id leaf, uint32_t sign) {
+    assert(signs != nullptr);
+    assert(leaf  != No_node);
+
+    if (leaf >= signs->n_ids) {
+        size_t n_ids = std::max((size_t) leaf + 1, 2 * signs->n_ids);
+
+        uint32_t *leaf_signs = (uint32_t*) realloc(signs->leaf_signs, n_ids * sizeof(uint32_t));
+
+        if (leaf_signs == nullptr) {
+            return false;
+        }
+
+        memset(leaf_signs + signs->n_ids, 0xFF, (n_ids - signs->n_ids) * sizeof(uint32_t));
+
+        signs->leaf_signs = leaf_signs;
+        signs->n_ids      = n_ids;
+    }
+
+    signs->leaf_signs[leaf] = sign;
+
+    return true;
+}
+
+// Found characters are kept from the most similar one
+
+static void add_similar(Similar_character *found, size_t *n_found, size_t max_found,
+                        Similar_character similar) {
+    assert(found   != nullptr);
+    assert(n_found != nullptr);
+
+    size_t i = *n_found;
+
+    if (i == max_found) {
+        if (i == 0 || !is_more_similar(similar, found[i - 1])) {
+            return;
+        }
+
+        --i;
+    } else {
+        ++(*n_found);
+    }
+
+    for (; i > 0 && is_more_similar(similar, found[i - 1]); --i) {
+        found[i] = found[i - 1];
+    }
+
+    found[i] = similar;
+}
+
+static bool is_more_similar(Similar_character first, Similar_character second) {
+    if (first.n_differ != second.n_differ) {
+        return first.n_differ < second.n_differ;
+    }
+
+    return first.n_common > second.n_common;
+}
+
+static inline void set_bit(uint64_t *words, int bit, bool value) {
+    if (value) {
+        words[bit / 64] |=   (uint64_t) 1 << (bit % 64);
+    } else {
+        words[bit / 64] &= ~((uint64_t) 1 << (bit % 64));
+    }
+}
+
+static Count_impl get_count_impl() {
+    static const Count_impl impl = select_count_impl();
+
+    return impl;
+}
+
+static Count_impl select_count_impl() {
+    #ifdef SIGNATURES_X86
+
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return count_avx2;
+    }
+
+    if (__builtin_cpu_supports("popcnt")) {
+        return count_popcnt;
+    }
+
+    #endif
+
+    return count_scalar;
+}
+
+/*----------------------------------------- SCALAR -----------------------------------------------*/
+
+// Loop is inlined to implementations, so popcount is compiled to instruction
+// of implementation's target
+
+__attribute__((always_inline))
+static inline void count_words(const Signature *signs, size_t n_signs, const Signature *query, uint64_t *counts) {
+    for (size_t i = 0; i < n_signs; ++i) {
+        uint64_t n_differ = 0;
+        uint64_t n_common = 0;
+
+        for (size_t word = 0; word < Signature_words; ++word) {
+            uint64_t common = signs[i].asked[word] & query->asked[word];
+
+            n_differ += (uint64_t) __builtin_popcountll((signs[i].answers[word] ^ query->answers[word]) & common);
+            n_common += (uint64_t) __builtin_popcountll(common);
+        }
+
+        counts[i] = n_differ | (n_common << 32);
+    }
+}
+
+static void count_scalar(const Signature *signs, size_t n_signs, const Signature *query, uint64_t *counts) {
+    count_words(signs, n_signs, query, counts);
+}
+
+#ifdef SIGNATURES_X86
+
+/*----------------------------------------- POPCNT -----------------------------------------------*/
+
+__attribute__((target("popcnt")))
+static void count_popcnt(const Signature *signs, size_t n_signs, const Signature *query, uint64_t *counts) {
+    count_words(signs, n_signs, query, counts);
+}
+
+/*------------------------------------------ AVX2 ------------------------------------------------*/
+
+static_assert(Signature_words == 4, "AVX2 implementation reads signature by 256-bit vectors");
+
+// Bits of every byte are counted by lookup of its halves in table, then
+// bytes are summed up by sad
+
+__attribute__((target("avx2")))
+static __m256i avx2_count_bits(__m256i bits) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_half = _mm256_set1_epi8(0x0F);
+
+    __m256i low  = _mm256_and_si256(bits, low_half);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(bits, 4), low_half);
+
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(table, low), _mm256_shuffle_epi8(table, high));
+
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+static void count_avx2(const Signature *signs, size_t n_signs, const Signature *query, uint64_t *counts) {
+    __m256i query_answers = _mm256_loadu_si256((const __m256i*) (const void*) query->answers);
+    __m256i query_asked   = _mm256_loadu_si256((const __m256i*) (const void*) query->asked);
+
+    for (size_t i = 0; i < n_signs; ++i) {
+        __m256i answers = _mm256_loadu_si256((const __m256i*) (const void*) signs[i].answers);
+        __m256i asked   = _mm256_loadu_si256((const __m256i*) (const void*) signs[i].asked);
+
+        __m256i common = _mm256_and_si256(asked, query_asked);
+        __m256i differ = _mm256_and_si256(_mm256_xor_si256(answers, query_answers), common);
+
+        __m256i sums = _mm256_add_epi64(avx2_count_bits(differ),
+                                        _mm256_slli_epi64(avx2_count_bits(common), 32));
+
+        __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+
+        counts[i] = (uint64_t) _mm_cvtsi128_si64(_mm_add_epi64(half, _mm_unpackhi_epi64(half, half)));
+    }
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SIGNATURES_H
+#define SIGNATURES_H
+
+#include "tree.h"
+
+// Answer signatures of characters: every bit stands for one of questions
+// asked to most of characters. Bit of asked mask is set if character was
+// asked the question, bit of answers is set if the answer was yes.
+//
+// Characters are similar if they have few different answers on questions
+// asked to both of them (masked Hamming distance), ties go to characters
+// with more common questions. Distances to all signatures are counted at
+// once, with AVX2 if it is supported.
+//
+// Signatures keep ids of leaves, so they are built again after relayout.
+
+const size_t   Signature_words = 4;
+const size_t   Signature_bits  = 64 * Signature_words;
+
+const uint32_t No_sign         = UINT32_MAX;
+
+struct Signature {
+    uint64_t answers[Signature_words] = {};
+    uint64_t asked  [Signature_words] = {};
+};
+
+struct Similar_character {
+    Node_id  node      = No_node;
+    uint32_t n_differ  = 0;     // different answers on common questions
+    uint32_t n_common  = 0;
+};
+
+struct Signatures {
+    Text_id*   questions   = nullptr;   // question of every bit
+    size_t     n_questions = 0;
+    uint16_t*  slots       = nullptr;   // bits by hash of question, 0 for empty slot, bit + 1 otherwise
+    Signature* signs       = nullptr;
+    Node_id*   leaves      = nullptr;
+    size_t     size        = 0;
+    size_t     capacity    = 0;
+    uint32_t*  leaf_signs  = nullptr;   // signature of leaf by its id, No_sign for other nodes
+    size_t     n_ids       = 0;         // ids which have place in leaf_signs
+};
+
+bool build_signatures(Signatures *signs, const Tree *tree);
+
+// Leaf was split: it moved to the right child and new one is the left child
+
+bool split_signature(Signatures *signs, const Tree *tree, Node_id old_leaf);
+
+// Returns number of characters put to found, no more than max_found.
+// Characters without common questions are not similar at all.
+
+size_t find_similar_characters(const Signatures *signs, const Tree *tree, Node_id leaf,
+                               Similar_character *found, size_t max_found);
+
+void signatures_dtor(Signatures *signs);
+
+#endif
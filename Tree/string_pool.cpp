@@ -0,0 +1,386 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "string_pool.h"
+#include "../Libs/file_reading.hpp"
+#include "../Libs/comparing.h"
+
+static Text_id find_string(const String_pool *pool, const String_shard *shard,
+                           const char *str, size_t len, uint32_t hash);
+
+static void add_to_shard(String_shard *shard, Text_id text, uint32_t hash);
+
+static bool grow_shard(String_shard *shard, size_t size);
+
+static size_t get_slot(uint32_t hash, size_t capacity);
+
+template <typename Counter>
+static bool reserve(std::atomic<Counter> *counter, Counter amount, Counter limit, Counter *start);
+
+template <typename Item>
+static bool grow_storage(Item **storage, size_t *capacity, size_t size, size_t start_capacity, 
+                                                                        size_t max_capacity);
+
+static String_shard* get_shard(String_pool *pool, uint32_t hash);
+
+
+static const size_t   Shard_start_capacity   = 1 << 10;
+static const size_t   Entries_start_capacity = 1 << 12;
+static const size_t   Data_start_capacity    = 1 << 16;
+
+static const uint32_t Fnv_offset_basis     = 2166136261u;
+static const uint32_t Fnv_prime            = 16777619u;
+
+
+bool string_pool_ctor(String_pool *pool) {
+    assert(pool != nullptr);
+
+    return grow_storage(&pool->entries, &pool->entries_capacity, 0, Entries_start_capacity, Max_texts)
+        && grow_storage(&pool->data,    &pool->data_capacity,    0, Data_start_capacity,    Max_text_size);
+}
+
+void string_pool_dtor(String_pool *pool) {
+    assert(pool != nullptr);
+
+    unmap_file((char*) pool->entries, pool->entries_capacity * sizeof(String_entry));
+    unmap_file(pool->data, pool->data_capacity);
+
+    for (size_t i = 0; i < N_string_shards; ++i) {
+        free(pool->shards[i].slots);
+
+        pool->shards[i].slots    = nullptr;
+        pool->shards[i].capacity = 0;
+        pool->shards[i].size     = 0;
+    }
+
+    pool->text      = nullptr;
+    pool->data      = nullptr;
+    pool->data_size = 0;
+    pool->entries   = nullptr;
+    pool->n_entries = 0;
+
+    pool->data_capacity    = 0;
+    pool->entries_capacity = 0;
+}
+
+bool reserve_string_entries(String_pool *pool, size_t n_entries) {
+    assert(pool != nullptr);
+
+    return n_entries <= Max_texts - pool->n_entries 
+        && grow_storage(&pool->entries, &pool->entries_capacity, pool->n_entries + n_entries, 
+                                                                 Entries_start_capacity, Max_texts);
+}
+
+// Returns handle of equal text if there is one, otherwise text gets a new entry
+
+Text_id intern_string(String_pool *pool, const char *str, size_t len, bool is_data_base_text) {
+    assert(pool          != nullptr);
+    assert(pool->entries != nullptr);
+    assert(str           != nullptr);
+
+    if (len > Max_text_len) {
+        return No_text;
+    }
+
+    uint32_t hash = get_folded_hash(str, len);
+
+    String_shard *shard = get_shard(pool, hash);
+
+    pthread_mutex_lock(&shard->lock);
+
+    Text_id text = find_string(pool, shard, str, len, hash);
+
+    if (text != No_text) {
+        pthread_mutex_unlock(&shard->lock);
+        return text;
+    }
+
+    // Room for the new text is made before anything is reserved, so failed
+    // interning doesn't leave counted entries or pool bytes without text
+
+    if (!grow_shard(shard, shard->size + 1)) {
+        pthread_mutex_unlock(&shard->lock);
+        return No_text;
+    }
+
+    // Pool grows only if it is full, which doesn't happen while several
+    // threads intern texts into entries reserved for them
+
+    if ((!is_data_base_text && !grow_storage(&pool->data, &pool->data_capacity, pool->data_size + len + 1,
+                                             Data_start_capacity, Max_text_size)) ||
+        !grow_storage(&pool->entries, &pool->entries_capacity, (size_t) pool->n_entries + 1,
+                      Entries_start_capacity, Max_texts)) {
+        pthread_mutex_unlock(&shard->lock);
+        return No_text;
+    }
+
+    size_t data_offset = 0;
+
+    if (!is_data_base_text && !reserve(&pool->data_size, len + 1, pool->data_capacity, &data_offset)) {
+        pthread_mutex_unlock(&shard->lock);
+        return No_text;
+    }
+
+    if (!reserve(&pool->n_entries, (Text_id) 1, (Text_id) pool->entries_capacity, &text)) {
+        if (!is_data_base_text) {
+            size_t data_end = data_offset + len + 1;
+
+            pool->data_size.compare_exchange_strong(data_end, data_offset);  // if no one took more since
+        }
+
+        pthread_mutex_unlock(&shard->lock);
+        return No_text;
+    }
+
+    uint64_t offset = 0;
+
+    if (is_data_base_text) {
+
+        offset = (uint64_t) (str - pool->text);
+
+    } else {
+
+        memcpy(pool->data + data_offset, str, len);
+
+        pool->data[data_offset + len] = '\0';
+
+        offset = data_offset | Pool_text;
+    }
+
+    pool->entries[text].offset = offset;
+    pool->entries[text].len    = (uint32_t) len;
+    pool->entries[text].hash   = hash;
+
+    add_to_shard(shard, text, hash);
+
+    pthread_mutex_unlock(&shard->lock);
+
+    return text;
+}
+
+bool add_string_entries(String_pool *pool, const String_entry *entries, size_t n_entries) {
+    assert(pool          != nullptr);
+    assert(pool->entries != nullptr);
+    assert(entries       != nullptr);
+
+    if (pool->n_entries != 0 || !reserve_string_entries(pool, n_entries)) {
+        return false;
+    }
+
+    size_t shard_sizes[N_string_shards] = {};
+
+    for (size_t i = 0; i < n_entries; ++i) {
+        ++shard_sizes[get_shard(pool, entries[i].hash) - pool->shards];
+    }
+
+    // Shards are grown once to their final size before slots are filled
+
+    for (size_t i = 0; i < N_string_shards; ++i) {
+        if (!grow_shard(&pool->shards[i], shard_sizes[i])) {
+            return false;
+        }
+    }
+
+    memcpy(pool->entries, entries, n_entries * sizeof(String_entry));
+
+    for (size_t i = 0; i < n_entries; ++i) {
+        add_to_shard(get_shard(pool, entries[i].hash), (Text_id) i, entries[i].hash);
+    }
+
+    pool->n_entries = (Text_id) n_entries;
+
+    return true;
+}
+
+// FNV-1a of text in lower case, so texts which differ only in case
+// have the same hash
+
+uint32_t get_folded_hash(const char *str, size_t len) {
+    assert(str != nullptr);
+
+    uint32_t hash = Fnv_offset_basis;
+
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char sym = (unsigned char) str[i];
+
+        hash ^= (sym >= 'A' && sym <= 'Z') ? (uint32_t) (sym - 'A' + 'a') : sym;
+        hash *= Fnv_prime;
+    }
+
+    return hash;
+}
+
+bool equal_folded(const String_pool *pool, Text_id text, const char *str, size_t len, uint32_t hash) {
+    assert(pool != nullptr);
+    assert(text != No_text);
+    assert(str  != nullptr);
+
+    const String_entry *entry = &pool->entries[text];
+
+    return entry->hash == hash && entry->len == len
+                               && equal_ignoring_case(get_string(pool, text), str, len);
+}
+
+static Text_id find_string(const String_pool *pool, const String_shard *shard,
+                           const char *str, size_t len, uint32_t hash) {
+    assert(pool  != nullptr);
+    assert(shard != nullptr);
+    assert(str   != nullptr);
+
+    if (shard->capacity == 0) {
+        return No_text;
+    }
+
+    for (size_t slot = get_slot(hash, shard->capacity); shard->slots[slot].text != No_text;
+                                                        slot = (slot + 1) & (shard->capacity - 1)) {
+
+        Text_id text = shard->slots[slot].text;
+
+        if (shard->slots[slot].hash == hash && pool->entries[text].len == len
+                                            && memcmp(get_string(pool, text), str, len) == 0) {
+            return text;
+        }
+    }
+
+    return No_text;
+}
+
+// Shard should have a free slot
+
+static void add_to_shard(String_shard *shard, Text_id text, uint32_t hash) {
+    assert(shard != nullptr);
+    assert(shard->size < shard->capacity);
+
+    size_t slot = get_slot(hash, shard->capacity);
+
+    while (shard->slots[slot].text != No_text) {
+        slot = (slot + 1) & (shard->capacity - 1);
+    }
+
+    shard->slots[slot].hash = hash;
+    shard->slots[slot].text = text;
+
+    ++(shard->size);
+}
+
+// Shard gets capacity for size texts, it is doubled while it is too small
+
+static bool grow_shard(String_shard *shard, size_t size) {
+    assert(shard != nullptr);
+
+    if (4 * size <= 3 * shard->capacity) {
+        return true;
+    }
+
+    size_t capacity = (shard->capacity == 0) ? Shard_start_capacity : 2 * shard->capacity;
+
+    while (4 * size > 3 * capacity) {
+        capacity *= 2;
+    }
+
+    String_slot *slots = (String_slot*) malloc(capacity * sizeof(String_slot));
+
+    if (slots == nullptr) {
+        return false;
+    }
+
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].text = No_text;
+    }
+
+    for (size_t i = 0; i < shard->capacity; ++i) {
+        if (shard->slots[i].text == No_text) {
+            continue;
+        }
+
+        size_t slot = get_slot(shard->slots[i].hash, capacity);
+
+        while (slots[slot].text != No_text) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        slots[slot] = shard->slots[i];
+    }
+
+    free(shard->slots);
+
+    shard->slots    = slots;
+    shard->capacity = capacity;
+
+    return true;
+}
+
+// Low bits of hash choose slot, high bits choose shard
+
+static size_t get_slot(uint32_t hash, size_t capacity) {
+    return hash & (capacity - 1);
+}
+
+static String_shard* get_shard(String_pool *pool, uint32_t hash) {
+    assert(pool != nullptr);
+
+    return &pool->shards[hash >> 26];
+}
+
+// Storage is at least doubled, so texts added one by one move it O(1) times on average
+
+template <typename Item>
+static bool grow_storage(Item **storage, size_t *capacity, size_t size, size_t start_capacity, 
+                                                                        size_t max_capacity) {
+    assert(storage  != nullptr);
+    assert(capacity != nullptr);
+
+    if (*storage != nullptr && size <= *capacity) {
+        return true;
+    }
+
+    if (size > max_capacity) {
+        return false;
+    }
+
+    size_t new_capacity = (*capacity == 0) ? start_capacity : 2 * *capacity;
+
+    if (new_capacity < size) {
+        new_capacity = size;
+    }
+
+    if (new_capacity > max_capacity) {
+        new_capacity = max_capacity;
+    }
+
+    Item *grown = (Item*) (void*) grow_anonymous((char*) *storage, *capacity   * sizeof(Item), 
+                                                                   new_capacity * sizeof(Item));
+
+    if (grown == nullptr) {
+        return false;
+    }
+
+    *storage  = grown;
+    *capacity = new_capacity;
+
+    return true;
+}
+
+// Counter is shared by all shards, it is moved only if the whole amount
+// fits into limit
+
+template <typename Counter>
+static bool reserve(std::atomic<Counter> *counter, Counter amount, Counter limit, Counter *start) {
+    assert(counter != nullptr);
+    assert(start   != nullptr);
+
+    Counter old_value = counter->load(std::memory_order_relaxed);
+
+    do {
+        if (old_value > limit || limit - old_value < amount) {
+            return false;
+        }
+
+    } while (!counter->compare_exchange_weak(old_value, old_value + amount, std::memory_order_relaxed));
+
+    *start = old_value;
+
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include <atomic>
+
+// Every distinct text of the tree is kept once and nodes refer to it by
+// handle, so equal texts have equal handles. Text lives either in data
+// base text (which is parsed in place) or, with Pool_text bit set in its
+// offset, in pool's own memory. Length and case-folded hash are counted
+// once when text is interned.
+//
+// Handles are looked up in hash tables split into shards by hash, each
+// shard has its own lock, so texts can be interned by several threads.
+
+typedef uint32_t Text_id;
+
+const Text_id  No_text         = UINT32_MAX;
+
+const uint64_t Pool_text       = 1ull << 63;
+
+const size_t   Max_text_size   = Pool_text - 1;  // for data base text and for pool
+const size_t   Max_text_len    = UINT32_MAX - 1;
+const size_t   Max_texts       = 1 << 28;
+
+const size_t   N_string_shards = 64;
+
+struct String_entry {
+    uint64_t offset = 0;
+    uint32_t len    = 0;
+    uint32_t hash   = 0;                // hash of text in lower case
+};
+
+// Hash is kept in slot too, so probing doesn't touch entries of other texts
+
+struct String_slot {
+    uint32_t hash = 0;
+    Text_id  text = No_text;
+};
+
+struct alignas(64) String_shard {
+    pthread_mutex_t lock     = PTHREAD_MUTEX_INITIALIZER;
+    String_slot*    slots    = nullptr;  // open addressing, No_text for empty slot
+    size_t          capacity = 0;
+    size_t          size     = 0;
+};
+
+// Entries and pool are doubled when they are full and can be moved by that.
+// Several threads can intern texts only into entries reserved before, then
+// nothing is moved while texts are read by other threads.
+
+struct String_pool {
+    const char*          text      = nullptr;  // data base text
+    char*                data      = nullptr;  // texts added to tree
+    std::atomic<size_t>  data_size = 0;
+    size_t               data_capacity = 0;
+    String_entry*        entries   = nullptr;
+    std::atomic<Text_id> n_entries = 0;
+    size_t               entries_capacity = 0;
+    String_shard         shards[N_string_shards] = {};
+};
+
+bool string_pool_ctor(String_pool *pool);
+
+void string_pool_dtor(String_pool *pool);
+
+// Room for n_entries more entries, taken before texts are interned by several threads
+
+bool reserve_string_entries(String_pool *pool, size_t n_entries);
+
+// Text of data base text is not copied, it should be ended with '\0'
+
+Text_id intern_string(String_pool *pool, const char *str, size_t len, bool is_data_base_text);
+
+// Entries of data base text made by the same pool before, equal texts
+// should have one entry. They are added as they are, without lookups,
+// so pool should be empty. Not thread safe.
+
+bool add_string_entries(String_pool *pool, const String_entry *entries, size_t n_entries);
+
+uint32_t get_folded_hash(const char *str, size_t len);
+
+bool equal_folded(const String_pool *pool, Text_id text, const char *str, size_t len, uint32_t hash);
+
+inline const char* get_string(const String_pool *pool, Text_id text) {
+    uint64_t offset = pool->entries[text].offset;
+
+    return (offset & Pool_text) ? pool->data + (offset & ~Pool_text) : pool->text + offset;
+}
+
+inline size_t get_string_len(const String_pool *pool, Text_id text) {
+    return pool->entries[text].len;
+}
+
+#endif
@@ -2,24 +2,63 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <sys/uio.h>
 
 #include "tree.h"
 #include "../Libs/file_reading.hpp"
 
 
-static void generate_node_code(Tree_node *node, FILE *code_output);
+struct Dump_buffer {
+    int         fd       = -1;
+    Text_writer writer   = nullptr;  // used instead of fd if set
+    void*       context  = nullptr;
+    char*       data     = nullptr;
+    size_t      size     = 0;
+    size_t      capacity = 0;
+    bool        is_ok    = true;
+};
+
+static void generate_node_code(Tree *tree, Node_id node, FILE *code_output);
+
+static Colors get_colors(const Tree *tree, Node_id node);
+
+static Node_id init_node(Tree *tree, Node_id parent, bool is_left, Text_id text, Node_range *range);
+
+static Node_id alloc_node(Tree *tree, Node_range *range);
+
+static bool reserve_storage(Tree *tree, size_t n_nodes);
+
+static bool dump_text(Tree *tree, Dump_buffer *buffer);
+
+static void text_dump_nodes(Tree *tree, Dump_buffer *buffer);
+
+static void expand_deferred(Tree *tree, Node_id node);
 
-static Colors get_colors(Tree_node *node);
+static bool record_split(Tree *tree, Node_id node);
 
-static Tree_node* init_node(Tree *tree, Tree_node *parent, bool is_left, char *data);
+static Text_id find_split(const Tree_snapshot *snapshot, Node_id node);
 
-static void text_dump_node(Tree_node *node, FILE *output);
+static void lock_snapshot  (Tree_snapshot *snapshot);
+
+static void unlock_snapshot(Tree_snapshot *snapshot);
+
+static void dump_to_buffer(Dump_buffer *buffer, const char *data, size_t len);
+
+static void flush_dump_buffer(Dump_buffer *buffer, const char *extra, size_t extra_len);
 
 
 static const int max_file_with_graphviz_code_name_len = 30;
 static const int max_generation_png_command_len = 200;
 static const int max_png_file_name_len = 30;
 
+static const size_t dump_buffer_size = 1 << 20;
+
+static const size_t snapshot_batch_size = 1 << 12;
+
+static const size_t nodes_start_capacity = Node_chunk_size;
+
 
 #define memory_allocate(ptr, size, type, returning)                                           \
         ptr = (type*) calloc(size, sizeof(type));                                             \
@@ -35,89 +74,444 @@ int real_tree_init(Tree* tree, const char *file, const char *func, int line) {
 
     init_cr_logs(tree->logs, file, func, line);
 
+    if (!string_pool_ctor(&tree->strings)) {
+        dump_tree(tree, "can't allocate memory: not enought free mem\n");
+        tree_dtor(tree);
+        return NOT_ENOUGHT_MEM;
+    }
+
     return NO_TREE_ERR;
 }
 
-static Tree_node* init_node(Tree *tree, Tree_node *parent, bool is_left, char *data) {
-    assert(parent != nullptr);
+// Data base text which is parsed in place, offsets of node texts are counted from it
+
+bool set_tree_text(Tree *tree, const char *text, size_t size) {
+    assert(tree != nullptr);
+    assert(text != nullptr);
 
-    Tree_node *node = nullptr;
+    if (size > Max_text_size) {
+        printf("Error: data base is too big, maximum size is %zu bytes\n", Max_text_size);
+        return false;
+    }
 
-    memory_allocate(node, 1, Tree_node, nullptr);
+    tree->strings.text = text;
 
-    node->left  = nullptr;
-    node->right = nullptr;
- 
-    node->data  = data;
+    return true;
+}
+
+static Node_id init_node(Tree *tree, Node_id parent, bool is_left, Text_id text, Node_range *range) {
+    assert(tree   != nullptr);
+    assert(parent != No_node);
 
-    node->parent = parent;
+    Node_id node = alloc_node(tree, range);
+
+    if (node == No_node) {
+        return No_node;
+    }
+
+    tree->nodes[node].text   = text;
+    tree->nodes[node].parent = parent;
 
     if (is_left) {
 
-        parent->left  = node;
+        tree->nodes[parent].left  = node;
 
     } else {
 
-        parent->right = node;
+        tree->nodes[parent].right = node;
 
     }
 
     return node;
 }
 
-Tree_node* init_right_node(Tree *tree, Tree_node *parent, char *data) {
-    return init_node(tree, parent, false, data);
-}
-
-Tree_node* init_left_node(Tree *tree, Tree_node *parent, char *data) {
-    return init_node(tree, parent, true, data);
-}
+// Nodes and texts are freed all together, tree is not walked
 
 void tree_dtor(Tree *tree) {
     assert(tree != nullptr);
 
     free(tree->logs);
-    
-    free_node(tree->head->left);
-    free_node(tree->head->right);
 
-    free(tree->head);
+    unmap_file((char*) tree->nodes, tree->capacity * sizeof(Tree_node));
 
-    tree->head      = nullptr;
-    tree->logs      = nullptr;
+    string_pool_dtor(&tree->strings);
+
+    tree->head       = No_node;
+    tree->logs       = nullptr;
+    tree->nodes      = nullptr;
+    tree->n_nodes    = 0;
+    tree->capacity   = 0;
+    tree->free_nodes = No_node;
 }
 
-void free_node(Tree_node *node) {
-    if (node == nullptr) {
+// Subtree is detached from its parent and its nodes are returned to the
+// free list. Texts stay in tree's storage till tree_dtor().
+
+void free_node(Tree *tree, Node_id node) {
+    assert(tree != nullptr);
+
+    if (node == No_node) {
         return;
     }
 
-    if (!node->is_saved) {
-        free(node->data);
+    Node_id stop = node_parent(tree, node);
+
+    // Subtree is freed without recursion: leaves are detached from
+    // their parents and freed until subtree root is reached.
+
+    while (node != stop) {
+        if (node_left(tree, node) != No_node) {
+            node = node_left(tree, node);
+            continue;
+        }
+
+        if (node_right(tree, node) != No_node) {
+            node = node_right(tree, node);
+            continue;
+        }
+
+        Node_id parent = node_parent(tree, node);
+
+        if (parent != No_node) {
+            if (node_left(tree, parent) == node) {
+                tree->nodes[parent].left  = No_node;
+            } else {
+                tree->nodes[parent].right = No_node;
+            }
+        }
+
+        tree->nodes[node].parent = tree->free_nodes;
+        tree->free_nodes         = node;
+
+        if (tree->head == node) {
+            tree->head = No_node;
+        }
+
+        node = parent;
+    }
+}
+
+// Node is taken from free list, from thread's range or from the end of array
+
+static Node_id alloc_node(Tree *tree, Node_range *range) {
+    assert(tree != nullptr);
+
+    if (range != nullptr) {
+        if (range->next == range->end) {
+            Node_id begin = range->source->fetch_add((Node_id) Node_chunk_size);
+
+            if ((size_t) begin + Node_chunk_size > tree->capacity) {
+                return No_node;
+            }
+
+            range->next = begin;
+            range->end  = begin + (Node_id) Node_chunk_size;
+        }
+
+        return range->next++;
+    }
+
+    Node_id node = tree->free_nodes;
+
+    if (node != No_node) {
+        tree->free_nodes = node_parent(tree, node);
+
+        tree->nodes[node] = {};
+
+        return node;
+    }
+
+    return reserve_nodes(tree, 1);
+}
+
+// Ids of n_nodes new zeroed nodes going one after another, the first one is returned
+
+Node_id reserve_nodes(Tree *tree, size_t n_nodes) {
+    assert(tree != nullptr);
+
+    if (!reserve_storage(tree, n_nodes)) {
+        return No_node;
+    }
+
+    Node_id first = tree->n_nodes;
+
+    tree->n_nodes += (Node_id) n_nodes;
+
+    return first;
+}
+
+// Every new node can get a new text
+
+bool reserve_tree_capacity(Tree *tree, size_t n_nodes) {
+    assert(tree != nullptr);
+
+    return reserve_storage(tree, n_nodes) && reserve_string_entries(&tree->strings, n_nodes);
+}
+
+// Array is at least doubled, so nodes added one by one are moved O(1) times on average
+
+static bool reserve_storage(Tree *tree, size_t n_nodes) {
+    assert(tree != nullptr);
+
+    size_t n_used = (tree->n_nodes == No_node) ? 1 : tree->n_nodes;   // id 0 is never given
+
+    if (n_nodes > Max_nodes - n_used) {
+        dump_tree(tree, "can't allocate memory: too many nodes\n");
+        return false;
+    }
+
+    size_t capacity = n_used + n_nodes;
+
+    if (capacity <= tree->capacity) {
+        return true;
+    }
+
+    size_t new_capacity = (tree->capacity == 0) ? nodes_start_capacity : 2 * (size_t) tree->capacity;
+
+    if (new_capacity < capacity) {
+        new_capacity = capacity;
+    }
+
+    if (new_capacity > Max_nodes) {
+        new_capacity = Max_nodes;
+    }
+
+    Tree_node *nodes = (Tree_node*) (void*) grow_anonymous((char*) tree->nodes, 
+                                                           tree->capacity * sizeof(Tree_node),
+                                                           new_capacity   * sizeof(Tree_node));
+
+    if (nodes == nullptr) {
+        return false;
     }
 
-    free_node(node->left);
-    free_node(node->right);
+    tree->nodes    = nodes;
+    tree->capacity = (Node_id) new_capacity;
 
-    free(node);
+    if (tree->n_nodes == No_node) {
+        tree->n_nodes = 1;
+    }
+
+    return true;
 }
 
-int init_head_node(Tree *tree, char *data) {
+int init_head_node(Tree *tree, Text_id text) {
     assert(tree != nullptr);
 
-    memory_allocate(tree->head, 1, Tree_node, NOT_ENOUGHT_MEM);
+    tree->head = alloc_node(tree, nullptr);
+
+    if (tree->head == No_node) {
+        return NOT_ENOUGHT_MEM;
+    }
+
+    tree->nodes[tree->head].text = text;
 
-    tree->head->parent = nullptr;
+    return NO_TREE_ERR;
+}
 
-    tree->head->right  = nullptr;
-    tree->head->left   = nullptr;
+Node_id attach_node(Tree *tree, Node_id parent, Text_id text, Node_range *range) {
+    assert(tree != nullptr);
 
-    tree->head->data = data;
+    if (parent == No_node) {
+        if (init_head_node(tree, text) != NO_TREE_ERR) {
+            return No_node;
+        }
+
+        return tree->head;
+    }
+
+    return init_node(tree, parent, node_left(tree, parent) == No_node, text, range);
+}
+
+Node_id expand_node(Tree *tree, Node_id node) {
+    assert(tree != nullptr);
+    assert(node != No_node);
+
+    lock_snapshot(tree->snapshot);
+
+    expand_deferred(tree, node);
+
+    unlock_snapshot(tree->snapshot);
+
+    return node;
+}
+
+static void expand_deferred(Tree *tree, Node_id node) {
+    assert(tree != nullptr);
+    assert(node != No_node);
+
+    if (is_deferred(tree, node) && tree->expander != nullptr) {
+        tree->expander(tree, node, tree->expander_context);
+    }
+}
+
+// Leaf becomes a question: new leaf is its left child (answer "yes"),
+// old leaf moves to the right child
+
+int split_node(Tree *tree, Node_id node, Text_id new_leaf, Text_id question, bool are_texts_saved) {
+    assert(tree     != nullptr);
+    assert(node     != No_node);
+    assert(new_leaf != No_text);
+    assert(question != No_text);
+
+    lock_snapshot(tree->snapshot);
+
+    if (tree->snapshot != nullptr && !record_split(tree, node)) {
+        unlock_snapshot(tree->snapshot);
+        return NOT_ENOUGHT_MEM;
+    }
+
+    Text_id old_leaf = tree->nodes[node].text;
+
+    Node_id left  = init_node(tree, node, true,  new_leaf, nullptr);
+    Node_id right = init_node(tree, node, false, old_leaf, nullptr);
+
+    if (left == No_node || right == No_node) {
+        unlock_snapshot(tree->snapshot);
+        return NOT_ENOUGHT_MEM;
+    }
+
+    tree->nodes[node].text = question;
+
+    set_node_flag(tree, right, Saved_flag, is_saved(tree, node));
+    set_node_flag(tree, left,  Saved_flag, are_texts_saved);
+    set_node_flag(tree, node,  Saved_flag, are_texts_saved);
+
+    unlock_snapshot(tree->snapshot);
 
     return NO_TREE_ERR;
 }
 
-void real_dump_tree(const Tree *tree, const char *file, const char *func, int line, 
+// Texts are interned, so equal texts are stored once and have equal handles.
+// Pool can be moved by new text, so frozen tree is locked.
+
+Text_id store_text(Tree *tree, const char *text, size_t len) {
+    assert(tree != nullptr);
+    assert(text != nullptr);
+
+    lock_snapshot(tree->snapshot);
+
+    Text_id stored = intern_string(&tree->strings, text, len, false);
+
+    unlock_snapshot(tree->snapshot);
+
+    if (stored == No_text) {
+        dump_tree(tree, "can't allocate memory: text pool is full\n");
+    }
+
+    return stored;
+}
+
+// Data base text is not copied, text at offset should be already ended with '\0'
+
+Text_id intern_text(Tree *tree, size_t offset, size_t len) {
+    assert(tree               != nullptr);
+    assert(tree->strings.text != nullptr);
+
+    Text_id text = intern_string(&tree->strings, tree->strings.text + offset, len, true);
+
+    if (text == No_text) {
+        dump_tree(tree, "can't allocate memory: too many texts\n");
+    }
+
+    return text;
+}
+
+// Tree is frozen by game thread before dumping it in another thread
+// and unfrozen by the same thread after the dump is finished
+
+bool freeze_tree(Tree *tree) {
+    assert(tree != nullptr);
+    assert(tree->snapshot == nullptr);
+
+    tree->snapshot = (Tree_snapshot*) calloc(1, sizeof(Tree_snapshot));
+
+    if (tree->snapshot == nullptr) {
+        return false;
+    }
+
+    if (pthread_mutex_init(&tree->snapshot->lock, nullptr) != 0) {
+        free(tree->snapshot);
+
+        tree->snapshot = nullptr;
+
+        return false;
+    }
+
+    return true;
+}
+
+void unfreeze_tree(Tree *tree) {
+    assert(tree != nullptr);
+
+    if (tree->snapshot == nullptr) {
+        return;
+    }
+
+    pthread_mutex_destroy(&tree->snapshot->lock);
+
+    free(tree->snapshot->splits);
+    free(tree->snapshot);
+
+    tree->snapshot = nullptr;
+}
+
+static bool record_split(Tree *tree, Node_id node) {
+    assert(tree != nullptr);
+    assert(node != No_node);
+
+    Tree_snapshot *snapshot = tree->snapshot;
+
+    if (snapshot->n_splits == snapshot->capacity) {
+        size_t capacity = (snapshot->capacity == 0) ? 16 : snapshot->capacity * 2;
+
+        Split_record *splits = (Split_record*) realloc(snapshot->splits, 
+                                                       capacity * sizeof(Split_record));
+
+        if (splits == nullptr) {
+            return false;
+        }
+
+        snapshot->splits   = splits;
+        snapshot->capacity = capacity;
+    }
+
+    snapshot->splits[snapshot->n_splits].node = node;
+    snapshot->splits[snapshot->n_splits].text = tree->nodes[node].text;
+
+    ++snapshot->n_splits;
+
+    return true;
+}
+
+// Only few characters can be added by user during one dump,
+// so splits are searched linearly
+
+static Text_id find_split(const Tree_snapshot *snapshot, Node_id node) {
+    assert(snapshot != nullptr);
+    assert(node     != No_node);
+
+    for (size_t i = 0; i < snapshot->n_splits; ++i) {
+        if (snapshot->splits[i].node == node) {
+            return snapshot->splits[i].text;
+        }
+    }
+
+    return No_text;
+}
+
+static void lock_snapshot(Tree_snapshot *snapshot) {
+    if (snapshot != nullptr) {
+        pthread_mutex_lock(&snapshot->lock);
+    }
+}
+
+static void unlock_snapshot(Tree_snapshot *snapshot) {
+    if (snapshot != nullptr) {
+        pthread_mutex_unlock(&snapshot->lock);
+    }
+}
+
+void real_dump_tree(Tree *tree, const char *file, const char *func, int line, 
                                                                const char *message, ...) {
     
     FILE *output = GetLogStream();
@@ -148,7 +542,7 @@ void real_dump_tree(const Tree *tree, const char *file, const char *func, int li
 
     fflush(output);
 
-    if (tree->head == nullptr) {
+    if (tree->head == No_node) {
         fprintf(output, "\tCan't print data: tree root does not exist\n");
     } else {
         fprintf(output, "\tTree data visualisation:\n");
@@ -172,7 +566,7 @@ void real_dump_tree(const Tree *tree, const char *file, const char *func, int li
 
 }
 
-void generate_graph_picture(const Tree *tree, char *picture_name) {
+void generate_graph_picture(Tree *tree, char *picture_name) {
     assert(tree         != nullptr);
     assert(picture_name != nullptr);
 
@@ -185,7 +579,7 @@ void generate_graph_picture(const Tree *tree, char *picture_name) {
     Print_code("node [shape=record,style=\"filled\"];\n");
     Print_code("splines=ortho;\n");
 
-    generate_node_code(tree->head, code_output);
+    generate_node_code(tree, tree->head, code_output);
 
     Print_code("}");
 
@@ -198,50 +592,227 @@ void generate_graph_picture(const Tree *tree, char *picture_name) {
     system(command);
 }
 
-void text_database_dump(Tree *tree, FILE *output) {
+// Text dump is collected in a big buffer which is written to the file
+// descriptor when it is full. Long texts are written together with
+// the buffer by one writev() call without copying. Frozen tree is
+// dumped as it was at the moment of freezing.
+
+bool text_database_dump(Tree *tree, FILE *output) {
     assert(tree   != nullptr);
     assert(output != nullptr);
 
-    text_dump_node(tree->head, output);
+    if (fflush(output) != 0) {
+        return false;
+    }
+
+    Dump_buffer buffer = {};
+
+    buffer.fd = fileno(output);
+
+    return dump_text(tree, &buffer);
 }
 
-static void text_dump_node(Tree_node *node, FILE *output) {
-    assert(node   != nullptr);
-    assert(output != nullptr);
+// Same dump passed to writer by big parts
+
+bool text_database_write(Tree *tree, Text_writer writer, void *context) {
+    assert(tree   != nullptr);
+    assert(writer != nullptr);
+
+    Dump_buffer buffer = {};
 
-    fprintf(output, "{ \"%s\"", node->data);
+    buffer.writer  = writer;
+    buffer.context = context;
 
-    if (node->left != nullptr && node->right != nullptr) {
-        fprintf(output, "\n");
-        text_dump_node(node->left,  output);
-        text_dump_node(node->right, output);
+    return dump_text(tree, &buffer);
+}
+
+static bool dump_text(Tree *tree, Dump_buffer *buffer) {
+    assert(tree   != nullptr);
+    assert(buffer != nullptr);
+
+    buffer->capacity = dump_buffer_size;
+    buffer->data     = (char*) calloc(buffer->capacity, sizeof(char));
+
+    if (buffer->data == nullptr) {
+        return false;
     }
 
-    fprintf(output, " }\n");
+    text_dump_nodes(tree, buffer);
+
+    flush_dump_buffer(buffer, nullptr, 0);
+
+    free(buffer->data);
+
+    buffer->data = nullptr;
+
+    return buffer->is_ok;
+}
+
+#define Dump_str(str)                                     \
+        dump_to_buffer(buffer, str, sizeof(str) - 1);
+
+// Tree is walked without recursion using parent links. Frozen tree
+// is locked by batches of nodes, so game thread is never blocked for long.
+
+static void text_dump_nodes(Tree *tree, Dump_buffer *buffer) {
+    assert(tree   != nullptr);
+    assert(buffer != nullptr);
+
+    Tree_snapshot *snapshot = tree->snapshot;
+
+    lock_snapshot(snapshot);
+
+    Node_id node = tree->head;
+
+    size_t n_dumped = 0;
+
+    while (node != No_node) {
+        if (snapshot != nullptr && ++n_dumped % snapshot_batch_size == 0) {
+            unlock_snapshot(snapshot);
+            lock_snapshot  (snapshot);
+        }
+
+        expand_deferred(tree, node);
+
+        const char *text = node_text(tree, node);
+
+        bool as_leaf = is_leaf(tree, node);
+
+        if (snapshot != nullptr && snapshot->n_splits != 0) {
+            Text_id old_leaf = find_split(snapshot, node);
+
+            if (old_leaf != No_text) {
+                text    = get_text(tree, old_leaf);
+                as_leaf = true;
+            }
+        }
+
+        Dump_str("{ \"");
+
+        dump_to_buffer(buffer, text, strlen(text));
+
+        Dump_str("\"");
+
+        if (!as_leaf) {
+            Dump_str("\n");
+
+            node = node_left(tree, node);
+
+            continue;
+        }
+
+        Dump_str(" }\n");
+
+        Node_id parent = node_parent(tree, node);
+
+        while (parent != No_node && node == node_right(tree, parent)) {
+            Dump_str(" }\n");
+
+            node   = parent;
+            parent = node_parent(tree, node);
+        }
+
+        node = (parent != No_node) ? node_right(tree, parent) : No_node;
+    }
+
+    unlock_snapshot(snapshot);
+}
+
+#undef Dump_str
+
+static void dump_to_buffer(Dump_buffer *buffer, const char *data, size_t len) {
+    assert(buffer != nullptr);
+    assert(data   != nullptr);
+
+    if (buffer->capacity - buffer->size >= len) {
+        memcpy(buffer->data + buffer->size, data, len);
+
+        buffer->size += len;
+
+        return;
+    }
+
+    if (len >= buffer->capacity / 2) {
+        flush_dump_buffer(buffer, data, len);
+
+        return;
+    }
+
+    flush_dump_buffer(buffer, nullptr, 0);
+
+    memcpy(buffer->data, data, len);
+
+    buffer->size = len;
 }
 
-static void generate_node_code(Tree_node *node, FILE *code_output) {
-    Colors node_colors = get_colors(node);
+static void flush_dump_buffer(Dump_buffer *buffer, const char *extra, size_t extra_len) {
+    assert(buffer != nullptr);
+
+    if (buffer->writer != nullptr) {
+        buffer->is_ok = buffer->is_ok && buffer->writer(buffer->context, buffer->data, buffer->size)
+                     && (extra == nullptr || buffer->writer(buffer->context, extra, extra_len));
+
+        buffer->size = 0;
+
+        return;
+    }
+
+    struct iovec parts[2] = {{buffer->data, buffer->size}, {const_cast<char*>(extra), extra_len}};
+
+    int n_parts = (extra != nullptr) ? 2 : 1;
+
+    struct iovec *part = parts;
+
+    while (buffer->is_ok && n_parts > 0) {
+        ssize_t written = writev(buffer->fd, part, n_parts);
+
+        if (written < 0) {
+            buffer->is_ok = false;
+            break;
+        }
+
+        size_t left = (size_t) written;
+
+        while (n_parts > 0 && left >= part->iov_len) {
+            left -= part->iov_len;
+
+            ++part;
+            --n_parts;
+        }
+
+        if (n_parts > 0) {
+            part->iov_base = (char*) part->iov_base + left;
+            part->iov_len -= left;
+        }
+    }
+
+    buffer->size = 0;
+}
+
+static void generate_node_code(Tree *tree, Node_id node, FILE *code_output) {
+    expand_node(tree, node);
+
+    Colors node_colors = get_colors(tree, node);
 
-    Print_node(node, node_colors);
+    Print_node(tree, node, node_colors);
     
-    if (node->parent) {
-        Print_arrow(node, node_colors);
+    if (node_parent(tree, node) != No_node) {
+        Print_arrow(tree, node, node_colors);
     }
 
-    if (node->left) {
-        generate_node_code(node->left, code_output);
+    if (node_left(tree, node) != No_node) {
+        generate_node_code(tree, node_left(tree, node), code_output);
     }
 
-    if (node->right) {
-        generate_node_code(node->right, code_output);
+    if (node_right(tree, node) != No_node) {
+        generate_node_code(tree, node_right(tree, node), code_output);
     }
 }
 
-static Colors get_colors(Tree_node *node) {
+static Colors get_colors(const Tree *tree, Node_id node) {
     Colors colors = {};
 
-    if (node->is_saved) {
+    if (is_saved(tree, node)) {
         colors.fill  = SAVED_FILL__COLOR;
         colors.frame = SAVED_FRAME_COLOR;
     } else {
@@ -1,6 +1,12 @@
 #ifndef TREE_H
 #define TREE_H
 
+#include <stdint.h>
+#include <pthread.h>
+
+#include <atomic>
+
+#include "string_pool.h"
 #include "../Libs/logging.h"
 
 
@@ -14,19 +20,119 @@ static const char   *SAVED_ARROW_COLOR = "#54303c";
 static const char *UNSAVED_ARROW_COLOR = "#303C54";
 
 
+// Nodes are kept in one array and refer to each other by ids, id of node
+// is its index in the array and 0 means no node. Node's text is a handle
+// in tree's string pool. Flags are stored in high bits of parent field.
+
+typedef uint32_t Node_id;
+
+const Node_id  No_node       = 0;
+
+const uint32_t Saved_flag    = 1u << 31;         // node is written to data base
+const uint32_t Deferred_flag = 1u << 30;         // children are not read from data base yet
+const uint32_t Node_id_mask  = Deferred_flag - 1;
+
+const size_t   Max_nodes       = 1 << 28;
+const size_t   Node_chunk_size = 1 << 12;
+
 struct Tree_node {
-    bool       is_saved = false;
-    char*      data     = nullptr;
-    Tree_node* right    = nullptr;
-    Tree_node* left     = nullptr;
-    Tree_node* parent   = nullptr;
+    Node_id  left   = No_node;
+    Node_id  right  = No_node;
+    uint32_t parent = No_node;
+    Text_id  text   = 0;
 };
 
+struct Tree;
+
+typedef bool (*Node_expander)(Tree *tree, Node_id node, void *context);
+
+typedef bool (*Text_writer)(void *context, const char *data, size_t len);
+
+// Ids for nodes built by several threads at once: every thread takes
+// chunks of ids from shared counter and fills them itself
+
+struct Node_range {
+    Node_id               next   = No_node;
+    Node_id               end    = No_node;
+    std::atomic<Node_id>* source = nullptr;
+};
+
+struct Split_record {
+    Node_id          node      = No_node;
+    Text_id          text      = 0;        // text of the leaf before split
+};
+
+// Frozen tree can be dumped by another thread while game goes on. Splits
+// made after freezing are recorded, so dump sees tree as it was frozen.
+
+struct Tree_snapshot {
+    pthread_mutex_t  lock      = {};
+    Split_record*    splits    = nullptr;
+    size_t           n_splits  = 0;
+    size_t           capacity  = 0;
+};
+
+// Node array is doubled when it is full and can be moved by that, so
+// nodes are referred by ids. Array grows under the lock of frozen tree,
+// dumping thread doesn't keep pointers to nodes while it is unlocked.
+
 struct Tree {
-    Tree_node*       head      = nullptr;
-    Creation_logs*   logs      = nullptr;
+    Node_id          head       = No_node;
+    Creation_logs*   logs       = nullptr;
+    Tree_node*       nodes      = nullptr;
+    Node_id          n_nodes    = 0;        // ids from n_nodes are not given yet
+    Node_id          capacity   = 0;        // nodes mapped
+    Node_id          free_nodes = No_node;  // freed nodes linked by parent ids
+    String_pool      strings    = {};
+    Node_expander    expander   = nullptr;  // reads children of deferred nodes
+    void*            expander_context = nullptr;
+    Tree_snapshot*   snapshot   = nullptr;  // set while tree is frozen
 };
 
+inline Node_id node_left(const Tree *tree, Node_id node) {
+    return tree->nodes[node].left;
+}
+
+inline Node_id node_right(const Tree *tree, Node_id node) {
+    return tree->nodes[node].right;
+}
+
+inline Node_id node_parent(const Tree *tree, Node_id node) {
+    return tree->nodes[node].parent & Node_id_mask;
+}
+
+inline bool is_leaf(const Tree *tree, Node_id node) {
+    return tree->nodes[node].left == No_node || tree->nodes[node].right == No_node;
+}
+
+inline bool is_left_child(const Tree *tree, Node_id node) {
+    return node_left(tree, node_parent(tree, node)) == node;
+}
+
+inline bool is_saved(const Tree *tree, Node_id node) {
+    return (tree->nodes[node].parent & Saved_flag) != 0;
+}
+
+inline bool is_deferred(const Tree *tree, Node_id node) {
+    return (tree->nodes[node].parent & Deferred_flag) != 0;
+}
+
+inline const char* get_text(const Tree *tree, Text_id text) {
+    return get_string(&tree->strings, text);
+}
+
+inline const char* node_text(const Tree *tree, Node_id node) {
+    return get_text(tree, tree->nodes[node].text);
+}
+
+inline void set_node_flag(Tree *tree, Node_id node, uint32_t flag, bool value) {
+    if (value) {
+        tree->nodes[node].parent |=  flag;
+    } else {
+        tree->nodes[node].parent &= ~flag;
+    }
+}
+
 struct Colors {
     const char* frame = SAVED_FRAME_COLOR;
     const char* fill  = SAVED_FILL__COLOR;
@@ -50,32 +156,55 @@ enum Tree_err {
         fprintf(code_output, format, ##__VA_ARGS__);
 
 
-#define Print_node(node, node_colors)                                                      \
-        Print_code("node%p [label=\"{%s}\",fillcolor=\"%s\",color=\"%s\"];\n",             \
-                                     node, node->data, node_colors.fill, node_colors.frame);
+#define Print_node(tree, node, node_colors)                                                \
+        Print_code("node%u [label=\"{%s}\",fillcolor=\"%s\",color=\"%s\"];\n",             \
+                         node, node_text(tree, node), node_colors.fill, node_colors.frame);
 
-#define Print_arrow(node, node_colors)                                                       \
-        Print_code("node%p->node%p [color=\"%s\"];\n", node->parent, node, node_colors.arrow);
+#define Print_arrow(tree, node, node_colors)                                                 \
+        Print_code("node%u->node%u [color=\"%s\"];\n", node_parent(tree, node), node,         \
+                                                                         node_colors.arrow);
 
 
 int real_tree_init(Tree* tree, const char *file, const char *func, int line);
 
-Tree_node* init_right_node(Tree *tree, Tree_node *parent, char *data);
-Tree_node* init_left_node (Tree *tree, Tree_node *parent, char *data);
- 
-int init_head_node(Tree *tree, char *data);
+bool set_tree_text(Tree *tree, const char *text, size_t size);
+
+int init_head_node(Tree *tree, Text_id text);
+
+Node_id attach_node(Tree *tree, Node_id parent, Text_id text, Node_range *range = nullptr);
 
-void free_node(Tree_node *node);
+Node_id reserve_nodes(Tree *tree, size_t n_nodes);
+
+// Room for n_nodes more nodes and their texts is mapped at once. Threads which
+// build nodes by ranges take them only from this room, nothing grows under them.
+
+bool reserve_tree_capacity(Tree *tree, size_t n_nodes);
+
+Node_id expand_node(Tree *tree, Node_id node);
+
+int split_node(Tree *tree, Node_id node, Text_id new_leaf, Text_id question, bool are_texts_saved);
+
+Text_id store_text(Tree *tree, const char *text, size_t len);
+
+Text_id intern_text(Tree *tree, size_t offset, size_t len);
+
+void free_node(Tree *tree, Node_id node);
+
+bool freeze_tree(Tree *tree);
+
+void unfreeze_tree(Tree *tree);
 
 
 void tree_dtor(Tree *tree);
 
-void real_dump_tree(const Tree *tree, const char *file, const char *func, int line, 
+void real_dump_tree(Tree *tree, const char *file, const char *func, int line, 
                                                                const char *message, ...);
 
-void generate_graph_picture(const Tree *tree, char *picture_name);
+void generate_graph_picture(Tree *tree, char *picture_name);
+
+bool text_database_dump(Tree *tree, FILE *output);
 
-void text_database_dump(Tree *tree, FILE *output);
+bool text_database_write(Tree *tree, Text_writer writer, void *context);
 
 void generate_file_name(char *filename, const char *extension);
 
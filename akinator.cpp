@@ -3,26 +3,35 @@
 #include <assert.h>
 #include <string.h>
 #include <stdarg.h>
+#include <unistd.h>
 
 #include "akinator.h"
 #include "Libs/file_reading.hpp"
+#include "Libs/comparing.h"
+#include "Libs/text_buffer.h"
+#include "Database/text_reading.h"
+#include "Database/stream_reading.h"
+#include "Database/binary_database.h"
+#include "Database/compression.h"
+#include "Database/journal.h"
+#include "Queries/batch_queries.h"
+#include "Tree/definitions.h"
 
 const int Max_input_len    = 50;
 const int Picture_name_len = 30;
 const int Message_len      = 150;
 
-/*--------------------------- INTERNAL FUNCTIONS DECLARATION -------------------------------------*/
-
-//------------ PARSING INPUT ----------------//
+const char Temp_extension[] = ".tmp";
 
-static bool get_tree(Akinator *akinator);
+const size_t Relayout_growth = 8;   // tree is laid out again after growing by 1/8
+const size_t Max_suggestions = 5;
+const size_t Max_similar     = 5;
 
-static bool get_head(Akinator *akinator);
+/*--------------------------- INTERNAL FUNCTIONS DECLARATION -------------------------------------*/
 
-static bool get_left(Akinator *akinator, Tree_node *parent, size_t *ip);
-static bool get_right(Akinator *akinator, Tree_node *parent, size_t *ip);
+//------------ PARSING INPUT ----------------//
 
-static bool get_node(Akinator *akinator, Tree_node *parent, size_t *ip, bool is_left);
+static bool get_tree(Akinator *akinator, const CLArgs *args);
 
 //--------------- MODES ---------------------//
 
@@ -32,25 +41,53 @@ static void get_user_input(char *input);
 
 static Answers get_answer();
 
-static Tree_node* find_node(Tree_node *node, char *data);
+static Node_id find_node(Tree *tree, Node_id node, char *data);
+
+static Node_id find_character(Akinator *akinator, char *name);
+
+static void index_tree(Akinator *akinator);
+
+static void suggest_names(Akinator *akinator, const char *name);
+
+static Node_id search_subtree(Tree *tree, Node_id node, const char *data, size_t len, uint32_t hash);
 
 static void print_and_read(const char *message, ...);
 
 //---------------- EXIT ---------------------//
 
-static void save_new_tree(Tree *tree);
+static void save_new_tree(Akinator *akinator);
+
+//---------------- SAVING -------------------//
+
+static void run_save_mode(Akinator *akinator);
+
+static void autosave_data_base(Akinator *akinator);
+
+//---------------- LAYOUT -------------------//
+
+static Tree_layout get_layout(const CLArgs *args);
+
+static bool relayout_akinator_tree(Akinator *akinator, bool is_forced);
+
+static bool start_background_save(Akinator *akinator, const char *file_name);
+
+static void* save_in_background(void *context);
+
+static void finish_background_save(Akinator *akinator, bool wait);
 
 //------------- GUESS MODE ------------------//
 
 static void run_quess_mode(Akinator *akinator);
 
-static Answers    ask_questions(Akinator *akinator, Tree_node **node);
+static Answers ask_questions(Akinator *akinator, Node_id *node);
 
-static Tree_node* ask_question (Akinator *akinator, Tree_node *node);
+static Node_id ask_question (Akinator *akinator, Node_id node);
 
 static void celebrate_win(Answers ans);
 
-static void add_character(Akinator *akinator, Tree_node *node);
+static void add_character(Akinator *akinator, Node_id node);
+
+static void get_text_input(char *input);
 
 //------------- GRAPHIC DUMP ----------------//
 
@@ -58,258 +95,310 @@ static void run_graph_dump(Tree *tree);
 
 //------------ DEFINITION MODE --------------//
 
-static void run_definition_mode(Tree *tree);
+static void run_definition_mode(Akinator *akinator);
 
 //------------ DIFFERENCE MODE --------------//
 
-static void run_diff_mode(Tree *tree);
+static void run_diff_mode(Akinator *akinator);
 
-static void get_path(Tree_node *node, Stack *stk);
+static bool charact_corr_checkup(Akinator *akinator, const char *name, Node_id node);
 
-static bool print_commons    (const char *name1, const char *name2, Stack *stk1, Stack *stk2);
+//------------ SIMILARITY MODE --------------//
 
-static void print_difference (const char *name1, const char *name2, Stack *stk1, Stack *stk2);
+static void run_similarity_mode(Akinator *akinator);
 
-static bool print_common_prop (Stack *stk1, Stack *stk2, Tree_node **node1, Tree_node **node2);
+//------------- OTHER STATICS ---------------//
 
-static void print_properties  (Stack *stk, const char *name);
+static bool get_data_base(Akinator *akinator, const char *input);
 
-static bool charact_corr_checkup(const char *name, const Tree_node *node);
+static bool stream_data_base(Akinator *akinator, const char *input);
 
-//------------- OTHER STATICS ---------------//
+static bool write_data_base(Tree *tree, const char *output, Data_base_formats format);
 
-static bool get_data_base(Akinator *akinator, const char *input);
+static bool replace_data_base(Tree *tree, const char *file_name, Data_base_formats format);
+
+static bool is_data_base_file(const Akinator *akinator, const char *file_name);
+
+static Data_base_formats get_data_base_format(const char *file_name);
+
+static bool has_extension(const char *file_name, const char *extension);
+
+static bool open_data_base_journal(Akinator *akinator, const char *input);
 
 
 
 /*-------------------------------- EXTERNAL FUNCTIONS --------------------------------------------*/
 
-const char* get_input_name(int argc, const char **argv) {
+CLArgs get_akinator_args(int argc, const char **argv) {
     CLArgs args = parse_cmd_line(argc, argv);
 
-    if (args.output != nullptr) {
+    if (args.queries != nullptr && args.convert) {
+
+        printf("Warning: flags -c and -q can't be given together, queries are not answered\n");
+
+        args.queries = nullptr;
+    }
+
+    if (args.queries != nullptr && args.output == nullptr) {
+
+        printf("Warning: flag -q requires output file name given by -o\n");
+
+        args.queries = nullptr;
+    }
+
+    // Lazy tree would be read by several threads at once
+
+    if (args.queries != nullptr && args.lazy) {
+
+        printf("Warning: flag -l is ignored, data base is read fully to answer queries\n");
+
+        args.lazy = false;
+    }
+
+    if (args.output != nullptr && !args.convert && args.queries == nullptr) {
 
         printf("Warning: unexpected flag -o given\n");
     }
 
-    return args.input;
+    if (args.output == nullptr && args.convert) {
+
+        printf("Warning: flag -c requires output file name given by -o\n");
+
+        args.convert = false;
+    }
+
+    return args;
 }
 
-bool init_akinator(Akinator *akinator, const char *input_filename) {
+bool init_akinator(Akinator *akinator, const CLArgs *args) {
 
     assert(akinator != nullptr);
+    assert(args     != nullptr);
 
     init_tree(&akinator->tree);
 
     StackCtr(&akinator->dontknow_nodes, 0);
 
+    akinator->data_base = nullptr;
 
-    if (input_filename != nullptr) {
+    if (!get_tree(akinator, args)) {
 
-        if (!get_data_base(akinator, input_filename)) {
+        return false;
+    }
+
+    if (args->input != nullptr && strcmp(args->input, "-") != 0 && is_regular_file(args->input)) {
+
+        akinator->data_base_name = args->input;
+        akinator->autosave       = args->autosave;
+
+        if (!open_data_base_journal(akinator, args->input)) {
 
             return false;
         }
 
-    } else {
+    } else if (args->autosave != 0) {
 
-        akinator->data_base = nullptr;
+        printf("Warning: flag -a requires data base file given by -i\n");
     }
 
-    if (!get_tree(akinator)) {
+    akinator->layout = get_layout(args);
 
-        return false;
+    relayout_akinator_tree(akinator, true);
+
+    akinator->has_names    = !args->lazy && !args->convert && !args->compact;
+    akinator->has_ancestry = akinator->has_names;
+
+    index_tree(akinator);
+
+    if (akinator->names.n_duplicates != 0) {
+
+        printf("Warning: %zu characters have names of other characters, for example %s\n",
+                akinator->names.n_duplicates, node_text(&akinator->tree, akinator->names.duplicate));
     }
 
     return true;
 }
 
-void run_akinator(Akinator *akinator) {
-    int mode = 1;
+// Journal is removed only when data base file is really replaced
 
-    while (mode != 0) {
-        mode = get_mode();
-
-        switch (mode) {
-            case Exit:
-                save_new_tree(&akinator->tree);
-                return;
+bool compact_data_base(Akinator *akinator) {
 
-            case Guess:
-                run_quess_mode(akinator);
-                break;
+    assert(akinator != nullptr);
 
-            case Graph_dump:
-                run_graph_dump(&akinator->tree);
-                break;
+    if (akinator->data_base_name == nullptr) {
 
-            case Definition:
-                run_definition_mode(&akinator->tree);
-                break;
+        printf("Error: there is no data base file to merge journal into\n");
 
-            case Difference:
-                run_diff_mode(&akinator->tree);
-                break;
-
-            default:
-                printf("You entered non-existing mode number. Please, try again\n");
-                continue;
-        }
+        return false;
     }
-}
 
-void akinator_dtor(Akinator *akinator) {
+    if (!replace_data_base(&akinator->tree, akinator->data_base_name, 
+                                            get_data_base_format(akinator->data_base_name))) {
 
-    tree_dtor(&akinator->tree);
+        printf("Error: can't write data base to file %s\n", akinator->data_base_name);
 
-    StackDestr(&akinator->dontknow_nodes);
+        return false;
+    }
 
-    free(akinator->data_base);
+    clear_journal(&akinator->journal);
 
-    akinator->data_base = nullptr;
+    return true;
 }
 
-/*---------------------------------- PARSING INPUT FILE ------------------------------------------*/
+bool convert_data_base(Akinator *akinator, const char *output) {
 
-static bool get_tree(Akinator *akinator) {
     assert(akinator != nullptr);
+    assert(output   != nullptr);
 
-    if (akinator->data_base == nullptr) {
-
-        init_head_node(&akinator->tree, "Someone");
+    if (!write_data_base(&akinator->tree, output, get_data_base_format(output))) {
 
-        akinator->tree.head->is_saved = false;
+        printf("Error: can't write data base to file %s\n", output);
 
-        return true;
+        return false;
     }
 
-    return get_head(akinator);
+    return true;
 }
 
-#define SKIP_SPACES(ip)                                 \
-        for (; isspace(akinator->data_base[ip]); ++(ip));
+bool run_batch_queries(Akinator *akinator, const char *queries, const char *output, size_t n_threads) {
 
-#define SKIP_STRING(ip)                                \
-        for (; akinator->data_base[ip] != '"'; ++ip);  \
-        ++ip;
+    assert(akinator != nullptr);
+    assert(queries  != nullptr);
+    assert(output   != nullptr);
 
-#define SET_STRING_ENDING(ip)                 \
-        akinator->data_base[ip - 1] = '\0';   \
-        ++ip;
+    if (!akinator->has_names || !akinator->has_ancestry) {
 
-#define CHECK_SYM(sym, ip)                                                          \
-    if (akinator->data_base[ip] != sym) {                                           \
-        printf("Error: incorrect input file format.\nExpected: <%c>, got: <%c>\n",  \
-               sym, akinator->data_base[ip]);                                       \
-        return false;                                                               \
-    }                                                                               \
-    ++ip;
+        printf("Error: can't answer queries - characters are not indexed\n");
 
-#define CHECK_FOR_ENDING(ip)               \
-    if (akinator->data_base[ip] == '}') {  \
-        (ip)++;                            \
-        return true;                       \
+        return false;
     }
 
-static bool get_head(Akinator *akinator) {
+    Query_sources sources = {};
 
-    assert(akinator != nullptr);
+    sources.tree     = &akinator->tree;
+    sources.names    = &akinator->names;
+    sources.ancestry = &akinator->ancestry;
 
-    size_t ip = 0;
+    return answer_queries(&sources, queries, output, n_threads);
+}
 
-    CHECK_SYM('{', ip);
+void run_akinator(Akinator *akinator) {
+    int mode = 1;
 
-    SKIP_SPACES(ip);
+    while (mode != 0) {
+        finish_background_save(akinator, false);
 
-    CHECK_SYM('"', ip);
+        // Indexes keep ids of nodes, which were changed
 
-    init_head_node(&akinator->tree, &(akinator->data_base[ip]));
+        if (relayout_akinator_tree(akinator, false)) {
 
-    akinator->tree.head->is_saved = true;
+            index_tree(akinator);
+        }
 
-    SKIP_STRING(ip);
+        mode = get_mode();
 
-    SET_STRING_ENDING(ip);
+        switch (mode) {
+            case Exit:
+                save_new_tree(akinator);
+                return;
 
-    SKIP_SPACES(ip);
+            case Guess:
+                run_quess_mode(akinator);
+                break;
 
-    CHECK_FOR_ENDING(ip);
+            case Graph_dump:
+                run_graph_dump(&akinator->tree);
+                break;
 
-    if (!get_left(akinator,  akinator->tree.head, &ip)) {
-        return false;
-    }
+            case Definition:
+                run_definition_mode(akinator);
+                break;
 
-    if (!get_right(akinator, akinator->tree.head, &ip)) {
-        return false;
-    }
+            case Difference:
+                run_diff_mode(akinator);
+                break;
 
-    SKIP_SPACES(ip);
+            case Save:
+                run_save_mode(akinator);
+                break;
 
-    CHECK_FOR_ENDING(ip);
+            case Similarity:
+                run_similarity_mode(akinator);
+                break;
 
-    return false;
+            default:
+                printf("You entered non-existing mode number. Please, try again\n");
+                continue;
+        }
+    }
 }
 
-static bool get_left (Akinator *akinator, Tree_node *parent, size_t *ip) {
+void akinator_dtor(Akinator *akinator) {
 
-    return get_node(akinator, parent, ip, true);
-}
+    finish_background_save(akinator, true);
 
-static bool get_right(Akinator *akinator, Tree_node *parent, size_t *ip) {
+    tree_dtor(&akinator->tree);
 
-    return get_node(akinator, parent, ip, false);
-}
+    StackDestr(&akinator->dontknow_nodes);
 
-static bool get_node(Akinator *akinator, Tree_node *parent, size_t *ip, bool is_left) {
+    name_index_dtor(&akinator->names);
+    name_search_dtor(&akinator->search);
+    ancestry_dtor(&akinator->ancestry);
+    signatures_dtor(&akinator->signatures);
 
-    assert(akinator != nullptr);
-    assert(ip       != nullptr);
-    assert(parent   != nullptr);
+    lazy_text_dtor(&akinator->lazy);
 
-    SKIP_SPACES(*ip);
+    journal_dtor(&akinator->journal);
 
-    CHECK_SYM('{', *ip);
+    unmap_file(akinator->data_base, akinator->data_base_size);
 
-    SKIP_SPACES(*ip);
+    akinator->data_base      = nullptr;
+    akinator->data_base_size = 0;
+}
 
-    CHECK_SYM('"', *ip);
+/*---------------------------------- PARSING INPUT FILE ------------------------------------------*/
 
-    Tree_node *node = nullptr;
+static bool get_tree(Akinator *akinator, const CLArgs *args) {
+    assert(akinator != nullptr);
+    assert(args     != nullptr);
 
-    if (is_left) {
+    if (args->input == nullptr) {
 
-        node = init_left_node(&akinator->tree, parent, &(akinator->data_base[*ip]));
+        const char someone[] = "Someone";
 
-    } else {
+        Text_id text = store_text(&akinator->tree, someone, sizeof(someone) - 1);
 
-        node = init_right_node(&akinator->tree, parent, &(akinator->data_base[*ip]));
+        return text != No_text && init_head_node(&akinator->tree, text) == NO_TREE_ERR;
     }
 
-    node->is_saved = true;
+    // Pipes and other non-mappable inputs are read by chunks
 
-    SKIP_STRING(*ip);
+    if (args->stream || strcmp(args->input, "-") == 0 || !is_regular_file(args->input)) {
 
-    SET_STRING_ENDING(*ip);
+        return stream_data_base(akinator, args->input);
+    }
 
-    SKIP_SPACES(*ip);
+    if (!get_data_base(akinator, args->input)) {
 
-    CHECK_FOR_ENDING(*ip);
+        return false;
+    }
 
-    if (!get_left (akinator, node, ip)) {
+    if (is_binary_data_base(akinator->data_base, akinator->data_base_size)) {
 
-        return false;
+        return open_binary_tree(&akinator->tree, akinator->data_base, akinator->data_base_size);
     }
 
-    if (!get_right(akinator, node, ip)) {
+    if (!set_tree_text(&akinator->tree, akinator->data_base, akinator->data_base_size)) {
 
         return false;
     }
 
-    SKIP_SPACES(*ip);
+    if (args->lazy) {
 
-    CHECK_FOR_ENDING(*ip);
+        return read_text_tree_lazy(&akinator->tree, &akinator->lazy, akinator->data_base, args->input);
+    }
 
-    return false;
+    return read_text_tree_parallel(&akinator->tree, akinator->data_base, args->threads);
 }
 
 /*------------------------------------ AKINATOR MODES --------------------------------------------*/
@@ -323,6 +412,8 @@ static int get_mode() {
     printf("\t%d - Graph dump of questions tree\n", Graph_dump);
     printf("\t%d - Get character's definition\n", Definition);
     printf("\t%d - Get difference in characters definitions\n", Difference);
+    printf("\t%d - Save data base while playing\n", Save);
+    printf("\t%d - Find characters similar to given one\n", Similarity);
 
     int mode = 0;
 
@@ -346,15 +437,15 @@ static Answers get_answer() {
 
     get_user_input(answer);
 
-    if (strcasecmp(answer, "yes") == 0) {
+    if (equal_strings_ignoring_case(answer, "yes")) {
 
         return Yes;
 
-    } else if (strcasecmp(answer, "no") == 0) {
+    } else if (equal_strings_ignoring_case(answer, "no")) {
 
         return No;
 
-    } else if (strcasecmp(answer, "dn") == 0) {
+    } else if (equal_strings_ignoring_case(answer, "dn")) {
 
         return DontKnow;
     }
@@ -372,35 +463,151 @@ static void get_user_input(char *input) {
     *(strchr(input, '\n')) = '\0';
 }
 
-static Tree_node* find_node(Tree_node *node, char *data) {
+// Characters are found by index, lazy tree is searched and read on the way
 
-    assert(node != nullptr);
+static Node_id find_character(Akinator *akinator, char *name) {
+
+    assert(akinator != nullptr);
+    assert(name     != nullptr);
+
+    if (akinator->has_names) {
+        return find_name(&akinator->names, &akinator->tree, name);
+    }
+
+    return find_node(&akinator->tree, akinator->tree.head, name);
+}
+
+static void index_tree(Akinator *akinator) {
+
+    assert(akinator != nullptr);
+
+    if (akinator->has_names && !build_name_index(&akinator->names, &akinator->tree)) {
+
+        printf("Warning: can't index characters - not enought memory, they will be searched\n");
+
+        name_index_dtor(&akinator->names);
+
+        akinator->has_names = false;
+    }
+
+    if (akinator->has_ancestry && !build_ancestry(&akinator->ancestry, &akinator->tree)) {
+
+        printf("Warning: can't index ancestors of nodes - not enought memory\n");
+
+        ancestry_dtor(&akinator->ancestry);
+
+        akinator->has_ancestry = false;
+    }
+
+    // Signatures are built again for the next similarity query
+
+    signatures_dtor(&akinator->signatures);
+
+    akinator->has_signatures = false;
+}
+
+// Names with entered prefix go first, then names with typos. Search is built
+// when unknown name is entered for the first time.
+
+static void suggest_names(Akinator *akinator, const char *name) {
+
+    assert(akinator != nullptr);
+    assert(name     != nullptr);
+
+    if (!akinator->has_names || name[0] == '\0') {
+        return;
+    }
+
+    if (!akinator->has_search) {
+
+        if (!build_name_search(&akinator->search, &akinator->tree)) {
+
+            printf("Warning: can't search similar names - not enought memory\n");
+
+            name_search_dtor(&akinator->search);
+
+            return;
+        }
+
+        akinator->has_search = true;
+    }
+
+    Text_id found  [Max_suggestions] = {};
+    Text_id similar[Max_suggestions] = {};
+
+    size_t n_found   = complete_name     (&akinator->search, &akinator->tree, name, found,   Max_suggestions);
+    size_t n_similar = find_similar_names(&akinator->search, &akinator->tree, name, similar, Max_suggestions);
+
+    for (size_t i = 0; i < n_similar && n_found < Max_suggestions; ++i) {
+
+        size_t j = 0;
+
+        for (; j < n_found && found[j] != similar[i]; ++j);
+
+        if (j == n_found) {
+            found[n_found++] = similar[i];
+        }
+    }
+
+    if (n_found == 0) {
+        return;
+    }
+
+    printf("Maybe you mean ");
+
+    for (size_t i = 0; i < n_found; ++i) {
+        printf((i == 0) ? "%s" : ", %s", get_text(&akinator->tree, found[i]));
+    }
+
+    printf("?\n");
+}
+
+static Node_id find_node(Tree *tree, Node_id node, char *data) {
+
+    assert(tree != nullptr);
+    assert(node != No_node);
+    assert(data != nullptr);
+
+    size_t len = strlen(data);
+
+    return search_subtree(tree, node, data, len, get_folded_hash(data, len));
+}
+
+// Texts are compared by their hashes and lengths first, strings are
+// compared only when they match
+
+static Node_id search_subtree(Tree *tree, Node_id node, const char *data, size_t len, uint32_t hash) {
+
+    assert(tree != nullptr);
+    assert(node != No_node);
     assert(data != nullptr);
 
-    if (strcasecmp(data, node->data) == 0) {
+    expand_node(tree, node);
+
+    if (equal_folded(&tree->strings, tree->nodes[node].text, data, len, hash)) {
         return node;
     }
 
-    if (node->left == nullptr || node->right == nullptr) {
-        return nullptr;
+    if (is_leaf(tree, node)) {
+        return No_node;
     }
 
-    Tree_node *ans = nullptr;
+    Node_id ans = No_node;
 
-    ans = find_node(node->left, data);
+    ans = search_subtree(tree, node_left(tree, node), data, len, hash);
 
-    if (ans != nullptr) {
+    if (ans != No_node) {
         return ans;
     }
 
-    ans = find_node(node->right, data);
+    ans = search_subtree(tree, node_right(tree, node), data, len, hash);
 
-    if (ans != nullptr) {
+    if (ans != No_node) {
 
         return ans;
     }
 
-    return nullptr;
+    return No_node;
 }
 
 static void print_and_read(const char *message, ...) {
@@ -422,7 +629,11 @@ static void print_and_read(const char *message, ...) {
 
 //----------------- EXIT ------------------//
 
-static void save_new_tree(Tree *tree) {
+static void save_new_tree(Akinator *akinator) {
+
+    assert(akinator != nullptr);
+
+    finish_background_save(akinator, true);
 
     printf("Do you wanna save tree before exit? [yes/no]\n");
 
@@ -438,15 +649,219 @@ static void save_new_tree(Tree *tree) {
 
     get_user_input(answer);
 
+    if (start_background_save(akinator, answer)) {
+
+        finish_background_save(akinator, true);
+    }
+}
+
+//---------------- SAVING -----------------//
+
+static void run_save_mode(Akinator *akinator) {
+
+    assert(akinator != nullptr);
+
+    printf("Please, enter name of file for saving:\n");
+
+    char answer[Max_input_len] = {};
+
+    get_user_input(answer);
+
+    if (start_background_save(akinator, answer)) {
+
+        printf("Tree is being saved to %s, let's keep playing\n", answer);
+    }
+}
+
+static void autosave_data_base(Akinator *akinator) {
+
+    assert(akinator != nullptr);
+
+    finish_background_save(akinator, false);
+
+    if (akinator->autosave == 0 || akinator->n_unsaved < akinator->autosave || 
+        akinator->data_base_name == nullptr || akinator->save.is_running) {
+        return;
+    }
+
+    start_background_save(akinator, akinator->data_base_name);
+}
+
+//-------------- LAYOUT ---------------//
+
+// Layout makes no sense for conversions and is impossible for lazy tree which
+// remembers positions of unread nodes by their ids
+
+static Tree_layout get_layout(const CLArgs *args) {
+
+    assert(args != nullptr);
+
+    if (args->convert || args->compact || args->lazy) {
+
+        return No_layout;
+    }
+
+    if (args->layout == nullptr || strcmp(args->layout, "veb") == 0) {
+
+        return Veb_layout;
+    }
+
+    if (strcmp(args->layout, "bfs") == 0) {
 
-    FILE *output = fopen(answer, "w");
+        return Bfs_layout;
+    }
 
-    if (output != nullptr) {
+    if (strcmp(args->layout, "none") != 0) {
 
-        text_database_dump(tree, output);
+        printf("Warning: unknown layout %s, nodes are left in order of reading\n", args->layout);
     }
 
-    fclose(output);
+    return No_layout;
+}
+
+// Tree is laid out at start and then again when new nodes make a noticeable part
+// of it. Nodes can't be moved while tree is being saved by another thread.
+
+// Returns true if nodes got new ids
+
+static bool relayout_akinator_tree(Akinator *akinator, bool is_forced) {
+
+    assert(akinator != nullptr);
+
+    Tree *tree = &akinator->tree;
+
+    if (akinator->layout == No_layout || akinator->save.is_running) {
+
+        return false;
+    }
+
+    if (!is_forced && tree->n_nodes - akinator->n_laid_out <= akinator->n_laid_out / Relayout_growth) {
+
+        return false;
+    }
+
+    bool is_moved = relayout_tree(tree, akinator->layout);
+
+    if (!is_moved) {
+
+        printf("Warning: can't change order of nodes - not enought memory\n");
+    }
+
+    akinator->n_laid_out = tree->n_nodes;
+
+    return is_moved;
+}
+
+// Tree is frozen and dumped by worker thread to a temporary file which
+// replaces the old one. Binary writer can't dump frozen tree, so binary
+// data base is written at once.
+
+static bool start_background_save(Akinator *akinator, const char *file_name) {
+
+    assert(akinator  != nullptr);
+    assert(file_name != nullptr);
+
+    finish_background_save(akinator, true);
+
+    Background_save *save = &akinator->save;
+
+    size_t name_len = strlen(file_name);
+
+    save->file_name = (char*) calloc(name_len + 1, sizeof(char));
+
+    if (save->file_name == nullptr) {
+
+        printf("Sorry, I can't save tree to file %s: not enought memory\n", file_name);
+
+        return false;
+    }
+
+    memcpy(save->file_name, file_name, name_len);
+
+    bool is_data_base = is_data_base_file(akinator, file_name);
+
+    save->journal_size = is_data_base ? get_journal_size(&akinator->journal) : 0;
+    save->n_saved      = is_data_base ? akinator->n_unsaved : 0;
+    save->is_done      = false;
+    save->is_running   = true;
+
+    if (get_data_base_format(file_name) != Binary_data_base && freeze_tree(&akinator->tree)) {
+
+        if (pthread_create(&save->thread, nullptr, save_in_background, akinator) == 0) {
+
+            save->has_thread = true;
+
+            return true;
+        }
+
+        unfreeze_tree(&akinator->tree);
+    }
+
+    save_in_background(akinator);
+
+    return true;
+}
+
+static void* save_in_background(void *context) {
+
+    assert(context != nullptr);
+
+    Akinator *akinator = (Akinator*) context;
+
+    Background_save *save = &akinator->save;
+
+    save->result  = replace_data_base(&akinator->tree, save->file_name, 
+                                                       get_data_base_format(save->file_name));
+    save->is_done = true;
+
+    return nullptr;
+}
+
+static void finish_background_save(Akinator *akinator, bool wait) {
+
+    assert(akinator != nullptr);
+
+    Background_save *save = &akinator->save;
+
+    if (!save->is_running || (!wait && !save->is_done)) {
+        return;
+    }
+
+    if (save->has_thread) {
+
+        pthread_join(save->thread, nullptr);
+
+        unfreeze_tree(&akinator->tree);
+
+        save->has_thread = false;
+    }
+
+    save->is_running = false;
+
+    if (!save->result) {
+
+        printf("Sorry, I can't save tree to file %s\n", save->file_name);
+
+    } else {
+
+        printf("Tree is saved to %s\n", save->file_name);
+
+        // Characters added during saving stay in journal
+
+        if (is_data_base_file(akinator, save->file_name)) {
+
+            akinator->n_unsaved -= save->n_saved;
+
+            if (!trim_journal(&akinator->journal, save->journal_size)) {
+
+                printf("Warning: can't trim journal %s\n", akinator->journal.file_name);
+            }
+        }
+    }
+
+    free(save->file_name);
+
+    save->file_name = nullptr;
 }
 
 //-------------- GUESS MODE ---------------//
@@ -456,7 +871,14 @@ static void run_quess_mode(Akinator *akinator) {
     printf("Quess a character and I will try to guess it.\n"
            "Answer some questions about it, please.\n");
 
-    Tree_node *node = akinator->tree.head;
+    // Questions left by previous game could be moved by relayout since then
+
+    while (akinator->dontknow_nodes.size != 0) {
+
+        StackPop(&akinator->dontknow_nodes);
+    }
+
+    Node_id node = akinator->tree.head;
 
     Answers ans = No;
 
@@ -475,7 +897,7 @@ static void run_quess_mode(Akinator *akinator) {
 
             node = StackPop(&akinator->dontknow_nodes);
 
-            node = node->right;
+            node = node_right(&akinator->tree, node);
 
             continue;
         }
@@ -486,54 +908,55 @@ static void run_quess_mode(Akinator *akinator) {
     }
 }
 
-static Answers ask_questions(Akinator *akinator, Tree_node **node) {
+static Answers ask_questions(Akinator *akinator, Node_id *node) {
 
     assert(akinator != nullptr);
     assert(node != nullptr);
-    assert(*node != nullptr);
+    assert(*node != No_node);
 
-    while ((*node)->left != nullptr && (*node)->right != nullptr)
+    while (!is_leaf(&akinator->tree, expand_node(&akinator->tree, *node)))
     {
         *node = ask_question(akinator, *node);
 
-        assert(*node != nullptr);
+        assert(*node != No_node);
     }
 
-    printf("Your character is %s? [yes/no/dn] (dn = don't know)\n", (*node)->data);
+    printf("Your character is %s? [yes/no/dn] (dn = don't know)\n", 
+                                                     node_text(&akinator->tree, *node));
 
     Answers ans = get_answer();
 
     return ans;
 }
 
-static Tree_node* ask_question(Akinator *akinator, Tree_node *node) {
-    assert(node != nullptr);
+static Node_id ask_question(Akinator *akinator, Node_id node) {
+    assert(node != No_node);
 
-    printf("Your character %s? [yes/no/dn] (dn = don't know)\n", node->data);
+    printf("Your character %s? [yes/no/dn] (dn = don't know)\n", node_text(&akinator->tree, node));
 
     Answers ans = get_answer();
 
     switch (ans) {
         case Yes:
 
-            return node->left;
+            return node_left(&akinator->tree, node);
 
         case No:
 
-            return node->right;
+            return node_right(&akinator->tree, node);
 
         case DontKnow:
 
             StackPush(&akinator->dontknow_nodes, node);
 
-            return node->left;
+            return node_left(&akinator->tree, node);
 
         default:
 
             break;
     }
 
-    return nullptr;
+    return No_node;
 }
 
 static void celebrate_win(Answers ans) {
@@ -549,15 +972,7 @@ static void celebrate_win(Answers ans) {
     }
 }
 
-#define memory_allocate(ptr)                                                     \
-    char *ptr = (char*) calloc(Max_input_len, sizeof(char));                     \
-    if (ptr == nullptr) {                                                        \
-        printf("Sorry, I can't add your character: there is no enougth memory"); \
-        return;                                                                  \
-    }
-
-
-static void add_character(Akinator *akinator, Tree_node *node) {
+static void add_character(Akinator *akinator, Node_id node) {
 
     printf("I'm sorry but i don't know who was guessed. Stupid programm!\n"
            "Can you help me become better by telling who was you character? [yes/no]\n");
@@ -571,27 +986,78 @@ static void add_character(Akinator *akinator, Tree_node *node) {
 
     printf("Thank you! Enter your character's name please\n");
 
-    memory_allocate(new_character_name);
+    char new_character_name[Max_input_len] = {};
+
+    get_text_input(new_character_name);
+
+    const char *old_name = node_text(&akinator->tree, node);
+
+    printf("Please, give the difference between %s and %s. ", old_name, new_character_name);
+    printf("Unlike %s %s...\n", old_name, new_character_name);
+
+    char difference[Max_input_len] = {};
+
+    get_text_input(difference);
+
+    // Texts are kept in tree's storage with the rest of data base
+
+    Text_id name     = store_text(&akinator->tree, new_character_name, strlen(new_character_name));
+    Text_id question = store_text(&akinator->tree, difference,         strlen(difference));
 
-    get_user_input(new_character_name);
+    if (name == No_text || question == No_text ||
+        split_node(&akinator->tree, node, name, question, false) != NO_TREE_ERR) {
+        printf("Sorry, I can't add your character: there is no enougth memory");
+        return;
+    }
+
+    // Old character moves to the right child, new one is the left child
+
+    if (akinator->has_names) {
+
+        Node_id existing = No_node;
+
+        move_name(&akinator->names, &akinator->tree, node, node_right(&akinator->tree, node));
+
+        if (!add_name(&akinator->names, &akinator->tree, node_left(&akinator->tree, node), &existing)) {
+
+            printf("Warning: can't add %s to index - not enought memory\n", new_character_name);
+
+        } else if (existing != No_node) {
+
+            printf("Warning: there is another character named %s, "
+                   "it will be found by its name\n", node_text(&akinator->tree, existing));
+        }
+    }
+
+    if (akinator->has_ancestry &&
+        (!add_ancestry_node(&akinator->ancestry, &akinator->tree, node_left (&akinator->tree, node)) ||
+         !add_ancestry_node(&akinator->ancestry, &akinator->tree, node_right(&akinator->tree, node)))) {
+
+        printf("Warning: can't index ancestors of nodes - not enought memory\n");
+
+        ancestry_dtor(&akinator->ancestry);
 
-    printf("Please, give the difference between %s and %s. ", node->data, new_character_name);
-    printf("Unlike %s %s...\n", node->data, new_character_name);
+        akinator->has_ancestry = false;
+    }
+
+    if (akinator->has_signatures && !split_signature(&akinator->signatures, &akinator->tree, node)) {
 
-    memory_allocate(difference);
+        printf("Warning: can't add %s to similarity search - not enought memory\n", new_character_name);
+    }
 
-    get_user_input(difference);
+    if (akinator->has_search && !add_searched_name(&akinator->search, &akinator->tree, name)) {
 
-    char *old_character = node->data;
+        printf("Warning: can't add %s to search of names - not enought memory\n", new_character_name);
+    }
 
-    init_left_node (&akinator->tree, node, new_character_name);
-    init_right_node(&akinator->tree, node, old_character);
+    if (akinator->data_base_name != nullptr && !write_journal_record(&akinator->journal, &akinator->tree, node)) {
+        printf("Warning: can't write new character to journal %s, "
+               "it will be lost if tree is not saved at exit\n", akinator->journal.file_name);
+    }
 
-    node->data = difference;
+    ++akinator->n_unsaved;
 
-    node->right->is_saved = node->is_saved;
-    node->left->is_saved  = false;
-    node->is_saved        = false;
+    autosave_data_base(akinator);
 
     printf("Thank you for help! Do you want to see new questions tree? [yes/no]\n");
 
@@ -605,7 +1071,19 @@ static void add_character(Akinator *akinator, Tree_node *node) {
     run_graph_dump(&akinator->tree);
 }
 
-#undef memory_allocate
+// Quotes end texts in data base and journal, so texts with them are asked again
+
+static void get_text_input(char *input) {
+    assert(input != nullptr);
+
+    get_user_input(input);
+
+    while (strchr(input, '"') != nullptr) {
+        printf("Sorry, I can't remember texts with quotes. Please, enter it without them\n");
+
+        get_user_input(input);
+    }
+}
 
 //--------------- GRAPHIC DUMP ------------//
 
@@ -627,35 +1105,42 @@ static void run_graph_dump(Tree *tree) {
 
 //------------- DEFINITION MODE -----------//
 
-#define Print_property(comma)                                      \
-        if (found == found->parent->left) {                        \
-            print_and_read("%s" comma, found->parent->data);       \
-        } else {                                                   \
-            print_and_read("not %s" comma, found->parent->data);   \
+#define Print_property(comma)                                                          \
+        if (is_left_child(tree, found)) {                                              \
+            print_and_read("%s" comma,     node_text(tree, node_parent(tree, found))); \
+        } else {                                                                       \
+            print_and_read("not %s" comma, node_text(tree, node_parent(tree, found))); \
         }
 
-static void run_definition_mode(Tree *tree) {
+static void run_definition_mode(Akinator *akinator) {
+    assert(akinator != nullptr);
+
+    Tree *tree = &akinator->tree;
+
     printf("Enter name of character that i need to define:\n");
 
     char name[Max_input_len] = {};
 
     get_user_input(name);
 
-    Tree_node *found = find_node(tree->head, name);
+    Node_id found = find_character(akinator, name);
 
-    if (found == nullptr) {
-        printf("Sorry, I can't find this character.\n"
-               "You can add it using guess mode by answering guestions about it.\n");
+    if (found == No_node) {
+        printf("Sorry, I can't find this character.\n");
+
+        suggest_names(akinator, name);
+
+        printf("You can add it using guess mode by answering guestions about it.\n");
         return;
     }
 
-    print_and_read("%s ", found->data);
+    print_and_read("%s ", node_text(tree, found));
 
-    while (found->parent->parent != nullptr) {
+    while (node_parent(tree, node_parent(tree, found)) != No_node) {
 
         Print_property(", ");
 
-        found = found->parent;
+        found = node_parent(tree, found);
     }
 
     Print_property(".\n");
@@ -665,8 +1150,8 @@ static void run_definition_mode(Tree *tree) {
 
 //------------- DIFFERENCE MODE -----------//
 
-static void run_diff_mode(Tree *tree) {
-    assert(tree != nullptr);
+static void run_diff_mode(Akinator *akinator) {
+    assert(akinator != nullptr);
 
     printf("Give me two characters and I will say what do they have in common "
            "and what differences do they have. Enter first character:...\n");
@@ -680,45 +1165,42 @@ static void run_diff_mode(Tree *tree) {
 
     get_user_input(name2);
 
-    Tree_node *node1 = find_node(tree->head, name1);
-    Tree_node *node2 = find_node(tree->head, name2);
+    Node_id node1 = find_character(akinator, name1);
+    Node_id node2 = find_character(akinator, name2);
 
-    if (!charact_corr_checkup(name1, node1) || !charact_corr_checkup(name2, node2)) {
+    if (!charact_corr_checkup(akinator, name1, node1) || !charact_corr_checkup(akinator, name2, node2)) {
         return;
     }
 
-    if (strcasecmp(name1, name2) == 0) {
+    if (equal_strings_ignoring_case(name1, name2)) {
         printf("Characters are the same. You can get their definition in definition mode\n");
         return;
     }
 
-    Stack stk1 = {};
-    Stack stk2 = {};
+    Text_buffer text = {};
 
-    StackCtr(&stk1, 0);
-    StackCtr(&stk2, 0);
+    write_difference(&text, &akinator->tree, &akinator->ancestry, name1, node1, name2, node2);
 
-    get_path(node1, &stk1);
-    get_path(node2, &stk2);
-
-    if (!print_commons(name1, name2, &stk1, &stk2)) {
-        return;
+    if (!text.is_ok) {
+        printf("Sorry, I can't compare characters: not enought memory\n");
+    } else {
+        fputs(text.data, stdout);
     }
 
-    print_difference(name1, name2, &stk1, &stk2);
-
-    StackDestr(&stk1);
-    StackDestr(&stk2);
+    text_buffer_dtor(&text);
 }
 
-static bool charact_corr_checkup(const char *name, const Tree_node *node) {
-    if (node == nullptr) {
-        printf("Sorry, I don't know character %s. :(\n"
-               "You can add it by answering questions about it in guess mode.\n", name);
+static bool charact_corr_checkup(Akinator *akinator, const char *name, Node_id node) {
+    if (node == No_node) {
+        printf("Sorry, I don't know character %s. :(\n", name);
+
+        suggest_names(akinator, name);
+
+        printf("You can add it by answering questions about it in guess mode.\n");
         return false;
     }
 
-    if (node->left != nullptr) {
+    if (node_left(&akinator->tree, node) != No_node) {
         printf("Entered name %s is not a characters, but a property of character.\n", name);
         return false;
     }
@@ -726,184 +1208,228 @@ static bool charact_corr_checkup(const char *name, const Tree_node *node) {
     return true;
 }
 
-static void get_path(Tree_node *node, Stack *stk) {
+//------------ SIMILARITY MODE ------------//
 
-    assert(node != nullptr);
-    assert(stk != nullptr);
+static void run_similarity_mode(Akinator *akinator) {
+    assert(akinator != nullptr);
 
-    while (node->parent != nullptr) {
+    Tree *tree = &akinator->tree;
 
-        StackPush(stk, node);
+    printf("Enter name of character and I will find characters which answer questions like it:...\n");
 
-        node = node->parent;
+    char name[Max_input_len] = {};
+
+    get_user_input(name);
+
+    Node_id node = find_character(akinator, name);
+
+    if (!charact_corr_checkup(akinator, name, node)) {
+        return;
     }
-}
 
-#define Print_property()                                         \
-        if (node1->parent->left == node1) {                      \
-            printf("%s.",     node1->parent->parent->data);      \
-        } else {                                                 \
-            printf("not %s.", node1->parent->parent->data);      \
-        }
+    // Signatures of lazy tree would read the whole data base
+
+    if (!akinator->has_names) {
+        printf("Sorry, similar characters are found only in fully read data base.\n");
+        return;
+    }
 
-static bool print_commons(const char *name1, const char *name2, Stack *stk1, Stack *stk2) {
+    if (!akinator->has_signatures) {
 
-    assert(name1 != nullptr);
-    assert(name2 != nullptr);
-    assert(stk1  != nullptr);
-    assert(stk2  != nullptr);
+        if (!build_signatures(&akinator->signatures, tree)) {
 
-    if (stk1->size < 1 && stk2->size < 1) {
-        printf("Characters %s and %s have nothing in common.\n", name1, name2);
-        return true;
+            printf("Sorry, I can't find similar characters: not enought memory\n");
+
+            signatures_dtor(&akinator->signatures);
+
+            return;
+        }
+
+        akinator->has_signatures = true;
     }
 
-    Tree_node *node1 = StackPop(stk1);
-    Tree_node *node2 = StackPop(stk2);
+    Similar_character found[Max_similar] = {};
 
-    if (node1 != node2) {
+    size_t n_found = find_similar_characters(&akinator->signatures, tree, node, found, Max_similar);
 
-        printf("Characters %s and %s have nothing in common.\n", name1, name2);
+    if (n_found == 0) {
+        printf("Sorry, I don't know characters similar to %s.\n", name);
+        return;
+    }
 
-        StackPush(stk1, node1);
-        StackPush(stk2, node2);
+    printf("Characters similar to %s:\n", name);
 
-        return true;
+    for (size_t i = 0; i < n_found; ++i) {
+        printf("\t%s - %u different answers on %u common questions\n", node_text(tree, found[i].node),
+                                                                     found[i].n_differ, found[i].n_common);
     }
+}
 
-    printf("%s like %s ", name1, name2);
+/*-------------------------------- OTHER STATIC FUNCTIONS ----------------------------------------*/
 
-    node1 = StackPop(stk1);
-    node2 = StackPop(stk2);
+static bool get_data_base(Akinator *akinator, const char *input) {
+    assert(akinator != nullptr);
+    assert(input    != nullptr);
 
-    if (node1 != node2) {
-        Print_property();
+    akinator->data_base = map_file(input, &akinator->data_base_size);
 
-        StackPush(stk1, node1);
-        StackPush(stk2, node2);
+    if (akinator->data_base == nullptr) {
+        printf("Error: can't run akinator - can't open data base file %s\n", input);
+        return false;
+    }
 
+    if (!is_compressed_data_base(akinator->data_base, akinator->data_base_size)) {
         return true;
     }
 
-    while (node1 == node2) { 
-        if (!print_common_prop(stk1, stk2, &node1, &node2)) {
-            break;
-        }
-    }
+    // Compressed data base is unpacked and then parsed as usual
 
-    Print_property();
+    size_t text_size = 0;
 
-    printf("\n");
+    char *text = decompress_data_base(akinator->data_base, akinator->data_base_size, &text_size);
 
-    StackPush(stk1, node1);
-    StackPush(stk2, node2);
+    unmap_file(akinator->data_base, akinator->data_base_size);
 
-    return true;
-}
+    akinator->data_base      = text;
+    akinator->data_base_size = text_size;
 
-#undef Print_property
+    return text != nullptr;
+}
 
-#define Print_property(node_comp, node_pr, comma)                   \
-        if (node_comp->parent->left == node_comp) {                 \
-            printf("%s" comma,     node_pr->parent->data);          \
-        } else {                                                    \
-            printf("not %s" comma, node_pr->parent->data);          \
-        }
+static bool stream_data_base(Akinator *akinator, const char *input) {
+    assert(akinator != nullptr);
+    assert(input    != nullptr);
 
-static bool print_common_prop(Stack *stk1, Stack *stk2, Tree_node **node1, Tree_node **node2) {
+    bool is_stdin = (strcmp(input, "-") == 0);
 
-    assert(stk1   != nullptr);
-    assert(stk2   != nullptr);
-    assert(*node1 != nullptr);
-    assert(*node2 != nullptr);
-    
-    if (stk1->size == 0 || stk2->size == 0) {
-        Print_property((*node1), ((*node1)->parent), ".");
+    FILE *stream = is_stdin ? stdin : fopen(input, "rb");
 
+    if (stream == nullptr) {
+        printf("Error: can't run akinator - can't open data base file %s\n", input);
         return false;
     }
 
-    Print_property((*node1)->parent, (*node1)->parent, ", ");
+    bool result = stream_tree(&akinator->tree, stream, Stream_chunk_size);
 
-    *node1 = StackPop(stk1);
-    *node2 = StackPop(stk2);
+    if (!is_stdin) {
+        fclose(stream);
+    }
 
-    return true;
+    return result;
 }
 
-#undef Print_property
+static bool write_data_base(Tree *tree, const char *output, Data_base_formats format) {
+    assert(tree   != nullptr);
+    assert(output != nullptr);
+
+    FILE *stream = fopen(output, "wb");
 
-static void print_difference(const char *name1, const char *name2, Stack *stk1, Stack *stk2) {
-    assert(name1 != nullptr);
-    assert(name2 != nullptr);
-    assert(stk1  != nullptr);
-    assert(stk2  != nullptr);
+    if (stream == nullptr) {
+        return false;
+    }
 
-    assert(stk1->size != 0);
-    assert(stk2->size != 0);
+    bool result = true;
 
-    if (stk1->size > 0) {
-        printf("Unlike %s, %s ", name2, name1);
+    switch (format) {
+        case Binary_data_base:
+            result = write_binary_tree(tree, stream);
+            break;
+
+        case Compressed_data_base:
+            result = write_compressed_tree(tree, stream);
+            break;
 
-        print_properties(stk1, name1);
+        case Text_data_base:
+        default:
+            result = text_database_dump(tree, stream);
+            break;
     }
 
-    if (stk2->size > 0) {
-        printf("At the same time %s ", name2);
+    if (fflush(stream) != 0 || fsync(fileno(stream)) != 0) {
+        result = false;
+    }
 
-        print_properties(stk2, name2);
+    if (fclose(stream) != 0) {
+        result = false;
     }
 
+    return result;
 }
 
-#define Print_property(comma)                            \
-        if (node->parent->left == node) {                \
-            printf(comma "%s",     node->parent->data);  \
-        } else {                                         \
-            printf(comma "not %s", node->parent->data);  \
-        }
+// New data base is written next to the old one and replaces it atomically
 
-static void print_properties(Stack *stk, const char *name) {
-    assert(stk  != nullptr);
-    assert(name != nullptr);
+static bool replace_data_base(Tree *tree, const char *file_name, Data_base_formats format) {
+    assert(tree      != nullptr);
+    assert(file_name != nullptr);
 
-    assert(stk->size > 0);
+    size_t name_len = strlen(file_name);
 
-    Tree_node *node = StackPop(stk);
+    char *temp_name = (char*) calloc(name_len + sizeof(Temp_extension), sizeof(char));
 
-    Print_property("");
+    if (temp_name == nullptr) {
+        return false;
+    }
 
-    while (stk->size > 0) {
-        node = StackPop(stk);
+    memcpy(temp_name, file_name, name_len);
+    memcpy(temp_name + name_len, Temp_extension, sizeof(Temp_extension));
 
-        Print_property(", ");
+    bool result = write_data_base(tree, temp_name, format) && rename(temp_name, file_name) == 0;
+
+    if (!result) {
+        remove(temp_name);
     }
 
-    printf(".\n");
+    free(temp_name);
+
+    return result;
 }
 
-#undef Print_property
+static bool is_data_base_file(const Akinator *akinator, const char *file_name) {
+    assert(akinator  != nullptr);
+    assert(file_name != nullptr);
 
-/*-------------------------------- OTHER STATIC FUNCTIONS ----------------------------------------*/
+    return akinator->data_base_name != nullptr && strcmp(file_name, akinator->data_base_name) == 0;
+}
 
-#define memory_allocate(ptr, size, type)                            \
-    ptr = (type*) calloc(size, sizeof(type));                       \
-    if (ptr == nullptr) {                                           \
-        printf("Error: can't run akinator - not enought memory\n"); \
-        return false;                                               \
+// Format of data base is chosen by extension of file name
+
+static Data_base_formats get_data_base_format(const char *file_name) {
+    assert(file_name != nullptr);
+
+    if (has_extension(file_name, Akb_extension)) {
+        return Binary_data_base;
     }
 
-static bool get_data_base(Akinator *akinator, const char *input) {
+    if (has_extension(file_name, Akz_extension)) {
+        return Compressed_data_base;
+    }
+
+    return Text_data_base;
+}
+
+static bool has_extension(const char *file_name, const char *extension) {
+    assert(file_name != nullptr);
+    assert(extension != nullptr);
+
+    size_t name_len = strlen(file_name);
+    size_t ext_len  = strlen(extension);
+
+    return name_len >= ext_len && equal_ignoring_case(file_name + name_len - ext_len, extension, ext_len);
+}
+
+static bool open_data_base_journal(Akinator *akinator, const char *input) {
     assert(akinator != nullptr);
     assert(input    != nullptr);
 
-    size_t amount_of_symbols = count_elements_in_file(input);
-
-    memory_allocate(akinator->data_base, amount_of_symbols, char);
+    if (!open_journal(&akinator->journal, input)) {
+        printf("Error: can't run akinator - not enought memory\n");
+        return false;
+    }
 
-    amount_of_symbols = read_file(akinator->data_base, amount_of_symbols, input);
+    if (!replay_journal(&akinator->journal, &akinator->tree)) {
+        printf("Error: can't read journal %s\n", akinator->journal.file_name);
+        return false;
+    }
 
     return true;
 }
-
-#undef memory_allocate
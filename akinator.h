@@ -3,14 +3,61 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
+
+#include <atomic>
 
 #include "Libs/Stack/stack.h"
-#include "Libs/Stack/stack_logs.h"
+#include "Libs/file_reading.hpp"
+#include "Database/lazy_reading.h"
+#include "Database/journal.h"
+#include "Tree/layout.h"
+#include "Tree/name_index.h"
+#include "Tree/name_search.h"
+#include "Tree/ancestry.h"
+#include "Tree/signatures.h"
+
+// Questions answered "don't know" are rarely more than few in a game, so
+// they are kept without allocations
+
+const size_t Dontknow_inline_size = 16;
+
+typedef Stack<Node_id, Dontknow_inline_size> Node_stack;
+
+// Tree is saved by worker thread while game goes on
+
+struct Background_save {
+    pthread_t         thread       = {};
+    bool              has_thread   = false;
+    bool              is_running   = false;
+    std::atomic<bool> is_done      = false;
+    bool              result       = false;
+    char*             file_name    = nullptr;
+    size_t            journal_size = 0;     // journal records merged into saved data base
+    size_t            n_saved      = 0;     // characters added since previous save
+};
 
 struct Akinator {
-    Tree  tree           = {};
-    Stack dontknow_nodes = {};
-    char* data_base      = nullptr;
+    Tree            tree           = {};
+    Node_stack      dontknow_nodes = {};
+    const char*     data_base_name = nullptr;
+    char*           data_base      = nullptr;
+    size_t          data_base_size = 0;
+    Lazy_text       lazy           = {};
+    Journal         journal        = {};
+    Background_save save           = {};
+    size_t          autosave       = 0;     // new characters between autosaves, 0 - off
+    size_t          n_unsaved      = 0;
+    Tree_layout     layout         = No_layout;
+    size_t          n_laid_out     = 0;     // nodes in tree after last relayout
+    Name_index      names          = {};
+    bool            has_names      = false; // lazy tree is searched without index
+    Name_search     search         = {};
+    bool            has_search     = false; // search is built for the first unknown name
+    Ancestry        ancestry       = {};
+    bool            has_ancestry   = false; // lazy tree is lifted by parents
+    Signatures      signatures     = {};
+    bool            has_signatures = false; // signatures are built for the first similarity query
 };
 
 enum Game_modes {
@@ -19,6 +66,14 @@ enum Game_modes {
     Graph_dump,
     Definition,
     Difference,
+    Save,
+    Similarity,
+};
+
+enum Data_base_formats {
+    Text_data_base = 0,
+    Binary_data_base,
+    Compressed_data_base,
 };
 
 enum Answers {
@@ -27,9 +82,17 @@ enum Answers {
     Yes      =  1,
 };
 
-const char* get_input_name(int argc, const char **argv);
+CLArgs get_akinator_args(int argc, const char **argv);
+
+bool init_akinator(Akinator *akinator, const CLArgs *args);
+
+bool convert_data_base(Akinator *akinator, const char *output);
+
+bool compact_data_base(Akinator *akinator);
+
+// Queries of file are answered without game, see Queries/batch_queries.h
 
-bool init_akinator(Akinator *akinator, const char *input_filename);
+bool run_batch_queries(Akinator *akinator, const char *queries, const char *output, size_t n_threads);
 
 void run_akinator(Akinator *akinator);
 
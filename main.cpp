@@ -2,14 +2,38 @@
 #include "Tree/tree.h"
 
 int main(int argc, const char **argv) {
-    const char *input_filename = get_input_name(argc, argv);
+    CLArgs args = get_akinator_args(argc, argv);
 
     Akinator akinator = {};
 
-    if (!init_akinator(&akinator, input_filename)) {
+    if (!init_akinator(&akinator, &args)) {
         return -1;
     }
 
+    if (args.compact) {
+        int result = compact_data_base(&akinator) ? 0 : -1;
+
+        akinator_dtor(&akinator);
+
+        return result;
+    }
+
+    if (args.convert) {
+        int result = convert_data_base(&akinator, args.output) ? 0 : -1;
+
+        akinator_dtor(&akinator);
+
+        return result;
+    }
+
+    if (args.queries != nullptr) {
+        int result = run_batch_queries(&akinator, args.queries, args.output, args.threads) ? 0 : -1;
+
+        akinator_dtor(&akinator);
+
+        return result;
+    }
+
     run_akinator(&akinator);
 
     akinator_dtor(&akinator);